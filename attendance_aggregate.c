@@ -0,0 +1,521 @@
+#include "attendance_aggregate.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define AGGREGATE_BLOCK 2048                /* rows per vectorized block */
+#define AGGREGATE_OPEN UINT32_MAX           /* duration of records without a usable punch out */
+#define AGGREGATE_PARTITIONS_PER_THREAD 4   /* spare partitions to balance skewed employees */
+#define AGGREGATE_PARTITION_ROWS 32768      /* target partition size; its radix sort stays in cache */
+#define AGGREGATE_MAX_PARTITIONS 65536
+#define AGGREGATE_MIN_ROWS_PER_THREAD 65536
+#define AGGREGATE_MAX_OFFSET_MIN (24 * 60)
+#define SECONDS_PER_DAY 86400
+/* Keeps punch_in + offset + one day of bias inside uint32_t for block_days() */
+#define AGGREGATE_MAX_PUNCH_IN (UINT32_MAX - 2 * SECONDS_PER_DAY)
+
+/**
+ * One record reduced to what the totals need. The key orders by employee,
+ * then punch in, so a partition sorts with a plain integer radix sort.
+ */
+typedef struct {
+    uint64_t key;       /* biased emp_number << 32 | punch_in */
+    uint32_t duration;  /* seconds, AGGREGATE_OPEN if the record is open */
+    int32_t day;
+} HoursItem;
+
+typedef struct {
+    const AttendanceColumns *columns;
+    int threads;
+    size_t partitions;
+    int32_t min_emp;            /* partition p holds a contiguous emp_number range */
+    uint64_t partition_scale;
+    int32_t *thread_min_emp;    /* per thread */
+    int32_t *thread_max_emp;
+    HoursItem *items;           /* grouped by partition */
+    HoursItem *scratch;         /* radix sort buffer, same layout */
+    size_t *cursors;            /* threads x partitions: counts, then scatter positions */
+    size_t *partition_start;    /* partitions + 1 */
+    size_t *skipped;            /* per thread */
+    WorkedDay *days;            /* partition p writes from partition_start[p] on */
+    size_t *partition_day_count;
+    int64_t daily_threshold_s;
+    atomic_size_t next_partition;
+} AggregateJob;
+
+typedef enum {
+    PHASE_RANGE = 0,
+    PHASE_COUNT,
+    PHASE_SCATTER,
+    PHASE_SUMMARIZE
+} AggregatePhase;
+
+typedef struct {
+    AggregateJob *job;
+    int index;
+    AggregatePhase phase;
+} AggregateWorker;
+
+static uint64_t item_key(int32_t emp_number, int64_t punch_in) {
+    return ((uint64_t)((uint32_t)emp_number ^ 0x80000000u) << 32) | (uint64_t)punch_in;
+}
+
+static int32_t key_emp_number(uint64_t key) {
+    return (int32_t)((uint32_t)(key >> 32) ^ 0x80000000u);
+}
+
+static int punch_usable(int64_t punch_in, int16_t offset) {
+    return (uint64_t)punch_in <= AGGREGATE_MAX_PUNCH_IN &&
+           offset >= -AGGREGATE_MAX_OFFSET_MIN && offset <= AGGREGATE_MAX_OFFSET_MIN;
+}
+
+static size_t partition_of(const AggregateJob *job, int32_t emp_number) {
+    uint64_t position = (uint64_t)((int64_t)emp_number - job->min_emp);
+    return (size_t)((position * job->partition_scale) >> 32);
+}
+
+/* ---- Vectorizable column kernels ---- */
+
+/* Written without early exits and with one unsigned compare per bound so
+ * that GCC and Clang turn them into SIMD loops (see CMakeLists.txt) */
+
+static void emp_range(const int32_t *restrict emp_number, size_t count, int32_t *min_emp, int32_t *max_emp) {
+    int32_t low = *min_emp;
+    int32_t high = *max_emp;
+
+    for (size_t j = 0; j < count; j++) {
+        low = emp_number[j] < low ? emp_number[j] : low;
+        high = emp_number[j] > high ? emp_number[j] : high;
+    }
+    *min_emp = low;
+    *max_emp = high;
+}
+
+static void block_durations(const int64_t *restrict punch_in, const int64_t *restrict punch_out,
+                            size_t count, uint32_t *restrict duration) {
+    for (size_t j = 0; j < count; j++) {
+        /* Negative durations wrap to huge values and count as open */
+        uint64_t seconds = (uint64_t)(punch_out[j] - punch_in[j]);
+        duration[j] = punch_out[j] != 0 && seconds < AGGREGATE_OPEN ? (uint32_t)seconds : AGGREGATE_OPEN;
+    }
+}
+
+static void block_days(const int64_t *restrict punch_in, const int16_t *restrict offset,
+                       size_t count, int32_t *restrict day) {
+    for (size_t j = 0; j < count; j++) {
+        /* 32-bit unsigned math; the one day bias keeps negative offsets on 1970-01-01 in range */
+        uint32_t local = (uint32_t)punch_in[j] + (uint32_t)(offset[j] * 60 + SECONDS_PER_DAY);
+        day[j] = (int32_t)(local / SECONDS_PER_DAY) - 1;
+    }
+}
+
+/* ---- Phases ---- */
+
+static void worker_range(const AggregateJob *job, int index, size_t *lo, size_t *hi) {
+    size_t count = job->columns->count;
+    *lo = count * (size_t)index / (size_t)job->threads;
+    *hi = count * (size_t)(index + 1) / (size_t)job->threads;
+}
+
+/**
+ * Find the employee number range of this worker's rows
+ */
+static void find_emp_range(AggregateJob *job, int index) {
+    size_t lo, hi;
+
+    worker_range(job, index, &lo, &hi);
+    job->thread_min_emp[index] = INT32_MAX;
+    job->thread_max_emp[index] = INT32_MIN;
+    emp_range(job->columns->emp_number + lo, hi - lo, &job->thread_min_emp[index], &job->thread_max_emp[index]);
+}
+
+/**
+ * Count this worker's rows per partition
+ */
+static void count_range(AggregateJob *job, int index) {
+    const AttendanceColumns *columns = job->columns;
+    size_t *counts = job->cursors + (size_t)index * job->partitions;
+    size_t lo, hi;
+
+    worker_range(job, index, &lo, &hi);
+    for (size_t i = lo; i < hi; i++) {
+        if (!punch_usable(columns->punch_in[i], columns->punch_in_offset[i])) {
+            job->skipped[index]++;
+            continue;
+        }
+        counts[partition_of(job, columns->emp_number[i])]++;
+    }
+}
+
+/**
+ * Reduce this worker's rows to HoursItems and move them into their partitions
+ */
+static void scatter_range(AggregateJob *job, int index) {
+    const AttendanceColumns *columns = job->columns;
+    size_t *cursor = job->cursors + (size_t)index * job->partitions;
+    uint32_t duration[AGGREGATE_BLOCK];
+    int32_t day[AGGREGATE_BLOCK];
+    size_t lo, hi;
+
+    worker_range(job, index, &lo, &hi);
+    for (size_t base = lo; base < hi; base += AGGREGATE_BLOCK) {
+        size_t count = hi - base < AGGREGATE_BLOCK ? hi - base : AGGREGATE_BLOCK;
+        block_durations(columns->punch_in + base, columns->punch_out + base, count, duration);
+        block_days(columns->punch_in + base, columns->punch_in_offset + base, count, day);
+
+        for (size_t j = 0; j < count; j++) {
+            int64_t punch_in = columns->punch_in[base + j];
+            if (!punch_usable(punch_in, columns->punch_in_offset[base + j])) {
+                continue;
+            }
+            int32_t emp_number = columns->emp_number[base + j];
+            HoursItem *item = &job->items[cursor[partition_of(job, emp_number)]++];
+            item->key = item_key(emp_number, punch_in);
+            item->duration = duration[j];
+            item->day = day[j];
+        }
+    }
+}
+
+/**
+ * LSD radix sort by key, one byte per pass; passes where every key has the
+ * same byte (high employee bits, the top of punch in) are skipped
+ */
+static void radix_sort(HoursItem *items, HoursItem *scratch, size_t count) {
+    size_t histogram[8][256];
+    HoursItem *src = items;
+    HoursItem *dst = scratch;
+
+    if (count < 2) {
+        return;
+    }
+    memset(histogram, 0, sizeof(histogram));
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = items[i].key;
+        for (int pass = 0; pass < 8; pass++) {
+            histogram[pass][(key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    for (int pass = 0; pass < 8; pass++) {
+        int shift = pass * 8;
+        size_t *buckets = histogram[pass];
+        if (buckets[(src[0].key >> shift) & 0xff] == count) {
+            continue;
+        }
+
+        size_t position = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t bucket = buckets[b];
+            buckets[b] = position;
+            position += bucket;
+        }
+        for (size_t i = 0; i < count; i++) {
+            dst[buckets[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+
+        HoursItem *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != items) {
+        memcpy(items, src, count * sizeof(HoursItem));
+    }
+}
+
+/**
+ * Walk one sorted partition and emit a WorkedDay per run of (employee, day).
+ * There are never more days than records, so the output needs no bounds
+ * checks. Overlaps are tracked per employee across days, so a shift starting
+ * before the previous night shift ended is still caught.
+ * @param unsorted Set if an employee's days came out of order
+ * @return Number of days written
+ */
+static size_t summarize_partition(const HoursItem *items, size_t count, WorkedDay *days, int *unsorted) {
+    size_t day_count = 0;
+    WorkedDay *current = NULL;
+    int32_t emp_number = 0;
+    int64_t covered_until = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const HoursItem *item = &items[i];
+        int32_t item_emp = key_emp_number(item->key);
+        int64_t punch_in = (int64_t)(item->key & 0xffffffffu);
+
+        if (current == NULL || item_emp != emp_number) {
+            emp_number = item_emp;
+            covered_until = 0;
+            current = NULL;
+        }
+        if (current == NULL || current->day != item->day) {
+            /* A later punch in with a different UTC offset can fall on an earlier local day */
+            if (current != NULL && item->day < current->day) {
+                *unsorted = 1;
+            }
+            current = &days[day_count++];
+            memset(current, 0, sizeof(*current));
+            current->emp_number = emp_number;
+            current->day = item->day;
+        }
+
+        current->records++;
+        if (item->duration == AGGREGATE_OPEN) {
+            current->open_records++;
+            continue;
+        }
+
+        int64_t punch_out = punch_in + item->duration;
+        current->worked_s += item->duration;
+        if (punch_in < covered_until) {
+            current->overlaps++;
+            current->overlap_s += (punch_out < covered_until ? punch_out : covered_until) - punch_in;
+        }
+        if (punch_out > covered_until) {
+            covered_until = punch_out;
+        }
+    }
+    return day_count;
+}
+
+static int compare_worked_day(const void *a, const void *b) {
+    const WorkedDay *left = (const WorkedDay *)a;
+    const WorkedDay *right = (const WorkedDay *)b;
+
+    if (left->emp_number != right->emp_number) {
+        return left->emp_number < right->emp_number ? -1 : 1;
+    }
+    return (left->day > right->day) - (left->day < right->day);
+}
+
+/**
+ * Sort the days of a partition that came out of order and fold the
+ * duplicate (employee, day) runs
+ * @return Number of days left
+ */
+static size_t fold_days(WorkedDay *days, size_t total) {
+    size_t count = 0;
+
+    qsort(days, total, sizeof(WorkedDay), compare_worked_day);
+    for (size_t i = 0; i < total; i++) {
+        WorkedDay *last = count > 0 ? &days[count - 1] : NULL;
+        if (last != NULL && last->emp_number == days[i].emp_number && last->day == days[i].day) {
+            last->records += days[i].records;
+            last->open_records += days[i].open_records;
+            last->overlaps += days[i].overlaps;
+            last->worked_s += days[i].worked_s;
+            last->overlap_s += days[i].overlap_s;
+        } else {
+            days[count++] = days[i];
+        }
+    }
+    return count;
+}
+
+static void summarize_partitions(AggregateJob *job) {
+    size_t partition;
+
+    while ((partition = atomic_fetch_add(&job->next_partition, 1)) < job->partitions) {
+        size_t start = job->partition_start[partition];
+        size_t count = job->partition_start[partition + 1] - start;
+        WorkedDay *days = job->days + start;
+        int unsorted = 0;
+
+        radix_sort(job->items + start, job->scratch + start, count);
+        size_t day_count = summarize_partition(job->items + start, count, days, &unsorted);
+        if (unsorted) {
+            day_count = fold_days(days, day_count);
+        }
+        for (size_t i = 0; i < day_count; i++) {
+            int64_t overtime = days[i].worked_s - job->daily_threshold_s;
+            days[i].overtime_s = overtime > 0 ? overtime : 0;
+        }
+        job->partition_day_count[partition] = day_count;
+    }
+}
+
+static void *aggregate_worker(void *data) {
+    AggregateWorker *worker = (AggregateWorker *)data;
+
+    switch (worker->phase) {
+    case PHASE_RANGE:
+        find_emp_range(worker->job, worker->index);
+        break;
+    case PHASE_COUNT:
+        count_range(worker->job, worker->index);
+        break;
+    case PHASE_SCATTER:
+        scatter_range(worker->job, worker->index);
+        break;
+    case PHASE_SUMMARIZE:
+        summarize_partitions(worker->job);
+        break;
+    }
+    return NULL;
+}
+
+/**
+ * Run one phase on every worker; the calling thread is worker 0 and any
+ * worker whose thread cannot be created runs inline
+ */
+static void run_phase(AggregateJob *job, AggregatePhase phase) {
+    AggregateWorker workers[AGGREGATE_MAX_THREADS];
+    pthread_t thread_ids[AGGREGATE_MAX_THREADS];
+    int started[AGGREGATE_MAX_THREADS];
+
+    for (int t = 0; t < job->threads; t++) {
+        workers[t].job = job;
+        workers[t].index = t;
+        workers[t].phase = phase;
+        started[t] = t > 0 && pthread_create(&thread_ids[t], NULL, aggregate_worker, &workers[t]) == 0;
+    }
+    for (int t = 0; t < job->threads; t++) {
+        if (!started[t]) {
+            aggregate_worker(&workers[t]);
+        }
+    }
+    for (int t = 1; t < job->threads; t++) {
+        if (started[t]) {
+            pthread_join(thread_ids[t], NULL);
+        }
+    }
+}
+
+/**
+ * Close the gaps between the partitions' days; partitions cover ascending
+ * employee ranges, so the result is ordered without a global sort
+ */
+static size_t compact_days(AggregateJob *job) {
+    size_t position = 0;
+
+    for (size_t p = 0; p < job->partitions; p++) {
+        size_t count = job->partition_day_count[p];
+        if (count > 0 && position != job->partition_start[p]) {
+            memmove(job->days + position, job->days + job->partition_start[p], count * sizeof(WorkedDay));
+        }
+        position += count;
+    }
+    return position;
+}
+
+static int pick_threads(int requested, size_t rows) {
+    int threads = requested;
+
+    if (threads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+    if (threads > AGGREGATE_MAX_THREADS) {
+        threads = AGGREGATE_MAX_THREADS;
+    }
+    size_t useful = rows / AGGREGATE_MIN_ROWS_PER_THREAD;
+    if ((size_t)threads > useful) {
+        threads = useful > 0 ? (int)useful : 1;
+    }
+    return threads;
+}
+
+int attendance_aggregate_hours(const AttendanceColumns *columns, int64_t daily_threshold_s, int threads,
+                               WorkedHours *hours) {
+    AggregateJob job;
+    int result = -1;
+
+    memset(hours, 0, sizeof(*hours));
+    memset(&job, 0, sizeof(job));
+    job.columns = columns;
+    job.threads = pick_threads(threads, columns->count);
+    job.partitions = columns->count / AGGREGATE_PARTITION_ROWS;
+    if (job.partitions < (size_t)job.threads * AGGREGATE_PARTITIONS_PER_THREAD) {
+        job.partitions = (size_t)job.threads * AGGREGATE_PARTITIONS_PER_THREAD;
+    }
+    if (job.partitions > AGGREGATE_MAX_PARTITIONS) {
+        job.partitions = AGGREGATE_MAX_PARTITIONS;
+    }
+    atomic_init(&job.next_partition, 0);
+    job.daily_threshold_s = daily_threshold_s;
+
+    job.cursors = (size_t *)calloc((size_t)job.threads * job.partitions, sizeof(size_t));
+    job.partition_start = (size_t *)calloc(job.partitions + 1, sizeof(size_t));
+    job.skipped = (size_t *)calloc((size_t)job.threads, sizeof(size_t));
+    job.partition_day_count = (size_t *)calloc(job.partitions, sizeof(size_t));
+    job.thread_min_emp = (int32_t *)calloc((size_t)job.threads, sizeof(int32_t));
+    job.thread_max_emp = (int32_t *)calloc((size_t)job.threads, sizeof(int32_t));
+    if (job.cursors == NULL || job.partition_start == NULL || job.skipped == NULL ||
+        job.partition_day_count == NULL ||
+        job.thread_min_emp == NULL || job.thread_max_emp == NULL) {
+        fprintf(stderr, "Memory allocation failed while aggregating worked hours\n");
+        goto cleanup;
+    }
+    if (columns->count == 0) {
+        result = 0;
+        goto cleanup;
+    }
+
+    /* Split [min, max] employee number into equal ranges, one per partition */
+    run_phase(&job, PHASE_RANGE);
+    int32_t max_emp = INT32_MIN;
+    job.min_emp = INT32_MAX;
+    for (int t = 0; t < job.threads; t++) {
+        job.min_emp = job.thread_min_emp[t] < job.min_emp ? job.thread_min_emp[t] : job.min_emp;
+        max_emp = job.thread_max_emp[t] > max_emp ? job.thread_max_emp[t] : max_emp;
+    }
+    job.partition_scale = ((uint64_t)job.partitions << 32) / (uint64_t)((int64_t)max_emp - job.min_emp + 1);
+
+    run_phase(&job, PHASE_COUNT);
+
+    /* Partition p holds worker 0's rows, then worker 1's, ... so the scatter keeps input order */
+    size_t position = 0;
+    for (size_t p = 0; p < job.partitions; p++) {
+        job.partition_start[p] = position;
+        for (int t = 0; t < job.threads; t++) {
+            size_t *cursor = &job.cursors[(size_t)t * job.partitions + p];
+            size_t count = *cursor;
+            *cursor = position;
+            position += count;
+        }
+    }
+    job.partition_start[job.partitions] = position;
+    for (int t = 0; t < job.threads; t++) {
+        hours->skipped += job.skipped[t];
+    }
+
+    if (position > 0) {
+        job.items = (HoursItem *)malloc(position * sizeof(HoursItem));
+        job.scratch = (HoursItem *)malloc(position * sizeof(HoursItem));
+        job.days = (WorkedDay *)malloc(position * sizeof(WorkedDay));
+        if (job.items == NULL || job.scratch == NULL || job.days == NULL) {
+            fprintf(stderr, "Memory allocation failed while aggregating worked hours\n");
+            goto cleanup;
+        }
+        run_phase(&job, PHASE_SCATTER);
+        run_phase(&job, PHASE_SUMMARIZE);
+
+        hours->count = compact_days(&job);
+        WorkedDay *shrunk = (WorkedDay *)realloc(job.days, hours->count * sizeof(WorkedDay));
+        hours->days = shrunk != NULL ? shrunk : job.days;
+        job.days = NULL;
+    }
+    result = 0;
+
+cleanup:
+    free(job.days);
+    free(job.partition_day_count);
+    free(job.thread_min_emp);
+    free(job.thread_max_emp);
+    free(job.items);
+    free(job.scratch);
+    free(job.cursors);
+    free(job.partition_start);
+    free(job.skipped);
+    return result;
+}
+
+void worked_hours_free(WorkedHours *hours) {
+    free(hours->days);
+    hours->days = NULL;
+    hours->count = 0;
+    hours->skipped = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef ATTENDANCE_AGGREGATE_H
+#define ATTENDANCE_AGGREGATE_H
+
+#include "attendance_columns.h"
+
+#define AGGREGATE_DEFAULT_DAILY_HOURS_S (8 * 3600)  /* overtime starts after 8 worked hours */
+#define AGGREGATE_MAX_THREADS 64
+
+/**
+ * Worked time of one employee on one local calendar day.
+ *
+ * A record belongs to the day of its punch in, in the punch in's own UTC
+ * offset, so a night shift counts entirely towards the day it started.
+ */
+typedef struct {
+    int32_t emp_number;
+    int32_t day;            /* local day of the punch in, days since 1970-01-01 */
+    uint32_t records;
+    uint32_t open_records;  /* records without a usable punch out; not in worked_s */
+    uint32_t overlaps;      /* records starting before an earlier record of the employee ended */
+    int64_t worked_s;       /* sum of punch out - punch in of closed records */
+    int64_t overtime_s;     /* worked_s beyond the daily threshold */
+    int64_t overlap_s;      /* part of worked_s already covered by an earlier record */
+} WorkedDay;
+
+/**
+ * Per-employee, per-day totals sorted by emp_number, then day
+ */
+typedef struct {
+    WorkedDay *days;
+    size_t count;
+    size_t skipped;         /* punch in outside 1970..2106 or UTC offset beyond a day */
+} WorkedHours;
+
+/**
+ * Compute worked hours, overtime and overlapping records.
+ *
+ * Records are split into partitions by employee number range and each
+ * worker thread owns whole partitions, so no per-employee state is shared
+ * between threads and the partitions concatenate in order.
+ * Durations and local days are computed in branch-free blocks the compiler
+ * can vectorize, and each partition is radix sorted by (employee, punch in)
+ * before a single linear pass produces the totals.
+ * @param columns Decoded attendance records
+ * @param daily_threshold_s Worked seconds per day before overtime starts
+ * @param threads Worker threads, 0 for one per online CPU (small inputs use fewer)
+ * @param hours Receives the totals; free with worked_hours_free()
+ * @return 0 on success, -1 on allocation failure
+ */
+int attendance_aggregate_hours(const AttendanceColumns *columns, int64_t daily_threshold_s, int threads,
+                               WorkedHours *hours);
+
+/**
+ * Free the totals from attendance_aggregate_hours()
+ */
+void worked_hours_free(WorkedHours *hours);
+
+#endif /* ATTENDANCE_AGGREGATE_H */
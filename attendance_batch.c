@@ -0,0 +1,575 @@
+#include "attendance_batch.h"
+#include "attendance_record.h"
+#include "token_holder.h"
+#include "trace.h"
+#include <pthread.h>
+#include <time.h>
+
+#define BATCH_QUEUE_BATCHES 4       /* queued records per sender, in batches */
+#define BATCH_TOKEN_WAIT_MS 30000
+
+/* Statuses of a server without the bulk endpoint */
+#define HTTP_NOT_FOUND 404
+#define HTTP_METHOD_NOT_ALLOWED 405
+#define HTTP_NOT_IMPLEMENTED 501
+
+/**
+ * One queued record
+ */
+typedef struct {
+    char *json;
+    size_t length;
+    Future *future;
+    struct timespec deadline;       /* CLOCK_REALTIME, for pthread_cond_timedwait */
+    unsigned long long sequence;
+} BatchEntry;
+
+struct AttendanceBatcher {
+    Config config;                  /* shallow copy with the batcher's token and transport */
+    Transport *transport;           /* owned, NULL if borrowed from the caller's config */
+    Executor *executor;             /* max_size threads per sender for per-record sends */
+    BatchOptions options;           /* defaults resolved */
+    BatchEntry *entries;            /* ring of queued records */
+    size_t capacity;
+    size_t head;
+    size_t count;
+    unsigned long long last_sequence;
+    unsigned long long flush_through;   /* records up to this sequence are due now */
+    int closing;
+    int bulk_unavailable;
+    BatchStats stats;
+    pthread_t *senders;
+    int sender_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t ready;           /* records queued, flush requested or closing */
+    pthread_cond_t space;           /* the ring has room again */
+};
+
+/**
+ * Whether the oldest queued record must go out now
+ */
+static int oldest_due(const AttendanceBatcher *batcher) {
+    const BatchEntry *oldest = &batcher->entries[batcher->head];
+    struct timespec now;
+
+    if (batcher->closing || oldest->sequence <= batcher->flush_through) {
+        return 1;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    return now.tv_sec > oldest->deadline.tv_sec ||
+           (now.tv_sec == oldest->deadline.tv_sec && now.tv_nsec >= oldest->deadline.tv_nsec);
+}
+
+/**
+ * Wait for a full or due batch and take it off the ring
+ * @return Number of records taken, 0 once the batcher is closing and drained
+ */
+static int take_batch(AttendanceBatcher *batcher, BatchEntry *batch) {
+    int max_size = batcher->options.max_size;
+    int taken = 0;
+
+    pthread_mutex_lock(&batcher->mutex);
+    for (;;) {
+        if (batcher->count >= (size_t)max_size || (batcher->count > 0 && oldest_due(batcher))) {
+            break;
+        }
+        if (batcher->count == 0 && batcher->closing) {
+            pthread_mutex_unlock(&batcher->mutex);
+            return 0;
+        }
+        if (batcher->count == 0) {
+            pthread_cond_wait(&batcher->ready, &batcher->mutex);
+        } else {
+            pthread_cond_timedwait(&batcher->ready, &batcher->mutex,
+                                   &batcher->entries[batcher->head].deadline);
+        }
+    }
+
+    if (batcher->count >= (size_t)max_size) {
+        batcher->stats.full_flushes++;
+    }
+    while (taken < max_size && batcher->count > 0) {
+        batch[taken++] = batcher->entries[batcher->head];
+        batcher->head = (batcher->head + 1) % batcher->capacity;
+        batcher->count--;
+    }
+    batcher->stats.batches++;
+
+    /* Leftovers are another sender's next batch */
+    if (batcher->count > 0) {
+        pthread_cond_signal(&batcher->ready);
+    }
+    pthread_cond_broadcast(&batcher->space);
+    pthread_mutex_unlock(&batcher->mutex);
+    return taken;
+}
+
+/**
+ * Server id of an accepted record from its submission result, 0 if absent
+ */
+static long long result_id(const JsonSlice *value) {
+    OhrmAttendanceRecordResult result;
+    if (ohrm_attendance_record_result_decode(value, &result) == 0 &&
+        (result.present & OHRM_ATTENDANCE_RECORD_RESULT_HAS_DATA) &&
+        (result.data.present & OHRM_ATTENDANCE_RECORD_HAS_ID)) {
+        return (long long)result.data.id;
+    }
+    return 0;
+}
+
+/**
+ * POST the batch as one JSON array to the bulk endpoint
+ * @return 0 if results were filled in, -1 if the server has no bulk endpoint
+ */
+static int send_bulk(AttendanceBatcher *batcher, Config *config, const BatchEntry *batch, int count,
+                     char *body, ResponseBuffer *resp, BatchRecordResult *results) {
+    size_t pos = 0;
+    long status;
+    int filled = 0;
+
+    body[pos++] = '[';
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            body[pos++] = ',';
+        }
+        memcpy(body + pos, batch[i].json, batch[i].length);
+        pos += batch[i].length;
+    }
+    body[pos++] = ']';
+    body[pos] = '\0';
+
+    TRACE_BEGIN("submit_bulk");
+    int rc = api_request_status(OHRM_CREATE_ATTENDANCE_RECORDS_PATH, OHRM_CREATE_ATTENDANCE_RECORDS_METHOD,
+                                body, config, resp, &status);
+    TRACE_END("submit_bulk");
+
+    if (rc == 0 && (status == HTTP_NOT_FOUND || status == HTTP_METHOD_NOT_ALLOWED ||
+                    status == HTTP_NOT_IMPLEMENTED)) {
+        pthread_mutex_lock(&batcher->mutex);
+        if (!batcher->bulk_unavailable) {
+            fprintf(stderr, "Bulk attendance endpoint not available (HTTP %ld), sending records one by one\n",
+                    status);
+            batcher->bulk_unavailable = 1;
+        }
+        pthread_mutex_unlock(&batcher->mutex);
+        return -1;
+    }
+
+    if (rc == 0 && status >= 200 && status < 300) {
+        /* One result per record, in request order */
+        OhrmAttendanceRecordBatchResult parsed;
+        JsonIterator iterator;
+        JsonSlice item;
+        if (ohrm_attendance_record_batch_result_parse(resp->buffer, resp->size, &parsed) == 0 &&
+            json_scan_iter_init(&iterator, &parsed.data) == 0) {
+            while (filled < count && json_scan_iter_next(&iterator, NULL, &item) == JSON_SCAN_FOUND) {
+                results[filled].status = attendance_response_status(item.ptr, item.length);
+                results[filled].id = results[filled].status == ATTENDANCE_ACCEPTED ? result_id(&item) : 0;
+                filled++;
+            }
+        }
+        if (filled < count) {
+            fprintf(stderr, "Bulk attendance response covers %d of %d records\n", filled, count);
+        }
+    }
+
+    /* Records without a result of their own share the outcome of the whole request */
+    int whole = BATCH_RECORD_NOT_SENT;
+    if (rc == 0) {
+        whole = status >= 200 && status < 300 ? ATTENDANCE_INVALID_RESPONSE
+                                              : attendance_response_status(resp->buffer, resp->size);
+    }
+    for (int i = 0; i < count; i++) {
+        if (i >= filled) {
+            results[i].status = whole;
+            results[i].id = 0;
+        }
+        results[i].http_status = status;
+        results[i].bulk = 1;
+    }
+    return 0;
+}
+
+/**
+ * POST one record and fill in its result
+ */
+static void send_record(Config *config, const BatchEntry *entry, ResponseBuffer *resp, BatchRecordResult *result) {
+    long status;
+    TRACE_BEGIN("submit_record");
+    int rc = api_request_status(ATTENDANCE_RECORDS_URL, "POST", entry->json, config, resp, &status);
+    TRACE_END("submit_record");
+
+    result->http_status = status;
+    result->bulk = 0;
+    result->id = 0;
+    if (rc != 0) {
+        result->status = BATCH_RECORD_NOT_SENT;
+        return;
+    }
+    result->status = attendance_response_status(resp->buffer, resp->size);
+    if (result->status == ATTENDANCE_ACCEPTED) {
+        JsonSlice document;
+        if (json_scan_find(resp->buffer, resp->size, "", &document) == JSON_SCAN_FOUND) {
+            result->id = result_id(&document);
+        }
+    }
+}
+
+/**
+ * Per-record sends of one batch, counted down as they finish
+ */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t done;
+    int pending;
+} SendGroup;
+
+typedef struct {
+    SendGroup *group;
+    Config *config;
+    const BatchEntry *entry;
+    ResponseBuffer *resp;
+    BatchRecordResult *result;
+} RecordSend;
+
+static void record_send_task(void *data) {
+    RecordSend *send = (RecordSend *)data;
+    SendGroup *group = send->group;
+
+    send_record(send->config, send->entry, send->resp, send->result);
+    pthread_mutex_lock(&group->mutex);
+    if (--group->pending == 0) {
+        pthread_cond_signal(&group->done);
+    }
+    pthread_mutex_unlock(&group->mutex);
+}
+
+/**
+ * POST the records as separate requests, all at once on the batcher's
+ * executor (one connection each) when resps has a buffer per record,
+ * otherwise one after another through resps[0]
+ */
+static void send_each(AttendanceBatcher *batcher, const BatchEntry *batch, int count, ResponseBuffer *resps,
+                      int resp_count, BatchRecordResult *results) {
+    RecordSend sends[BATCH_MAX_SIZE];
+    SendGroup group;
+
+    if (batcher->executor == NULL || count == 1 || resp_count < count) {
+        for (int i = 0; i < count; i++) {
+            send_record(&batcher->config, &batch[i], &resps[0], &results[i]);
+        }
+        return;
+    }
+
+    pthread_mutex_init(&group.mutex, NULL);
+    pthread_cond_init(&group.done, NULL);
+    group.pending = count;
+    for (int i = 0; i < count; i++) {
+        sends[i].group = &group;
+        sends[i].config = &batcher->config;
+        sends[i].entry = &batch[i];
+        sends[i].resp = &resps[i];
+        sends[i].result = &results[i];
+        if (executor_submit(batcher->executor, record_send_task, &sends[i]) != 0) {
+            record_send_task(&sends[i]);
+        }
+    }
+
+    pthread_mutex_lock(&group.mutex);
+    while (group.pending > 0) {
+        pthread_cond_wait(&group.done, &group.mutex);
+    }
+    pthread_mutex_unlock(&group.mutex);
+    pthread_mutex_destroy(&group.mutex);
+    pthread_cond_destroy(&group.done);
+}
+
+/**
+ * Resolve each record's future with its result and drop the queue's references
+ */
+static void complete_batch(AttendanceBatcher *batcher, BatchEntry *batch, int count,
+                           const BatchRecordResult *results) {
+    unsigned long long accepted = 0;
+
+    for (int i = 0; i < count; i++) {
+        int ok = results[i].status == ATTENDANCE_ACCEPTED;
+        BatchRecordResult *value = (BatchRecordResult *)mem_alloc(MEM_RESPONSE, sizeof(BatchRecordResult));
+        if (value != NULL) {
+            *value = results[i];
+        }
+        accepted += ok;
+        future_complete(batch[i].future, ok ? 0 : -1, value, value != NULL ? mem_free : NULL);
+        future_release(batch[i].future);
+        mem_free(batch[i].json);
+    }
+
+    pthread_mutex_lock(&batcher->mutex);
+    batcher->stats.accepted += accepted;
+    pthread_mutex_unlock(&batcher->mutex);
+}
+
+static void *sender_thread(void *data) {
+    AttendanceBatcher *batcher = (AttendanceBatcher *)data;
+    BatchEntry batch[BATCH_MAX_SIZE];
+    BatchRecordResult results[BATCH_MAX_SIZE];
+    ResponseBuffer resp;
+    ResponseBuffer record_resps[BATCH_MAX_SIZE];
+    int record_resp_count = 0;      /* allocated on the first per-record batch */
+    int count;
+
+    trace_set_thread_name("attendance_batch");
+
+    /* Room for max_size records, the commas between them and the brackets */
+    char *body = (char *)mem_alloc(MEM_REQUEST, (size_t)batcher->options.max_size * ATTENDANCE_JSON_SIZE + 2);
+    int ready = body != NULL && response_buffer_init(&resp, MAX_RESPONSE_SIZE) == 0;
+    if (!ready) {
+        fprintf(stderr, "Failed to allocate attendance batch buffers\n");
+    }
+
+    /* A sender without buffers still drains its share as failures */
+    while ((count = take_batch(batcher, batch)) > 0) {
+        memset(results, 0, sizeof(BatchRecordResult) * (size_t)count);
+        for (int i = 0; i < count && !ready; i++) {
+            results[i].status = BATCH_RECORD_NOT_SENT;
+        }
+
+        if (ready) {
+            pthread_mutex_lock(&batcher->mutex);
+            int use_bulk = count > 1 && batcher->options.bulk > 0 && !batcher->bulk_unavailable;
+            pthread_mutex_unlock(&batcher->mutex);
+
+            TRACE_BEGIN("submit_batch");
+            if (use_bulk && send_bulk(batcher, &batcher->config, batch, count, body, &resp, results) == 0) {
+                pthread_mutex_lock(&batcher->mutex);
+                batcher->stats.bulk_requests++;
+                pthread_mutex_unlock(&batcher->mutex);
+            } else {
+                if (batcher->executor != NULL && record_resp_count == 0) {
+                    while (record_resp_count < batcher->options.max_size &&
+                           response_buffer_init(&record_resps[record_resp_count], MAX_RESPONSE_SIZE) == 0) {
+                        record_resp_count++;
+                    }
+                }
+                send_each(batcher, batch, count, record_resp_count > 0 ? record_resps : &resp,
+                          record_resp_count, results);
+                pthread_mutex_lock(&batcher->mutex);
+                batcher->stats.single_requests += (unsigned long long)count;
+                pthread_mutex_unlock(&batcher->mutex);
+            }
+            TRACE_END("submit_batch");
+        }
+        complete_batch(batcher, batch, count, results);
+    }
+
+    if (ready) {
+        response_buffer_free(&resp);
+    }
+    for (int i = 0; i < record_resp_count; i++) {
+        response_buffer_free(&record_resps[i]);
+    }
+    mem_free(body);
+    return NULL;
+}
+
+AttendanceBatcher *attendance_batcher_create(const Config *config, const BatchOptions *options) {
+    if (config == NULL || config->base_url == NULL) {
+        fprintf(stderr, "Invalid parameters for attendance_batcher_create\n");
+        return NULL;
+    }
+
+    AttendanceBatcher *batcher = (AttendanceBatcher *)calloc(1, sizeof(AttendanceBatcher));
+    if (batcher == NULL) {
+        fprintf(stderr, "Memory allocation failed for attendance batcher\n");
+        return NULL;
+    }
+    if (options != NULL) {
+        batcher->options = *options;
+    }
+    if (batcher->options.max_size <= 0) {
+        batcher->options.max_size = BATCH_DEFAULT_SIZE;
+    }
+    if (batcher->options.max_size > BATCH_MAX_SIZE) {
+        batcher->options.max_size = BATCH_MAX_SIZE;
+    }
+    if (batcher->options.max_delay_ms <= 0) {
+        batcher->options.max_delay_ms = BATCH_DEFAULT_DELAY_MS;
+    }
+    if (batcher->options.connections <= 0) {
+        batcher->options.connections = BATCH_DEFAULT_CONNECTIONS;
+    }
+    pthread_mutex_init(&batcher->mutex, NULL);
+    pthread_cond_init(&batcher->ready, NULL);
+    pthread_cond_init(&batcher->space, NULL);
+
+    batcher->config = *config;
+    batcher->config.access_token = NULL;
+    batcher->config.refresh_token = NULL;
+
+    /*
+     * A bulk batch takes one connection per sender, kept warm by the last
+     * batch; without bulk every record of a batch is sent at once, so each
+     * sender needs a connection per record
+     */
+    if (batcher->options.max_size > 1) {
+        batcher->executor = executor_create(batcher->options.connections * batcher->options.max_size);
+        if (batcher->executor == NULL) {
+            fprintf(stderr, "Attendance batcher sends records one by one\n");
+        }
+    }
+    if (config->transport == NULL) {
+        TransportOptions transport_options = config->transport_options;
+        transport_options.max_host_connections = batcher->options.connections *
+                                                 (batcher->executor != NULL ? batcher->options.max_size : 1);
+        batcher->transport = curl_transport_create_with_options(&transport_options);
+        if (batcher->transport == NULL) {
+            goto fail;
+        }
+        batcher->config.transport = batcher->transport;
+    }
+    if (orangehrm_warmup(&batcher->config) != 0) {
+        fprintf(stderr, "Attendance batcher warm-up failed, connecting on the first batch\n");
+    }
+
+    if ((config->token_holder != NULL
+         ? token_holder_wait(config->token_holder, BATCH_TOKEN_WAIT_MS)
+         : get_token(&batcher->config)) != 0) {
+        fprintf(stderr, "Attendance batcher failed to obtain access token\n");
+        goto fail;
+    }
+
+    batcher->capacity = (size_t)batcher->options.max_size * BATCH_QUEUE_BATCHES *
+                        (size_t)batcher->options.connections;
+    batcher->entries = (BatchEntry *)calloc(batcher->capacity, sizeof(BatchEntry));
+    batcher->senders = (pthread_t *)calloc((size_t)batcher->options.connections, sizeof(pthread_t));
+    if (batcher->entries == NULL || batcher->senders == NULL) {
+        fprintf(stderr, "Memory allocation failed for attendance batcher\n");
+        goto fail;
+    }
+
+    for (int i = 0; i < batcher->options.connections; i++) {
+        if (pthread_create(&batcher->senders[i], NULL, sender_thread, batcher) != 0) {
+            fprintf(stderr, "Error creating attendance batch sender %d\n", i);
+            break;
+        }
+        batcher->sender_count++;
+    }
+    if (batcher->sender_count == 0) {
+        goto fail;
+    }
+    return batcher;
+
+fail:
+    mem_free(batcher->config.access_token);
+    executor_destroy(batcher->executor);
+    transport_destroy(batcher->transport);
+    free(batcher->entries);
+    free(batcher->senders);
+    pthread_mutex_destroy(&batcher->mutex);
+    pthread_cond_destroy(&batcher->ready);
+    pthread_cond_destroy(&batcher->space);
+    free(batcher);
+    return NULL;
+}
+
+Future *attendance_batcher_submit(AttendanceBatcher *batcher, const char *json) {
+    if (batcher == NULL || json == NULL) {
+        fprintf(stderr, "Invalid parameters for attendance_batcher_submit\n");
+        return NULL;
+    }
+
+    size_t length = strlen(json);
+    if (length >= ATTENDANCE_JSON_SIZE) {
+        fprintf(stderr, "Attendance record of %zu bytes is too large to batch\n", length);
+        return NULL;
+    }
+
+    /* The copy waits for the budget first, then for room in the ring below */
+    if (mem_budget_admit(length + 1) != 0) {
+        return NULL;
+    }
+    char *copy = (char *)mem_alloc(MEM_REQUEST, length + 1);
+    Future *future = future_new();
+    if (copy == NULL || future == NULL) {
+        fprintf(stderr, "Memory allocation failed for batched attendance record\n");
+        mem_free(copy);
+        future_release(future);
+        return NULL;
+    }
+    memcpy(copy, json, length + 1);
+
+    pthread_mutex_lock(&batcher->mutex);
+    while (batcher->count == batcher->capacity && !batcher->closing) {
+        pthread_cond_wait(&batcher->space, &batcher->mutex);
+    }
+    if (batcher->closing) {
+        pthread_mutex_unlock(&batcher->mutex);
+        mem_free(copy);
+        future_release(future);
+        return NULL;
+    }
+
+    BatchEntry *entry = &batcher->entries[(batcher->head + batcher->count) % batcher->capacity];
+    entry->json = copy;
+    entry->length = length;
+    entry->future = future_retain(future);  /* The queue's reference, dropped by the sender */
+    entry->sequence = ++batcher->last_sequence;
+    clock_gettime(CLOCK_REALTIME, &entry->deadline);
+    entry->deadline.tv_sec += batcher->options.max_delay_ms / 1000;
+    entry->deadline.tv_nsec += (long)(batcher->options.max_delay_ms % 1000) * 1000000L;
+    if (entry->deadline.tv_nsec >= 1000000000L) {
+        entry->deadline.tv_sec++;
+        entry->deadline.tv_nsec -= 1000000000L;
+    }
+    batcher->count++;
+    batcher->stats.records++;
+
+    /* Senders only need waking for a new oldest record (new deadline) or a full batch */
+    if (batcher->count == 1 || batcher->count == (size_t)batcher->options.max_size) {
+        pthread_cond_signal(&batcher->ready);
+    }
+    pthread_mutex_unlock(&batcher->mutex);
+    return future;
+}
+
+void attendance_batcher_flush(AttendanceBatcher *batcher) {
+    if (batcher == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&batcher->mutex);
+    batcher->flush_through = batcher->last_sequence;
+    pthread_cond_broadcast(&batcher->ready);
+    pthread_mutex_unlock(&batcher->mutex);
+}
+
+void attendance_batcher_stats(AttendanceBatcher *batcher, BatchStats *stats) {
+    pthread_mutex_lock(&batcher->mutex);
+    *stats = batcher->stats;
+    pthread_mutex_unlock(&batcher->mutex);
+}
+
+void attendance_batcher_destroy(AttendanceBatcher *batcher) {
+    if (batcher == NULL) {
+        return;
+    }
+
+    /* Senders drain the ring before they see the batcher closed */
+    pthread_mutex_lock(&batcher->mutex);
+    batcher->closing = 1;
+    pthread_cond_broadcast(&batcher->ready);
+    pthread_cond_broadcast(&batcher->space);
+    pthread_mutex_unlock(&batcher->mutex);
+    for (int i = 0; i < batcher->sender_count; i++) {
+        pthread_join(batcher->senders[i], NULL);
+    }
+
+    mem_free(batcher->config.access_token);
+    executor_destroy(batcher->executor);
+    transport_destroy(batcher->transport);
+    free(batcher->entries);
+    free(batcher->senders);
+    pthread_mutex_destroy(&batcher->mutex);
+    pthread_cond_destroy(&batcher->ready);
+    pthread_cond_destroy(&batcher->space);
+    free(batcher);
+}
@@ -0,0 +1,97 @@
+#ifndef ATTENDANCE_BATCH_H
+#define ATTENDANCE_BATCH_H
+
+#include "orangehrm_client.h"
+#include "future.h"
+
+#define BATCH_DEFAULT_SIZE 20
+#define BATCH_MAX_SIZE 100
+#define BATCH_DEFAULT_DELAY_MS 20
+#define BATCH_DEFAULT_CONNECTIONS 2   /* one batch fills while the last one is in flight */
+
+/**
+ * Groups attendance submissions into batches.
+ *
+ * Callers queue serialized records and get a future per record. A batch is
+ * sent once max_size records are queued or the oldest has waited max_delay_ms.
+ * Each sender thread sends one batch at a time, as one request per record,
+ * all in flight at once over the batcher's warm connections (max_size per
+ * sender). With bulk set, a batch is sent as a single POST to the bulk
+ * endpoint instead, over one connection per sender;
+ * that endpoint is a local extension (api/orangehrm_openapi_local.json)
+ * that stock OrangeHRM does not serve, so a server answering it with 404,
+ * 405 or 501 is remembered and not asked again.
+ */
+typedef struct AttendanceBatcher AttendanceBatcher;
+
+/**
+ * Batching options (zero selects the BATCH_DEFAULT_* value)
+ */
+typedef struct {
+    int max_size;           /* records per batch, at most BATCH_MAX_SIZE */
+    int max_delay_ms;       /* longest a record waits for its batch to fill */
+    int connections;        /* sender threads, i.e. batches in flight at once */
+    int bulk;               /* > 0 sends each batch to the bulk endpoint (opt-in, see above) */
+} BatchOptions;
+
+#define BATCH_RECORD_NOT_SENT (-2)
+
+/**
+ * Outcome of one record (value of its future)
+ */
+typedef struct {
+    int status;             /* ATTENDANCE_ACCEPTED, ATTENDANCE_REJECTED, ATTENDANCE_INVALID_RESPONSE
+                               or BATCH_RECORD_NOT_SENT if no response arrived */
+    long http_status;       /* 0 if no response arrived */
+    long long id;           /* server id of an accepted record, 0 if not reported */
+    int bulk;               /* sent through the bulk endpoint */
+} BatchRecordResult;
+
+/**
+ * Counters of a batcher
+ */
+typedef struct {
+    unsigned long long records;
+    unsigned long long accepted;
+    unsigned long long batches;
+    unsigned long long bulk_requests;
+    unsigned long long single_requests;
+    unsigned long long full_flushes;    /* batches sent because they reached max_size */
+} BatchStats;
+
+/**
+ * Create a batcher and its sender threads. Uses config's token holder if it
+ * has one, otherwise fetches its own token; a transport limited to one
+ * connection per sender is created and warmed up unless config->transport
+ * is set (then it is borrowed).
+ * @param config Credentials (copied shallowly, must stay valid until destroyed)
+ * @param options Options, NULL for the defaults
+ * @return New batcher, NULL on failure
+ */
+AttendanceBatcher *attendance_batcher_create(const Config *config, const BatchOptions *options);
+
+/**
+ * Queue one record, blocking while the queue is full
+ * @param json Record body from attendance_record_to_json (copied)
+ * @return Future resolving with 0 if the record was accepted, -1 otherwise;
+ *         its value is a BatchRecordResult. NULL if the batcher is shutting
+ *         down or the record does not fit the memory budget.
+ */
+Future *attendance_batcher_submit(AttendanceBatcher *batcher, const char *json);
+
+/**
+ * Send the records queued so far without waiting for their deadline
+ */
+void attendance_batcher_flush(AttendanceBatcher *batcher);
+
+/**
+ * Read the counters
+ */
+void attendance_batcher_stats(AttendanceBatcher *batcher, BatchStats *stats);
+
+/**
+ * Send every queued record, stop the senders and free the batcher
+ */
+void attendance_batcher_destroy(AttendanceBatcher *batcher);
+
+#endif /* ATTENDANCE_BATCH_H */
@@ -0,0 +1,439 @@
+#include "attendance_columns.h"
+#include "json_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLUMNS_INITIAL_CAPACITY 1024
+#define NOTE_INITIAL_SLOTS 256
+#define NOTE_STACK_SIZE 256
+
+/**
+ * Fields of one list entry as found in the response
+ */
+typedef struct {
+    int has_emp_number;
+    int32_t emp_number;
+    JsonSlice in_date, in_time, in_offset, in_note;
+    JsonSlice out_date, out_time, out_offset, out_note;
+} RawAttendance;
+
+void attendance_columns_init(AttendanceColumns *columns) {
+    memset(columns, 0, sizeof(AttendanceColumns));
+}
+
+void attendance_columns_free(AttendanceColumns *columns) {
+    if (columns == NULL) {
+        return;
+    }
+    free(columns->emp_number);
+    free(columns->punch_in);
+    free(columns->punch_out);
+    free(columns->punch_in_offset);
+    free(columns->punch_out_offset);
+    free(columns->punch_in_note);
+    free(columns->punch_out_note);
+    free(columns->note_pool);
+    free(columns->note_offsets);
+    free(columns->note_slots);
+    memset(columns, 0, sizeof(AttendanceColumns));
+}
+
+void attendance_columns_clear(AttendanceColumns *columns) {
+    columns->count = 0;
+    columns->rejected = 0;
+}
+
+static int grow_array(void **array, size_t element_size, size_t capacity) {
+    void *grown = realloc(*array, element_size * capacity);
+    if (grown == NULL) {
+        return -1;
+    }
+    *array = grown;
+    return 0;
+}
+
+/**
+ * Make room for one more record in every column
+ */
+static int reserve_record(AttendanceColumns *columns) {
+    if (columns->count < columns->capacity) {
+        return 0;
+    }
+
+    size_t capacity = columns->capacity == 0 ? COLUMNS_INITIAL_CAPACITY : columns->capacity * 2;
+    if (grow_array((void **)&columns->emp_number, sizeof(int32_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_in, sizeof(int64_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_out, sizeof(int64_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_in_offset, sizeof(int16_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_out_offset, sizeof(int16_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_in_note, sizeof(uint32_t), capacity) != 0 ||
+        grow_array((void **)&columns->punch_out_note, sizeof(uint32_t), capacity) != 0) {
+        fprintf(stderr, "Failed to grow attendance columns\n");
+        return -1;
+    }
+    columns->capacity = capacity;
+    return 0;
+}
+
+int attendance_columns_append(AttendanceColumns *columns, int32_t emp_number, int64_t punch_in,
+                              int64_t punch_out, int16_t punch_in_offset, int16_t punch_out_offset) {
+    if (reserve_record(columns) != 0) {
+        return -1;
+    }
+
+    size_t i = columns->count++;
+    columns->emp_number[i] = emp_number;
+    columns->punch_in[i] = punch_in;
+    columns->punch_out[i] = punch_out;
+    columns->punch_in_offset[i] = punch_in_offset;
+    columns->punch_out_offset[i] = punch_out_offset;
+    columns->punch_in_note[i] = ATTENDANCE_NOTE_NONE;
+    columns->punch_out_note[i] = ATTENDANCE_NOTE_NONE;
+    return 0;
+}
+
+/* ---- Note interning ---- */
+
+static uint32_t hash_note(const char *text, size_t length) {
+    uint32_t hash = 2166136261u;  /* FNV-1a */
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const char *note_text(const AttendanceColumns *columns, uint32_t id) {
+    return columns->note_pool + columns->note_offsets[id];
+}
+
+static int rehash_notes(AttendanceColumns *columns, uint32_t slot_count) {
+    uint32_t *slots = (uint32_t *)calloc(slot_count, sizeof(uint32_t));
+    if (slots == NULL) {
+        return -1;
+    }
+    for (uint32_t id = 1; id < columns->note_count; id++) {
+        const char *text = note_text(columns, id);
+        uint32_t slot = hash_note(text, strlen(text)) & (slot_count - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = id;
+    }
+    free(columns->note_slots);
+    columns->note_slots = slots;
+    columns->note_slot_count = slot_count;
+    return 0;
+}
+
+/**
+ * Return the id of a note, adding it to the table if new
+ * @return Note id, ATTENDANCE_NOTE_NONE for empty text, (uint32_t)-1 on allocation failure
+ */
+static uint32_t intern_note(AttendanceColumns *columns, const char *text, size_t length) {
+    if (length == 0) {
+        return ATTENDANCE_NOTE_NONE;
+    }
+
+    if (columns->note_count == 0) {
+        /* Id 0 is the empty note */
+        columns->note_offsets = (uint32_t *)malloc(16 * sizeof(uint32_t));
+        columns->note_pool = (char *)malloc(1024);
+        if (columns->note_offsets == NULL || columns->note_pool == NULL ||
+            rehash_notes(columns, NOTE_INITIAL_SLOTS) != 0) {
+            free(columns->note_offsets);
+            free(columns->note_pool);
+            columns->note_offsets = NULL;
+            columns->note_pool = NULL;
+            return (uint32_t)-1;
+        }
+        columns->note_capacity = 16;
+        columns->note_pool_capacity = 1024;
+        columns->note_pool[0] = '\0';
+        columns->note_pool_size = 1;
+        columns->note_offsets[0] = 0;
+        columns->note_count = 1;
+    }
+
+    uint32_t mask = columns->note_slot_count - 1;
+    uint32_t slot = hash_note(text, length) & mask;
+    while (columns->note_slots[slot] != 0) {
+        uint32_t id = columns->note_slots[slot];
+        const char *existing = note_text(columns, id);
+        if (strncmp(existing, text, length) == 0 && existing[length] == '\0') {
+            return id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    /* New note: append the text and index it */
+    if (columns->note_pool_size + length + 1 > columns->note_pool_capacity) {
+        size_t capacity = columns->note_pool_capacity * 2;
+        while (capacity < columns->note_pool_size + length + 1) {
+            capacity *= 2;
+        }
+        if (grow_array((void **)&columns->note_pool, 1, capacity) != 0) {
+            return (uint32_t)-1;
+        }
+        columns->note_pool_capacity = capacity;
+    }
+    if (columns->note_count == columns->note_capacity) {
+        if (grow_array((void **)&columns->note_offsets, sizeof(uint32_t), columns->note_capacity * 2) != 0) {
+            return (uint32_t)-1;
+        }
+        columns->note_capacity *= 2;
+    }
+
+    uint32_t id = columns->note_count++;
+    columns->note_offsets[id] = (uint32_t)columns->note_pool_size;
+    memcpy(columns->note_pool + columns->note_pool_size, text, length);
+    columns->note_pool[columns->note_pool_size + length] = '\0';
+    columns->note_pool_size += length + 1;
+    columns->note_slots[slot] = id;
+
+    /* Keep the table at most half full */
+    if (columns->note_count * 2 > columns->note_slot_count &&
+        rehash_notes(columns, columns->note_slot_count * 2) != 0) {
+        return (uint32_t)-1;
+    }
+    return id;
+}
+
+/**
+ * Intern a JSON note value (string, null or missing)
+ */
+static uint32_t intern_note_value(AttendanceColumns *columns, const JsonSlice *note) {
+    char stack[NOTE_STACK_SIZE];
+    char *text = stack;
+    uint32_t id;
+
+    if (note->ptr == NULL || note->type != JSON_SCAN_STRING || note->length == 0) {
+        return ATTENDANCE_NOTE_NONE;
+    }
+    if (note->length + 1 > sizeof(stack)) {
+        text = (char *)malloc(note->length + 1);
+        if (text == NULL) {
+            return (uint32_t)-1;
+        }
+    }
+
+    int length = json_scan_string(note, text, note->length + 1);
+    id = length < 0 ? ATTENDANCE_NOTE_NONE : intern_note(columns, text, (size_t)length);
+
+    if (text != stack) {
+        free(text);
+    }
+    return id;
+}
+
+const char *attendance_columns_note(const AttendanceColumns *columns, uint32_t id) {
+    if (columns == NULL || id >= columns->note_count) {
+        return "";
+    }
+    return note_text(columns, id);
+}
+
+/* ---- Field parsing ---- */
+
+static int parse_digits(const char *p, size_t count, int *value) {
+    *value = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return -1;
+        }
+        *value = *value * 10 + (p[i] - '0');
+    }
+    return 0;
+}
+
+/**
+ * Days since 1970-01-01 of a proleptic Gregorian date
+ */
+static int64_t days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+/**
+ * Parse a "+05.5" style offset in hours into minutes
+ */
+static int parse_offset(const JsonSlice *slice, int16_t *minutes) {
+    const char *p = slice->ptr;
+    const char *end = p + slice->length;
+    int sign = 1;
+    int hours = 0;
+    int fraction = 0;
+    int scale = 1;
+
+    *minutes = 0;
+    if (slice->ptr == NULL) {
+        return 0;  /* Missing: assume UTC */
+    }
+    if (slice->type != JSON_SCAN_STRING && slice->type != JSON_SCAN_NUMBER) {
+        return -1;
+    }
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        sign = *p == '-' ? -1 : 1;
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return -1;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        hours = hours * 10 + (*p++ - '0');
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9' && scale < 1000) {
+            fraction = fraction * 10 + (*p++ - '0');
+            scale *= 10;
+        }
+    }
+    if (p != end || hours > 14) {
+        return -1;
+    }
+
+    *minutes = (int16_t)(sign * (hours * 60 + (fraction * 60 + scale / 2) / scale));
+    return 0;
+}
+
+/**
+ * Convert local date ("YYYY-MM-DD"), time ("HH:MM[:SS]") and offset to UTC epoch seconds
+ */
+static int parse_punch(const JsonSlice *date, const JsonSlice *time, const JsonSlice *offset,
+                       int64_t *epoch, int16_t *offset_minutes) {
+    int year, month, day, hour, minute, second = 0;
+
+    if (date->ptr == NULL || time->ptr == NULL ||
+        date->type != JSON_SCAN_STRING || time->type != JSON_SCAN_STRING ||
+        date->length != 10 || (time->length != 5 && time->length != 8) ||
+        date->ptr[4] != '-' || date->ptr[7] != '-' || time->ptr[2] != ':' ||
+        parse_digits(date->ptr, 4, &year) != 0 || parse_digits(date->ptr + 5, 2, &month) != 0 ||
+        parse_digits(date->ptr + 8, 2, &day) != 0 || parse_digits(time->ptr, 2, &hour) != 0 ||
+        parse_digits(time->ptr + 3, 2, &minute) != 0 ||
+        (time->length == 8 && (time->ptr[5] != ':' || parse_digits(time->ptr + 6, 2, &second) != 0)) ||
+        month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60 ||
+        parse_offset(offset, offset_minutes) != 0) {
+        return -1;
+    }
+
+    *epoch = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second -
+             (int64_t)*offset_minutes * 60;
+    return 0;
+}
+
+static int parse_emp_number(const JsonSlice *value, int32_t *emp_number) {
+    long long number;
+    if (json_scan_long(value, &number) != 0 || number <= 0 || number > INT32_MAX) {
+        return -1;
+    }
+    *emp_number = (int32_t)number;
+    return 0;
+}
+
+/**
+ * Collect the fields of one list entry
+ */
+static int read_entry(const JsonSlice *entry, RawAttendance *raw) {
+    JsonIterator members;
+    JsonSlice key, value;
+    int status;
+
+    memset(raw, 0, sizeof(RawAttendance));
+    if (json_scan_iter_init(&members, entry) != 0 || entry->type != JSON_SCAN_OBJECT) {
+        return -1;
+    }
+
+    while ((status = json_scan_iter_next(&members, &key, &value)) == JSON_SCAN_FOUND) {
+        JsonSlice *field = NULL;
+
+#define KEY_IS(name) (key.length == sizeof(name) - 1 && memcmp(key.ptr, name, sizeof(name) - 1) == 0)
+        if (KEY_IS("empNumber")) {
+            raw->has_emp_number = parse_emp_number(&value, &raw->emp_number) == 0;
+        } else if (key.length > 7 && memcmp(key.ptr, "punchIn", 7) == 0) {
+            if (KEY_IS("punchInDate")) field = &raw->in_date;
+            else if (KEY_IS("punchInTime")) field = &raw->in_time;
+            else if (KEY_IS("punchInTimezoneOffset")) field = &raw->in_offset;
+            else if (KEY_IS("punchInNote")) field = &raw->in_note;
+        } else if (key.length > 8 && memcmp(key.ptr, "punchOut", 8) == 0) {
+            if (KEY_IS("punchOutDate")) field = &raw->out_date;
+            else if (KEY_IS("punchOutTime")) field = &raw->out_time;
+            else if (KEY_IS("punchOutTimezoneOffset")) field = &raw->out_offset;
+            else if (KEY_IS("punchOutNote")) field = &raw->out_note;
+        }
+#undef KEY_IS
+
+        if (field != NULL && value.type != JSON_SCAN_NULL) {
+            *field = value;
+        }
+    }
+    return status == JSON_SCAN_MALFORMED ? -1 : 0;
+}
+
+int attendance_columns_decode(AttendanceColumns *columns, const char *json, size_t length) {
+    JsonSlice list, entry;
+    JsonIterator entries;
+    RawAttendance raw;
+    int appended = 0;
+    int status;
+
+    if (columns == NULL || json == NULL) {
+        fprintf(stderr, "Invalid parameters for attendance_columns_decode\n");
+        return -1;
+    }
+
+    status = json_scan_find(json, length, "data", &list);
+    if (status == JSON_SCAN_NOT_FOUND) {
+        status = json_scan_find(json, length, "", &list);  /* Bare array */
+    }
+    if (status != JSON_SCAN_FOUND || json_scan_iter_init(&entries, &list) != 0 || list.type != JSON_SCAN_ARRAY) {
+        fprintf(stderr, "Unexpected attendance list response\n");
+        return -1;
+    }
+
+    while ((status = json_scan_iter_next(&entries, NULL, &entry)) == JSON_SCAN_FOUND) {
+        size_t i = columns->count;
+        int64_t punch_in = 0, punch_out = 0;
+        int16_t in_offset = 0, out_offset = 0;
+
+        if (read_entry(&entry, &raw) != 0 || !raw.has_emp_number ||
+            parse_punch(&raw.in_date, &raw.in_time, &raw.in_offset, &punch_in, &in_offset) != 0) {
+            columns->rejected++;
+            continue;
+        }
+        if (raw.out_date.ptr != NULL &&
+            parse_punch(&raw.out_date, &raw.out_time, &raw.out_offset, &punch_out, &out_offset) != 0) {
+            columns->rejected++;
+            continue;
+        }
+
+        uint32_t in_note = intern_note_value(columns, &raw.in_note);
+        uint32_t out_note = intern_note_value(columns, &raw.out_note);
+        if (in_note == (uint32_t)-1 || out_note == (uint32_t)-1 || reserve_record(columns) != 0) {
+            fprintf(stderr, "Memory allocation failed while decoding attendance records\n");
+            return -1;
+        }
+
+        columns->emp_number[i] = raw.emp_number;
+        columns->punch_in[i] = punch_in;
+        columns->punch_out[i] = punch_out;
+        columns->punch_in_offset[i] = in_offset;
+        columns->punch_out_offset[i] = out_offset;
+        columns->punch_in_note[i] = in_note;
+        columns->punch_out_note[i] = out_note;
+        columns->count++;
+        appended++;
+    }
+
+    if (status == JSON_SCAN_MALFORMED) {
+        fprintf(stderr, "Malformed attendance list response\n");
+        return -1;
+    }
+    return appended;
+}
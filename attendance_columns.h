@@ -0,0 +1,85 @@
+#ifndef ATTENDANCE_COLUMNS_H
+#define ATTENDANCE_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ATTENDANCE_NOTE_NONE 0  /* note id of records without a note */
+
+/**
+ * Attendance records decoded column by column (struct of arrays).
+ *
+ * Record i is emp_number[i], punch_in[i], ... so a scan over one field
+ * touches only that field's array. Times are UTC epoch seconds, offsets are
+ * the punch's UTC offset in minutes, and notes are ids into an intern table
+ * (each distinct note text is stored once).
+ */
+typedef struct {
+    size_t count;
+    size_t capacity;
+    int32_t *emp_number;
+    int64_t *punch_in;              /* 0 if missing */
+    int64_t *punch_out;             /* 0 if the record is still open */
+    int16_t *punch_in_offset;
+    int16_t *punch_out_offset;
+    uint32_t *punch_in_note;
+    uint32_t *punch_out_note;
+    size_t rejected;                /* list entries without a valid empNumber or punch in */
+
+    /* Note intern table: id -> offset into the text pool, hashed by text */
+    char *note_pool;
+    size_t note_pool_size;
+    size_t note_pool_capacity;
+    uint32_t *note_offsets;
+    uint32_t note_count;
+    uint32_t note_capacity;
+    uint32_t *note_slots;           /* open addressing, 0 = empty, else id */
+    uint32_t note_slot_count;       /* power of two */
+} AttendanceColumns;
+
+/**
+ * Initialize empty columns
+ */
+void attendance_columns_init(AttendanceColumns *columns);
+
+/**
+ * Free all columns and interned notes
+ */
+void attendance_columns_free(AttendanceColumns *columns);
+
+/**
+ * Drop all records but keep the allocated capacity and interned notes
+ */
+void attendance_columns_clear(AttendanceColumns *columns);
+
+/**
+ * Append one record without notes
+ * @param columns Columns to append to
+ * @param emp_number Employee number
+ * @param punch_in Punch in, UTC epoch seconds
+ * @param punch_out Punch out, UTC epoch seconds (0 if still open)
+ * @param punch_in_offset UTC offset of the punch in, minutes
+ * @param punch_out_offset UTC offset of the punch out, minutes
+ * @return 0 on success, -1 on allocation failure
+ */
+int attendance_columns_append(AttendanceColumns *columns, int32_t emp_number, int64_t punch_in,
+                              int64_t punch_out, int16_t punch_in_offset, int16_t punch_out_offset);
+
+/**
+ * Decode an attendance record list response and append its records.
+ * Accepts {"data":[...]} or a bare array of records with the fields of
+ * ATTENDANCE_RECORDS_URL bodies (empNumber, punchInDate, punchInTime,
+ * punchInTimezoneOffset, punchInNote and the punchOut* equivalents).
+ * @param columns Columns to append to
+ * @param json Response body
+ * @param length Body length in bytes
+ * @return Number of records appended, -1 on malformed JSON or allocation failure
+ */
+int attendance_columns_decode(AttendanceColumns *columns, const char *json, size_t length);
+
+/**
+ * Text of an interned note ("" for ATTENDANCE_NOTE_NONE or unknown ids)
+ */
+const char *attendance_columns_note(const AttendanceColumns *columns, uint32_t id);
+
+#endif /* ATTENDANCE_COLUMNS_H */
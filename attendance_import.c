@@ -0,0 +1,516 @@
+#include "attendance_import.h"
+#include "attendance_batch.h"
+#include "attendance_record.h"
+#include "bounded_queue.h"
+#include "token_holder.h"
+#include "trace.h"
+#include <pthread.h>
+#include <time.h>
+
+#define IMPORT_MAX_FIELDS 5
+#define IMPORT_TOKEN_WAIT_MS 30000
+
+/**
+ * Record travelling through the pipeline (allocated by parse, freed by submit)
+ */
+typedef struct {
+    long line;
+    AttendanceRecord record;
+    FormattedPunch punch_in;
+    FormattedPunch punch_out;
+    char json[ATTENDANCE_JSON_SIZE];
+} ImportItem;
+
+typedef struct {
+    const ImportOptions *options;
+    const Config *config;
+    ImportReport *report;
+    BoundedQueue to_format;
+    BoundedQueue to_serialize;
+    BoundedQueue to_submit;
+    AttendanceBatcher *batcher;     /* NULL posts each record from its worker */
+    pthread_mutex_t stats_mutex;
+} ImportContext;
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/**
+ * Split a CSV line in place, honouring double-quoted fields with "" escapes
+ * @return Number of fields found
+ */
+static int split_csv_line(char *line, char **fields, int max_fields) {
+    int count = 0;
+    char *read = line;
+
+    while (count < max_fields) {
+        char *write = read;
+        fields[count++] = write;
+
+        if (*read == '"') {
+            read++;
+            while (*read != '\0') {
+                if (*read == '"' && read[1] == '"') {
+                    *write++ = '"';
+                    read += 2;
+                } else if (*read == '"') {
+                    read++;
+                    break;
+                } else {
+                    *write++ = *read++;
+                }
+            }
+        }
+        while (*read != '\0' && *read != ',') {
+            *write++ = *read++;
+        }
+
+        int more = (*read == ',');
+        *write = '\0';
+        if (!more) {
+            break;
+        }
+        read++;
+    }
+    return count;
+}
+
+/**
+ * Parse epoch seconds or local "YYYY-MM-DD HH:MM[:SS]"
+ */
+static int parse_punch_time(const char *value, time_t *out) {
+    char *end = NULL;
+    long long epoch = strtoll(value, &end, 10);
+    if (end != value && *end == '\0') {
+        *out = (time_t)epoch;
+        return 0;
+    }
+
+    struct tm tm_info;
+    memset(&tm_info, 0, sizeof(tm_info));
+    if (sscanf(value, "%d-%d-%d %d:%d:%d", &tm_info.tm_year, &tm_info.tm_mon, &tm_info.tm_mday,
+               &tm_info.tm_hour, &tm_info.tm_min, &tm_info.tm_sec) < 5) {
+        return -1;
+    }
+    tm_info.tm_year -= 1900;
+    tm_info.tm_mon -= 1;
+    tm_info.tm_isdst = -1;
+    *out = mktime(&tm_info);
+    return *out == (time_t)-1 ? -1 : 0;
+}
+
+static void trim_line_end(char *line) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+}
+
+/**
+ * Stage 1: stream the CSV file into records
+ */
+static void *parse_stage(void *data) {
+    ImportContext *ctx = (ImportContext *)data;
+    ImportStageStats *stats = &ctx->report->stages[IMPORT_STAGE_PARSE];
+    unsigned long long start = monotonic_ns();
+    char *line = NULL;
+    size_t line_size = 0;
+    long line_number = 0;
+    FILE *file;
+
+    trace_set_thread_name("import_parse");
+
+    if (strcmp(ctx->options->csv_path, "-") == 0) {
+        file = stdin;
+    } else {
+        file = fopen(ctx->options->csv_path, "r");
+    }
+    if (file == NULL) {
+        perror("Failed to open import file");
+        stats->errors++;
+        bounded_queue_close(&ctx->to_format);
+        return NULL;
+    }
+
+    while (getline(&line, &line_size, file) != -1) {
+        char *fields[IMPORT_MAX_FIELDS];
+        line_number++;
+        trim_line_end(line);
+
+        if (line[0] == '\0' || (line_number == 1 && strncmp(line, "empNumber", 9) == 0)) {
+            continue;
+        }
+
+        int count = split_csv_line(line, fields, IMPORT_MAX_FIELDS);
+        ImportItem *item = (ImportItem *)calloc(1, sizeof(ImportItem));
+        if (item == NULL) {
+            fprintf(stderr, "Memory allocation failed for import record\n");
+            stats->errors++;
+            break;
+        }
+
+        item->line = line_number;
+        if (count < 3 || fields[0][0] == '\0' ||
+            parse_punch_time(fields[1], &item->record.punch_in) != 0 ||
+            parse_punch_time(fields[2], &item->record.punch_out) != 0) {
+            fprintf(stderr, "Line %ld: malformed attendance record, skipped\n", line_number);
+            stats->errors++;
+            free(item);
+            continue;
+        }
+
+        /* Over-long fields are rejected rather than cut (possibly inside a UTF-8 sequence) */
+        if ((size_t)snprintf(item->record.emp_number, sizeof(item->record.emp_number), "%s", fields[0]) >=
+                sizeof(item->record.emp_number) ||
+            (size_t)snprintf(item->record.punch_in_note, sizeof(item->record.punch_in_note), "%s",
+                             count > 3 ? fields[3] : "") >= sizeof(item->record.punch_in_note) ||
+            (size_t)snprintf(item->record.punch_out_note, sizeof(item->record.punch_out_note), "%s",
+                             count > 4 ? fields[4] : "") >= sizeof(item->record.punch_out_note)) {
+            fprintf(stderr, "Line %ld: employee number or note too long, skipped\n", line_number);
+            stats->errors++;
+            free(item);
+            continue;
+        }
+
+        stats->items++;
+        if (bounded_queue_push(&ctx->to_format, item, &stats->wait_ns) != 0) {
+            free(item);
+            break;
+        }
+    }
+
+    free(line);
+    if (file != stdin) {
+        fclose(file);
+    }
+    bounded_queue_close(&ctx->to_format);
+    stats->busy_ns = monotonic_ns() - start - stats->wait_ns;
+    return NULL;
+}
+
+/**
+ * Stage 2: format punch times with per-thread timezone caches
+ */
+static void *format_stage(void *data) {
+    ImportContext *ctx = (ImportContext *)data;
+    ImportStageStats *stats = &ctx->report->stages[IMPORT_STAGE_FORMAT];
+    unsigned long long start = monotonic_ns();
+    TimeFormatCache in_cache;
+    TimeFormatCache out_cache;
+    ImportItem *item;
+
+    trace_set_thread_name("import_format");
+    time_format_cache_init(&in_cache);
+    time_format_cache_init(&out_cache);
+
+    while ((item = (ImportItem *)bounded_queue_pop(&ctx->to_format, &stats->wait_ns)) != NULL) {
+        format_punch_time(&in_cache, item->record.punch_in, &item->punch_in);
+        format_punch_time(&out_cache, item->record.punch_out, &item->punch_out);
+        stats->items++;
+        if (bounded_queue_push(&ctx->to_serialize, item, &stats->wait_ns) != 0) {
+            free(item);
+        }
+    }
+
+    bounded_queue_close(&ctx->to_serialize);
+    stats->busy_ns = monotonic_ns() - start - stats->wait_ns;
+    return NULL;
+}
+
+/**
+ * Stage 3: serialize records into request bodies
+ */
+static void *serialize_stage(void *data) {
+    ImportContext *ctx = (ImportContext *)data;
+    ImportStageStats *stats = &ctx->report->stages[IMPORT_STAGE_SERIALIZE];
+    unsigned long long start = monotonic_ns();
+    ImportItem *item;
+
+    trace_set_thread_name("import_serialize");
+    while ((item = (ImportItem *)bounded_queue_pop(&ctx->to_serialize, &stats->wait_ns)) != NULL) {
+        if (attendance_record_to_json(&item->record, &item->punch_in, &item->punch_out,
+                                      item->json, sizeof(item->json)) < 0) {
+            fprintf(stderr, "Line %ld: record too large to serialize, skipped\n", item->line);
+            stats->errors++;
+            free(item);
+            continue;
+        }
+        stats->items++;
+        if (bounded_queue_push(&ctx->to_submit, item, &stats->wait_ns) != 0) {
+            free(item);
+        }
+    }
+
+    bounded_queue_close(&ctx->to_submit);
+    stats->busy_ns = monotonic_ns() - start - stats->wait_ns;
+    return NULL;
+}
+
+/**
+ * Check the "success" field of a submission response
+ */
+static int response_succeeded(const ResponseBuffer *resp) {
+    TRACE_BEGIN("parse_response");
+    int status = attendance_response_status(resp->buffer, resp->size);
+    TRACE_END("parse_response");
+    return status == ATTENDANCE_ACCEPTED;
+}
+
+/**
+ * Count a submitted record and add it to the local store if accepted
+ */
+static void finish_item(ImportContext *ctx, ImportItem *item, int ok, ImportStageStats *local) {
+    if (ok && ctx->options->store != NULL && !ctx->options->dry_run) {
+        StoredAttendance stored;
+        if (stored_attendance_from_record(&item->record, STORE_SOURCE_IMPORTED, &stored) != 0 ||
+            attendance_store_append(ctx->options->store, &stored, 1) != 0) {
+            fprintf(stderr, "Line %ld: submitted but not added to the local store\n", item->line);
+        }
+    }
+    if (ok) {
+        local->items++;
+    } else {
+        fprintf(stderr, "Line %ld: submission failed\n", item->line);
+        local->errors++;
+    }
+    free(item);
+}
+
+static void add_submit_stats(ImportContext *ctx, const ImportStageStats *local) {
+    pthread_mutex_lock(&ctx->stats_mutex);
+    ImportStageStats *stats = &ctx->report->stages[IMPORT_STAGE_SUBMIT];
+    stats->items += local->items;
+    stats->errors += local->errors;
+    stats->busy_ns += local->busy_ns;
+    stats->wait_ns += local->wait_ns;
+    pthread_mutex_unlock(&ctx->stats_mutex);
+}
+
+/**
+ * Stage 4 with a batcher: queue records and collect their results,
+ * keeping up to one batch per worker in flight
+ */
+static void *batch_submit_stage(void *data) {
+    ImportContext *ctx = (ImportContext *)data;
+    ImportStageStats local;
+    unsigned long long start = monotonic_ns();
+    ImportItem *items[BATCH_MAX_SIZE];
+    Future *futures[BATCH_MAX_SIZE];
+    int window = ctx->options->batch_size < BATCH_MAX_SIZE ? ctx->options->batch_size : BATCH_MAX_SIZE;
+    int head = 0;
+    int pending = 0;
+    ImportItem *item;
+
+    trace_set_thread_name("import_submit");
+    memset(&local, 0, sizeof(local));
+
+    for (;;) {
+        item = pending < window ? (ImportItem *)bounded_queue_pop(&ctx->to_submit, &local.wait_ns) : NULL;
+        if (item != NULL) {
+            int slot = (head + pending) % window;
+            items[slot] = item;
+            futures[slot] = attendance_batcher_submit(ctx->batcher, item->json);
+            pending++;
+            continue;
+        }
+        if (pending == 0) {
+            break;
+        }
+
+        /* Window full or input drained: settle the oldest record */
+        Future *future = futures[head];
+        int ok = future != NULL && future_wait_for(future, -1) == 0 && future_result(future) == 0;
+        future_release(future);
+        finish_item(ctx, items[head], ok, &local);
+        head = (head + 1) % window;
+        pending--;
+    }
+
+    local.busy_ns = monotonic_ns() - start - local.wait_ns;
+    add_submit_stats(ctx, &local);
+    return NULL;
+}
+
+/**
+ * Stage 4: submit records (shared token if the config has a holder,
+ * otherwise one token per worker thread)
+ */
+static void *submit_stage(void *data) {
+    ImportContext *ctx = (ImportContext *)data;
+    ImportStageStats local;
+    unsigned long long start = monotonic_ns();
+    Config thread_config = *ctx->config;
+    ResponseBuffer resp;
+    ImportItem *item;
+    int ready;
+
+    trace_set_thread_name("import_submit");
+    memset(&local, 0, sizeof(local));
+    thread_config.access_token = NULL;
+    thread_config.refresh_token = NULL;
+    thread_config.priority = REQUEST_PRIORITY_BULK;
+
+    ready = response_buffer_init(&resp, MAX_RESPONSE_SIZE) == 0;
+    if (ready && !ctx->options->dry_run &&
+        (thread_config.token_holder != NULL
+         ? token_holder_wait(thread_config.token_holder, IMPORT_TOKEN_WAIT_MS)
+         : get_token(&thread_config)) != 0) {
+        fprintf(stderr, "Import worker failed to obtain access token\n");
+        ready = 0;
+    }
+
+    /* A worker that cannot submit still drains its share so upstream stages finish */
+    while ((item = (ImportItem *)bounded_queue_pop(&ctx->to_submit, &local.wait_ns)) != NULL) {
+        int ok = ready;
+        if (ok && !ctx->options->dry_run) {
+            TRACE_BEGIN("submit_record");
+            ok = post_request(ATTENDANCE_RECORDS_URL, item->json, &thread_config, &resp) == 0 &&
+                 response_succeeded(&resp);
+            TRACE_END("submit_record");
+        }
+        finish_item(ctx, item, ok, &local);
+    }
+
+    mem_free(thread_config.access_token);
+    response_buffer_free(&resp);
+
+    local.busy_ns = monotonic_ns() - start - local.wait_ns;
+    add_submit_stats(ctx, &local);
+    return NULL;
+}
+
+int attendance_import_run(const ImportOptions *options, const Config *config, ImportReport *report) {
+    static const char *stage_names[IMPORT_STAGE_COUNT] = { "parse", "format", "serialize", "submit" };
+    ImportContext ctx;
+    pthread_t stage_threads[3];
+    pthread_t *workers = NULL;
+    int started_workers = 0;
+    int result = -1;
+
+    if (options == NULL || options->csv_path == NULL || config == NULL || report == NULL) {
+        fprintf(stderr, "Invalid parameters for attendance_import_run\n");
+        return -1;
+    }
+
+    int worker_count = options->submit_workers > 0 ? options->submit_workers : IMPORT_DEFAULT_WORKERS;
+    size_t capacity = options->queue_capacity > 0 ? options->queue_capacity : IMPORT_DEFAULT_QUEUE_CAPACITY;
+
+    memset(report, 0, sizeof(ImportReport));
+    for (int i = 0; i < IMPORT_STAGE_COUNT; i++) {
+        report->stages[i].name = stage_names[i];
+        report->stages[i].threads = 1;
+    }
+    report->stages[IMPORT_STAGE_SUBMIT].threads = 0;   /* the workers that actually start */
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.options = options;
+    ctx.config = config;
+    ctx.report = report;
+
+    workers = (pthread_t *)calloc((size_t)worker_count, sizeof(pthread_t));
+    if (workers == NULL) {
+        fprintf(stderr, "Memory allocation failed for import workers\n");
+        return -1;
+    }
+    if (bounded_queue_init(&ctx.to_format, capacity) != 0 ||
+        bounded_queue_init(&ctx.to_serialize, capacity) != 0 ||
+        bounded_queue_init(&ctx.to_submit, capacity) != 0) {
+        goto cleanup;
+    }
+    pthread_mutex_init(&ctx.stats_mutex, NULL);
+
+    if (options->batch_size > 0 && !options->dry_run) {
+        BatchOptions batch_options;
+        Config bulk_config = *config;
+        bulk_config.priority = REQUEST_PRIORITY_BULK;
+        memset(&batch_options, 0, sizeof(batch_options));
+        batch_options.max_size = options->batch_size;
+        batch_options.max_delay_ms = options->batch_delay_ms;
+        batch_options.connections = options->batch_connections;
+        batch_options.bulk = options->batch_bulk;
+        ctx.batcher = attendance_batcher_create(&bulk_config, &batch_options);
+        if (ctx.batcher == NULL) {
+            pthread_mutex_destroy(&ctx.stats_mutex);
+            goto cleanup;
+        }
+    }
+
+    unsigned long long start = monotonic_ns();
+
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&workers[i], NULL, ctx.batcher != NULL ? batch_submit_stage : submit_stage,
+                           &ctx) != 0) {
+            fprintf(stderr, "Error creating import worker %d\n", i);
+            break;
+        }
+        started_workers++;
+    }
+    report->stages[IMPORT_STAGE_SUBMIT].threads = started_workers;
+
+    if (started_workers == 0 ||
+        pthread_create(&stage_threads[2], NULL, serialize_stage, &ctx) != 0) {
+        bounded_queue_close(&ctx.to_submit);
+        goto join_workers;
+    }
+    if (pthread_create(&stage_threads[1], NULL, format_stage, &ctx) != 0) {
+        bounded_queue_close(&ctx.to_serialize);
+        goto join_serialize;
+    }
+    if (pthread_create(&stage_threads[0], NULL, parse_stage, &ctx) != 0) {
+        bounded_queue_close(&ctx.to_format);
+        goto join_format;
+    }
+
+    pthread_join(stage_threads[0], NULL);
+join_format:
+    pthread_join(stage_threads[1], NULL);
+join_serialize:
+    pthread_join(stage_threads[2], NULL);
+join_workers:
+    for (int i = 0; i < started_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    report->elapsed_s = (double)(monotonic_ns() - start) / 1e9;
+    report->submitted = report->stages[IMPORT_STAGE_SUBMIT].items;
+    report->failed = 0;
+    for (int i = 0; i < IMPORT_STAGE_COUNT; i++) {
+        report->failed += report->stages[i].errors;
+    }
+    result = (report->failed == 0 && started_workers > 0) ? 0 : -1;
+
+    attendance_batcher_destroy(ctx.batcher);
+    pthread_mutex_destroy(&ctx.stats_mutex);
+
+cleanup:
+    bounded_queue_free(&ctx.to_format);
+    bounded_queue_free(&ctx.to_serialize);
+    bounded_queue_free(&ctx.to_submit);
+    free(workers);
+    return result;
+}
+
+void attendance_import_print_report(const ImportReport *report, FILE *out) {
+    if (report == NULL || out == NULL) {
+        return;
+    }
+
+    fprintf(out, "%-10s %7s %10s %8s %12s %10s %10s\n",
+            "stage", "threads", "items", "errors", "items/s", "busy(s)", "wait(s)");
+    for (int i = 0; i < IMPORT_STAGE_COUNT; i++) {
+        const ImportStageStats *stats = &report->stages[i];
+        double busy_s = (double)stats->busy_ns / 1e9;
+        /* Per-thread busy time gives the throughput the stage could sustain alone */
+        double per_thread_busy = stats->threads > 0 ? busy_s / stats->threads : busy_s;
+        double rate = per_thread_busy > 0.0 ? (double)stats->items / per_thread_busy : 0.0;
+        fprintf(out, "%-10s %7d %10llu %8llu %12.0f %10.3f %10.3f\n",
+                stats->name, stats->threads, stats->items, stats->errors, rate,
+                busy_s, (double)stats->wait_ns / 1e9);
+    }
+    fprintf(out, "Submitted %llu records, %llu failed, in %.3f s (%.0f records/s)\n",
+            report->submitted, report->failed, report->elapsed_s,
+            report->elapsed_s > 0.0 ? (double)report->submitted / report->elapsed_s : 0.0);
+}
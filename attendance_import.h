@@ -0,0 +1,82 @@
+#ifndef ATTENDANCE_IMPORT_H
+#define ATTENDANCE_IMPORT_H
+
+#include <stdio.h>
+#include "orangehrm_client.h"
+#include "attendance_store.h"
+
+#define IMPORT_DEFAULT_WORKERS 8
+#define IMPORT_DEFAULT_QUEUE_CAPACITY 1024
+
+/**
+ * Pipeline stages, each running on its own thread(s)
+ */
+typedef enum {
+    IMPORT_STAGE_PARSE = 0,
+    IMPORT_STAGE_FORMAT,
+    IMPORT_STAGE_SERIALIZE,
+    IMPORT_STAGE_SUBMIT,
+    IMPORT_STAGE_COUNT
+} ImportStage;
+
+/**
+ * Throughput counters for one stage
+ */
+typedef struct {
+    const char *name;
+    int threads;
+    unsigned long long items;
+    unsigned long long errors;
+    unsigned long long busy_ns;   /* time spent working, summed over threads */
+    unsigned long long wait_ns;   /* time blocked on queues, summed over threads */
+} ImportStageStats;
+
+/**
+ * Result of an import run
+ */
+typedef struct {
+    ImportStageStats stages[IMPORT_STAGE_COUNT];
+    unsigned long long submitted;
+    unsigned long long failed;
+    double elapsed_s;
+} ImportReport;
+
+/**
+ * Import options
+ */
+typedef struct {
+    const char *csv_path;       /* "-" reads stdin */
+    int submit_workers;         /* 0 for IMPORT_DEFAULT_WORKERS */
+    size_t queue_capacity;      /* 0 for IMPORT_DEFAULT_QUEUE_CAPACITY */
+    int dry_run;                /* run every stage except the network submission */
+    AttendanceStore *store;     /* accepted records are appended here (optional) */
+    int batch_size;             /* > 0 submits through an attendance batcher (see attendance_batch.h) */
+    int batch_delay_ms;         /* 0 for BATCH_DEFAULT_DELAY_MS */
+    int batch_connections;      /* 0 for BATCH_DEFAULT_CONNECTIONS */
+    int batch_bulk;             /* > 0 sends batches to the bulk endpoint (BatchOptions.bulk) */
+} ImportOptions;
+
+/**
+ * Stream a CSV file of attendance records into the API.
+ *
+ * Columns: empNumber,punchIn,punchOut[,punchInNote[,punchOutNote]] where the
+ * punch times are epoch seconds or local "YYYY-MM-DD HH:MM[:SS]". A header
+ * row starting with "empNumber" is skipped. Parsing, time formatting, JSON
+ * serialization and submission run as separate stages joined by bounded
+ * queues; each submit worker holds its own token. With batch_size set, the
+ * workers queue records on one batcher instead, each keeping up to a batch
+ * of them in flight, and the batcher sends them in batches.
+ *
+ * @param options Import options
+ * @param config Credentials (read only, shared by all workers)
+ * @param report Receives per-stage statistics
+ * @return 0 if every record was submitted, -1 otherwise
+ */
+int attendance_import_run(const ImportOptions *options, const Config *config, ImportReport *report);
+
+/**
+ * Print a per-stage throughput table
+ */
+void attendance_import_print_report(const ImportReport *report, FILE *out);
+
+#endif /* ATTENDANCE_IMPORT_H */
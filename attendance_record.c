@@ -0,0 +1,108 @@
+#include "attendance_record.h"
+#include "json_scan.h"
+#include "orangehrm_api.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SECONDS_PER_DAY 86400
+
+void time_format_cache_init(TimeFormatCache *cache) {
+    memset(cache, 0, sizeof(TimeFormatCache));
+}
+
+/**
+ * Recompute the cached day around raw_time.
+ * The cache covers the whole local day only when the offset is the same at
+ * midnight, at raw_time and at the end of the day (i.e. no DST switch).
+ */
+static void refill_cache(TimeFormatCache *cache, time_t raw_time) {
+    struct tm tm_info;
+    struct tm tm_edge;
+
+    if (localtime_r(&raw_time, &tm_info) == NULL) {
+        snprintf(cache->day, sizeof(cache->day), "1970-01-01");
+        snprintf(cache->time_zone, sizeof(cache->time_zone), "+0.0");
+        cache->day_start = raw_time;
+        cache->valid_until = raw_time + 1;
+        return;
+    }
+
+    int timezone_offset_in_minutes = (int)(tm_info.tm_gmtoff / 60);
+    strftime(cache->day, sizeof(cache->day), "%Y-%m-%d", &tm_info);
+    snprintf(cache->time_zone, sizeof(cache->time_zone), "%+05.1f", timezone_offset_in_minutes / 60.0f);
+
+    cache->day_start = raw_time - (tm_info.tm_hour * 3600 + tm_info.tm_min * 60 + tm_info.tm_sec);
+    cache->valid_until = cache->day_start + SECONDS_PER_DAY;
+
+    time_t day_end = cache->valid_until - 1;
+    int stable = localtime_r(&cache->day_start, &tm_edge) != NULL &&
+                 tm_edge.tm_gmtoff == tm_info.tm_gmtoff && tm_edge.tm_hour == 0 && tm_edge.tm_min == 0 &&
+                 localtime_r(&day_end, &tm_edge) != NULL &&
+                 tm_edge.tm_gmtoff == tm_info.tm_gmtoff && tm_edge.tm_mday == tm_info.tm_mday;
+
+    if (!stable) {
+        /* Offset changes during this day: cache only the current wall-clock minute */
+        cache->valid_until = raw_time - tm_info.tm_sec + 60;
+        if (cache->valid_until <= raw_time) {
+            cache->valid_until = raw_time + 1;
+        }
+    }
+}
+
+void format_punch_time(TimeFormatCache *cache, time_t raw_time, FormattedPunch *out) {
+    if (raw_time < cache->day_start || raw_time >= cache->valid_until) {
+        refill_cache(cache, raw_time);
+    }
+
+    long seconds = (long)(raw_time - cache->day_start);
+    int hours = (int)(seconds / 3600);
+    int minutes = (int)((seconds / 60) % 60);
+
+    memcpy(out->day, cache->day, sizeof(out->day));
+    memcpy(out->time_zone, cache->time_zone, sizeof(out->time_zone));
+    out->time[0] = (char)('0' + hours / 10);
+    out->time[1] = (char)('0' + hours % 10);
+    out->time[2] = ':';
+    out->time[3] = (char)('0' + minutes / 10);
+    out->time[4] = (char)('0' + minutes % 10);
+    out->time[5] = '\0';
+}
+
+int attendance_record_to_json(const AttendanceRecord *record, const FormattedPunch *in,
+                              const FormattedPunch *out, char *buffer, size_t size) {
+    OhrmAttendanceRecordCreate body;
+
+    if (record == NULL || in == NULL || out == NULL || buffer == NULL) {
+        return -1;
+    }
+
+    body.emp_number = record->emp_number;
+    body.punch_in_date = in->day;
+    body.punch_in_time = in->time;
+    body.punch_in_timezone_offset = in->time_zone;
+    body.punch_in_note = record->punch_in_note;
+    body.punch_out_date = out->day;
+    body.punch_out_time = out->time;
+    body.punch_out_timezone_offset = out->time_zone;
+    body.punch_out_note = record->punch_out_note;
+    return ohrm_attendance_record_create_to_json(&body, buffer, size);
+}
+
+int attendance_response_status(const char *body, size_t length) {
+    JsonSlice success;
+
+    switch (json_scan_find(body, length, "success", &success)) {
+    case JSON_SCAN_FOUND:
+        break;
+    case JSON_SCAN_NOT_FOUND:
+        return ATTENDANCE_ACCEPTED;
+    default:
+        return ATTENDANCE_INVALID_RESPONSE;
+    }
+
+    if (success.type == JSON_SCAN_FALSE ||
+        (success.type == JSON_SCAN_STRING && success.length == 5 && memcmp(success.ptr, "false", 5) == 0)) {
+        return ATTENDANCE_REJECTED;
+    }
+    return ATTENDANCE_ACCEPTED;
+}
@@ -0,0 +1,84 @@
+#ifndef ATTENDANCE_RECORD_H
+#define ATTENDANCE_RECORD_H
+
+#include <stddef.h>
+#include <time.h>
+#include "orangehrm_api_types.h"
+
+#define ATTENDANCE_RECORDS_URL OHRM_CREATE_ATTENDANCE_RECORD_PATH
+#define ATTENDANCE_EMP_NUMBER_SIZE 32
+#define ATTENDANCE_NOTE_SIZE 128
+#define ATTENDANCE_JSON_SIZE 1024
+
+/**
+ * One attendance record (punch in and punch out)
+ */
+typedef struct {
+    char emp_number[ATTENDANCE_EMP_NUMBER_SIZE];
+    time_t punch_in;
+    time_t punch_out;
+    char punch_in_note[ATTENDANCE_NOTE_SIZE];
+    char punch_out_note[ATTENDANCE_NOTE_SIZE];
+} AttendanceRecord;
+
+/**
+ * Local date, time and timezone offset strings for one punch
+ */
+typedef struct {
+    char day[16];       /* YYYY-MM-DD */
+    char time[8];       /* HH:MM */
+    char time_zone[16]; /* +05.5 */
+} FormattedPunch;
+
+/**
+ * Caches the local day and UTC offset of the last formatted timestamp,
+ * so punches on the same day are formatted without localtime/strftime.
+ * Not thread safe: use one cache per thread.
+ */
+typedef struct {
+    time_t day_start;   /* local midnight of the cached day */
+    time_t valid_until; /* first second not covered by the cached offset */
+    char day[16];
+    char time_zone[16];
+} TimeFormatCache;
+
+/**
+ * Reset a time format cache
+ */
+void time_format_cache_init(TimeFormatCache *cache);
+
+/**
+ * Format a timestamp as local day, time and timezone offset
+ * @param cache Per-thread cache
+ * @param raw_time Timestamp to format
+ * @param out Receives the formatted strings
+ */
+void format_punch_time(TimeFormatCache *cache, time_t raw_time, FormattedPunch *out);
+
+/**
+ * Serialize a record into the JSON body expected by ATTENDANCE_RECORDS_URL
+ * @param record Record to serialize
+ * @param in Formatted punch in time
+ * @param out Formatted punch out time
+ * @param buffer Destination buffer
+ * @param size Destination size
+ * @return Length of the JSON text on success, -1 if it did not fit
+ */
+int attendance_record_to_json(const AttendanceRecord *record, const FormattedPunch *in,
+                              const FormattedPunch *out, char *buffer, size_t size);
+
+#define ATTENDANCE_ACCEPTED 1
+#define ATTENDANCE_REJECTED 0
+#define ATTENDANCE_INVALID_RESPONSE (-1)
+
+/**
+ * Classify a submission response by its "success" field without building a
+ * JSON tree (a missing field counts as accepted)
+ * @param body Response body
+ * @param length Body length in bytes
+ * @return ATTENDANCE_ACCEPTED, ATTENDANCE_REJECTED, or
+ *         ATTENDANCE_INVALID_RESPONSE if the body is not JSON
+ */
+int attendance_response_status(const char *body, size_t length);
+
+#endif /* ATTENDANCE_RECORD_H */
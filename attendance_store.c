@@ -0,0 +1,797 @@
+#include "attendance_store.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STORE_SEGMENT_MAGIC "ORGATTS1"
+#define STORE_INDEX_MAGIC "ORGATTI1"
+#define STORE_VERSION 1
+#define STORE_BLOCKS_PER_SEGMENT (STORE_SEGMENT_RECORDS / STORE_BLOCK_RECORDS)
+#define STORE_APPEND_BATCH 256
+#define STORE_PATH_SIZE 1024
+
+/**
+ * Segment file header (64 bytes); STORE_SEGMENT_RECORDS record slots follow.
+ * The file is created at full size, so unused slots read as zeroes.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint32_t number;
+    int64_t created_at;
+    uint8_t padding[32];
+} StoreSegmentHeader;
+
+/**
+ * Index file header (32 bytes); block_count StoreBlockIndex entries follow
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t block_count;
+    uint32_t reserved;
+    int64_t sealed_at;
+} StoreIndexHeader;
+
+typedef struct {
+    AttendanceColumns *columns;
+    int failed;
+} ColumnsVisit;
+
+static void segment_path(const AttendanceStore *store, uint32_t number, const char *extension,
+                         char *path, size_t size) {
+    snprintf(path, size, "%s/%08u.%s", store->directory, number, extension);
+}
+
+/**
+ * FNV-1a over everything but the checksum field
+ */
+static uint32_t record_checksum(const StoredAttendance *record) {
+    const unsigned char *bytes = (const unsigned char *)record;
+    uint32_t h = 2166136261U;
+
+    for (size_t i = 0; i < offsetof(StoredAttendance, checksum); i++) {
+        h ^= bytes[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/* ---- Zone maps ---- */
+
+static void zone_reset(StoreBlockIndex *zone) {
+    zone->min_punch_in = INT64_MAX;
+    zone->max_punch_in = INT64_MIN;
+    zone->min_emp = INT32_MAX;
+    zone->max_emp = INT32_MIN;
+}
+
+static void zone_add(StoreBlockIndex *zone, const StoredAttendance *record) {
+    if (record->punch_in < zone->min_punch_in) zone->min_punch_in = record->punch_in;
+    if (record->punch_in > zone->max_punch_in) zone->max_punch_in = record->punch_in;
+    if (record->emp_number < zone->min_emp) zone->min_emp = record->emp_number;
+    if (record->emp_number > zone->max_emp) zone->max_emp = record->emp_number;
+}
+
+static void zone_merge(StoreBlockIndex *zone, const StoreBlockIndex *other) {
+    if (other->min_punch_in < zone->min_punch_in) zone->min_punch_in = other->min_punch_in;
+    if (other->max_punch_in > zone->max_punch_in) zone->max_punch_in = other->max_punch_in;
+    if (other->min_emp < zone->min_emp) zone->min_emp = other->min_emp;
+    if (other->max_emp > zone->max_emp) zone->max_emp = other->max_emp;
+}
+
+/**
+ * Can the zone hold a record of emp_number punched in within [from, to)?
+ * Empty zones never match.
+ */
+static int zone_matches(const StoreBlockIndex *zone, int32_t emp_number, int64_t from, int64_t to) {
+    if (zone->max_punch_in < from || zone->min_punch_in >= to) {
+        return 0;
+    }
+    return emp_number == STORE_ANY_EMPLOYEE ||
+           (emp_number >= zone->min_emp && emp_number <= zone->max_emp);
+}
+
+/* ---- Segment files ---- */
+
+static int pwrite_all(int fd, const void *data, size_t length, off_t offset) {
+    const char *p = (const char *)data;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fd, p, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += written;
+        offset += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static StoreSegment *push_segment(AttendanceStore *store, uint32_t number) {
+    if (store->segment_count == store->segment_capacity) {
+        size_t capacity = store->segment_capacity == 0 ? 16 : store->segment_capacity * 2;
+        StoreSegment *grown = (StoreSegment *)realloc(store->segments, capacity * sizeof(StoreSegment));
+        if (grown == NULL) {
+            fprintf(stderr, "Memory allocation failed for attendance store segments\n");
+            return NULL;
+        }
+        store->segments = grown;
+        store->segment_capacity = capacity;
+    }
+
+    StoreSegment *segment = &store->segments[store->segment_count];
+    memset(segment, 0, sizeof(*segment));
+    segment->number = number;
+    segment->blocks = (StoreBlockIndex *)malloc(STORE_BLOCKS_PER_SEGMENT * sizeof(StoreBlockIndex));
+    if (segment->blocks == NULL) {
+        fprintf(stderr, "Memory allocation failed for attendance store index\n");
+        return NULL;
+    }
+    for (size_t b = 0; b < STORE_BLOCKS_PER_SEGMENT; b++) {
+        zone_reset(&segment->blocks[b]);
+    }
+    zone_reset(&segment->range);
+    store->segment_count++;
+    return segment;
+}
+
+/**
+ * Drop a segment pushed last (open failed half way)
+ */
+static void pop_segment(AttendanceStore *store) {
+    StoreSegment *segment = &store->segments[--store->segment_count];
+    if (segment->map != NULL) {
+        munmap(segment->map, segment->map_size);
+    }
+    free(segment->blocks);
+}
+
+/**
+ * Map a segment file and validate its header
+ * @return Open read-write descriptor on success, -1 on failure
+ */
+static int map_segment(const AttendanceStore *store, StoreSegment *segment) {
+    char path[STORE_PATH_SIZE];
+    struct stat st;
+    size_t expected = sizeof(StoreSegmentHeader) + (size_t)STORE_SEGMENT_RECORDS * sizeof(StoredAttendance);
+
+    segment_path(store, segment->number, "seg", path, sizeof(path));
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        perror("Failed to open attendance store segment");
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != expected) {
+        fprintf(stderr, "Attendance store segment %s has the wrong size\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, expected, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Failed to map attendance store segment");
+        close(fd);
+        return -1;
+    }
+
+    const StoreSegmentHeader *header = (const StoreSegmentHeader *)map;
+    if (memcmp(header->magic, STORE_SEGMENT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != STORE_VERSION || header->record_size != sizeof(StoredAttendance) ||
+        header->capacity != STORE_SEGMENT_RECORDS || header->number != segment->number) {
+        fprintf(stderr, "Attendance store segment %s is invalid\n", path);
+        munmap(map, expected);
+        close(fd);
+        return -1;
+    }
+
+    segment->map = map;
+    segment->map_size = expected;
+    segment->records = (const StoredAttendance *)((const char *)map + sizeof(StoreSegmentHeader));
+    return fd;
+}
+
+/**
+ * Count the valid records of a mapped segment from segment->count on and
+ * extend its zone maps; the first slot failing its checksum ends the segment
+ */
+static void scan_segment(StoreSegment *segment) {
+    size_t count = segment->count;
+
+    while (count < STORE_SEGMENT_RECORDS &&
+           segment->records[count].checksum == record_checksum(&segment->records[count])) {
+        zone_add(&segment->blocks[count / STORE_BLOCK_RECORDS], &segment->records[count]);
+        zone_add(&segment->range, &segment->records[count]);
+        count++;
+    }
+    segment->count = count;
+}
+
+/**
+ * Load the zone maps of a sealed segment from its index file
+ * @return 0 on success, -1 if the index is missing or invalid
+ */
+static int load_index(const AttendanceStore *store, StoreSegment *segment) {
+    char path[STORE_PATH_SIZE];
+    StoreIndexHeader header;
+    int result = -1;
+
+    segment_path(store, segment->number, "idx", path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, STORE_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == STORE_VERSION && header.record_count <= STORE_SEGMENT_RECORDS &&
+        header.block_count == (header.record_count + STORE_BLOCK_RECORDS - 1) / STORE_BLOCK_RECORDS &&
+        fread(segment->blocks, sizeof(StoreBlockIndex), header.block_count, file) == header.block_count) {
+        segment->count = header.record_count;
+        for (uint32_t b = 0; b < header.block_count; b++) {
+            zone_merge(&segment->range, &segment->blocks[b]);
+        }
+        result = 0;
+    }
+    fclose(file);
+    return result;
+}
+
+/**
+ * Write the zone maps of a full segment to a temporary file and rename it
+ * into place
+ */
+static int write_index(const AttendanceStore *store, const StoreSegment *segment) {
+    char path[STORE_PATH_SIZE];
+    char tmp_path[STORE_PATH_SIZE + 4];
+    StoreIndexHeader header;
+    int result = -1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = STORE_VERSION;
+    header.record_count = (uint32_t)segment->count;
+    header.block_count = (uint32_t)((segment->count + STORE_BLOCK_RECORDS - 1) / STORE_BLOCK_RECORDS);
+    header.sealed_at = (int64_t)time(NULL);
+
+    segment_path(store, segment->number, "idx", path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        perror("Failed to create attendance store index");
+        return -1;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(segment->blocks, sizeof(StoreBlockIndex), header.block_count, file) == header.block_count &&
+        fflush(file) == 0 && fsync(fileno(file)) == 0) {
+        result = 0;
+    } else {
+        perror("Failed to write attendance store index");
+    }
+    fclose(file);
+
+    if (result == 0 && rename(tmp_path, path) != 0) {
+        perror("Failed to replace attendance store index");
+        result = -1;
+    }
+    if (result != 0) {
+        unlink(tmp_path);
+    }
+    return result;
+}
+
+/**
+ * Flush the full active segment and write its index (caller holds the write lock).
+ * A failed index write is not fatal: the index is rebuilt on the next open.
+ */
+static void seal_active(AttendanceStore *store) {
+    StoreSegment *segment = &store->segments[store->segment_count - 1];
+
+    if (fdatasync(store->active_fd) != 0) {
+        perror("Failed to flush attendance store segment");
+    }
+    write_index(store, segment);
+    close(store->active_fd);
+    store->active_fd = -1;
+}
+
+/**
+ * Create the next segment at full size and make it active (caller holds the
+ * write lock and the lock file). The file only appears under its final name
+ * once its header is written, so a crash cannot leave a half-created segment
+ * behind; it is published with link(), which fails instead of replacing a
+ * segment that already exists.
+ */
+static int create_segment(AttendanceStore *store) {
+    char path[STORE_PATH_SIZE];
+    char tmp_path[STORE_PATH_SIZE + 4];
+    StoreSegmentHeader header;
+    uint32_t number = store->segment_count > 0 ? store->segments[store->segment_count - 1].number + 1 : 1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = STORE_VERSION;
+    header.record_size = sizeof(StoredAttendance);
+    header.capacity = STORE_SEGMENT_RECORDS;
+    header.number = number;
+    header.created_at = (int64_t)time(NULL);
+
+    segment_path(store, number, "seg", path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Failed to create attendance store segment");
+        return -1;
+    }
+    off_t size = (off_t)(sizeof(header) + (size_t)STORE_SEGMENT_RECORDS * sizeof(StoredAttendance));
+    int ok = pwrite_all(fd, &header, sizeof(header), 0) == 0 && ftruncate(fd, size) == 0 &&
+             fsync(fd) == 0 && link(tmp_path, path) == 0;
+    if (!ok) {
+        if (errno == EEXIST) {
+            fprintf(stderr, "Attendance store segment %s already exists\n", path);
+        } else {
+            perror("Failed to create attendance store segment");
+        }
+    }
+    close(fd);
+    unlink(tmp_path);
+    if (!ok) {
+        return -1;
+    }
+
+    StoreSegment *segment = push_segment(store, number);
+    if (segment == NULL) {
+        return -1;
+    }
+    fd = map_segment(store, segment);
+    if (fd < 0) {
+        pop_segment(store);
+        return -1;
+    }
+    store->active_fd = fd;
+    return 0;
+}
+
+/**
+ * Pick up records and segments appended by other processes since this
+ * handle last looked (caller holds the write lock and the lock file)
+ */
+static int refresh_tail(AttendanceStore *store) {
+    char path[STORE_PATH_SIZE];
+
+    if (store->segment_count > 0) {
+        StoreSegment *segment = &store->segments[store->segment_count - 1];
+        scan_segment(segment);
+        if (segment->count == STORE_SEGMENT_RECORDS && store->active_fd >= 0) {
+            /* Filled and sealed by another process */
+            close(store->active_fd);
+            store->active_fd = -1;
+        }
+    }
+
+    for (;;) {
+        uint32_t number = store->segment_count > 0 ? store->segments[store->segment_count - 1].number + 1 : 1;
+        segment_path(store, number, "seg", path, sizeof(path));
+        if (access(path, F_OK) != 0) {
+            return 0;
+        }
+
+        StoreSegment *segment = push_segment(store, number);
+        if (segment == NULL) {
+            return -1;
+        }
+        int fd = map_segment(store, segment);
+        if (fd < 0) {
+            pop_segment(store);
+            return -1;
+        }
+        scan_segment(segment);
+        if (store->active_fd >= 0) {
+            close(store->active_fd);
+        }
+        store->active_fd = segment->count < STORE_SEGMENT_RECORDS ? fd : -1;
+        if (store->active_fd < 0) {
+            close(fd);
+        }
+    }
+}
+
+static int lock_writers(AttendanceStore *store) {
+    while (flock(store->lock_fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            perror("Failed to lock attendance store");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void unlock_writers(AttendanceStore *store) {
+    flock(store->lock_fd, LOCK_UN);
+}
+
+/* ---- Opening ---- */
+
+static int compare_numbers(const void *a, const void *b) {
+    uint32_t left = *(const uint32_t *)a;
+    uint32_t right = *(const uint32_t *)b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * Collect the numbers of all segment files in the store directory
+ * @return Number of segments, -1 on failure
+ */
+static long list_segments(const char *directory, uint32_t **numbers) {
+    DIR *dir = opendir(directory);
+    struct dirent *entry;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    *numbers = NULL;
+    if (dir == NULL) {
+        perror("Failed to open attendance store directory");
+        return -1;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned int number;
+        char suffix[8];
+        if (strlen(entry->d_name) != 12 || sscanf(entry->d_name, "%8u.%3s", &number, suffix) != 2 ||
+            strcmp(suffix, "seg") != 0 || number == 0) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity == 0 ? 16 : capacity * 2;
+            uint32_t *grown = (uint32_t *)realloc(*numbers, capacity * sizeof(uint32_t));
+            if (grown == NULL) {
+                fprintf(stderr, "Memory allocation failed while listing attendance segments\n");
+                free(*numbers);
+                *numbers = NULL;
+                closedir(dir);
+                return -1;
+            }
+            *numbers = grown;
+        }
+        (*numbers)[count++] = number;
+    }
+    closedir(dir);
+
+    if (count > 1) {
+        qsort(*numbers, count, sizeof(uint32_t), compare_numbers);
+    }
+    return (long)count;
+}
+
+/**
+ * Map every segment; sealed ones load their index (rebuilding a missing
+ * one), the last one is scanned and stays open for appends while it has room
+ */
+static int open_segments(AttendanceStore *store) {
+    uint32_t *numbers;
+    long count = list_segments(store->directory, &numbers);
+    int result = 0;
+
+    if (count < 0) {
+        return -1;
+    }
+
+    for (long i = 0; i < count; i++) {
+        StoreSegment *segment = push_segment(store, numbers[i]);
+        if (segment == NULL) {
+            result = -1;
+            break;
+        }
+        int fd = map_segment(store, segment);
+        if (fd < 0) {
+            pop_segment(store);
+            result = -1;
+            break;
+        }
+
+        int last = i == count - 1;
+        if (last || load_index(store, segment) != 0) {
+            scan_segment(segment);
+            if (!last || segment->count == STORE_SEGMENT_RECORDS) {
+                write_index(store, segment);
+            }
+        }
+        if (last && segment->count < STORE_SEGMENT_RECORDS) {
+            store->active_fd = fd;
+        } else {
+            close(fd);
+        }
+    }
+
+    free(numbers);
+    return result;
+}
+
+int attendance_store_open(AttendanceStore *store, const char *directory) {
+    if (store == NULL) {
+        return -1;
+    }
+
+    memset(store, 0, sizeof(AttendanceStore));
+    store->active_fd = -1;
+    store->lock_fd = -1;
+    store->directory = strdup(directory != NULL ? directory : ATTENDANCE_STORE_DIR);
+    if (store->directory == NULL) {
+        fprintf(stderr, "Memory allocation failed for attendance store path\n");
+        return -1;
+    }
+    pthread_rwlock_init(&store->lock, NULL);
+
+    if (mkdir(store->directory, 0755) != 0 && errno != EEXIST) {
+        perror("Failed to create attendance store directory");
+        attendance_store_close(store);
+        return -1;
+    }
+
+    char lock_path[STORE_PATH_SIZE];
+    snprintf(lock_path, sizeof(lock_path), "%s/%s", store->directory, STORE_LOCK_FILE);
+    store->lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (store->lock_fd < 0) {
+        perror("Failed to open attendance store lock file");
+        attendance_store_close(store);
+        return -1;
+    }
+
+    /* Opening rebuilds indexes, so it excludes writers too */
+    if (lock_writers(store) != 0) {
+        attendance_store_close(store);
+        return -1;
+    }
+    int result = open_segments(store);
+    unlock_writers(store);
+    if (result != 0) {
+        fprintf(stderr, "Failed to open attendance store %s\n", store->directory);
+        attendance_store_close(store);
+        return -1;
+    }
+    return 0;
+}
+
+void attendance_store_close(AttendanceStore *store) {
+    if (store == NULL || store->directory == NULL) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&store->lock);
+    if (store->active_fd >= 0) {
+        close(store->active_fd);
+        store->active_fd = -1;
+    }
+    while (store->segment_count > 0) {
+        pop_segment(store);
+    }
+    free(store->segments);
+    store->segments = NULL;
+    store->segment_capacity = 0;
+    if (store->lock_fd >= 0) {
+        close(store->lock_fd);
+        store->lock_fd = -1;
+    }
+    pthread_rwlock_unlock(&store->lock);
+
+    pthread_rwlock_destroy(&store->lock);
+    free(store->directory);
+    store->directory = NULL;
+}
+
+/* ---- Appending ---- */
+
+int attendance_store_append(AttendanceStore *store, const StoredAttendance *records, size_t count) {
+    StoredAttendance batch[STORE_APPEND_BATCH];
+    size_t done = 0;
+    int result = 0;
+
+    if (store == NULL || store->directory == NULL || (records == NULL && count > 0)) {
+        return -1;
+    }
+
+    pthread_rwlock_wrlock(&store->lock);
+    if (lock_writers(store) != 0) {
+        pthread_rwlock_unlock(&store->lock);
+        return -1;
+    }
+    if (refresh_tail(store) != 0) {
+        result = -1;
+    }
+    while (result == 0 && done < count) {
+        if (store->active_fd < 0 && create_segment(store) != 0) {
+            result = -1;
+            break;
+        }
+
+        StoreSegment *segment = &store->segments[store->segment_count - 1];
+        size_t n = count - done;
+        if (n > STORE_SEGMENT_RECORDS - segment->count) n = STORE_SEGMENT_RECORDS - segment->count;
+        if (n > STORE_APPEND_BATCH) n = STORE_APPEND_BATCH;
+
+        memcpy(batch, records + done, n * sizeof(StoredAttendance));
+        for (size_t i = 0; i < n; i++) {
+            batch[i].checksum = record_checksum(&batch[i]);
+        }
+        off_t offset = (off_t)(sizeof(StoreSegmentHeader) + segment->count * sizeof(StoredAttendance));
+        if (pwrite_all(store->active_fd, batch, n * sizeof(StoredAttendance), offset) != 0) {
+            perror("Failed to append to attendance store");
+            result = -1;
+            break;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            zone_add(&segment->blocks[segment->count / STORE_BLOCK_RECORDS], &batch[i]);
+            zone_add(&segment->range, &batch[i]);
+            segment->count++;
+        }
+        done += n;
+
+        if (segment->count == STORE_SEGMENT_RECORDS) {
+            seal_active(store);
+        }
+    }
+    unlock_writers(store);
+    pthread_rwlock_unlock(&store->lock);
+    return result;
+}
+
+int attendance_store_append_columns(AttendanceStore *store, const AttendanceColumns *columns, StoreSource source) {
+    StoredAttendance batch[STORE_APPEND_BATCH];
+
+    for (size_t base = 0; base < columns->count; base += STORE_APPEND_BATCH) {
+        size_t n = columns->count - base < STORE_APPEND_BATCH ? columns->count - base : STORE_APPEND_BATCH;
+        memset(batch, 0, n * sizeof(StoredAttendance));
+        for (size_t i = 0; i < n; i++) {
+            batch[i].emp_number = columns->emp_number[base + i];
+            batch[i].punch_in_offset = columns->punch_in_offset[base + i];
+            batch[i].punch_out_offset = columns->punch_out_offset[base + i];
+            batch[i].punch_in = columns->punch_in[base + i];
+            batch[i].punch_out = columns->punch_out[base + i];
+            batch[i].source = (uint32_t)source;
+        }
+        if (attendance_store_append(store, batch, n) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int attendance_store_sync(AttendanceStore *store) {
+    int result = 0;
+
+    if (store == NULL || store->directory == NULL) {
+        return -1;
+    }
+
+    /* The read lock is enough: the descriptor is only closed under the write lock */
+    pthread_rwlock_rdlock(&store->lock);
+    if (store->active_fd >= 0 && fdatasync(store->active_fd) != 0) {
+        perror("Failed to flush attendance store");
+        result = -1;
+    }
+    pthread_rwlock_unlock(&store->lock);
+    return result;
+}
+
+/* ---- Queries ---- */
+
+long attendance_store_query(AttendanceStore *store, int32_t emp_number, int64_t from, int64_t to,
+                            StoreVisitor visitor, void *data) {
+    long visited = 0;
+
+    if (store == NULL || store->directory == NULL || visitor == NULL) {
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&store->lock);
+    for (size_t s = 0; s < store->segment_count; s++) {
+        const StoreSegment *segment = &store->segments[s];
+        if (!zone_matches(&segment->range, emp_number, from, to)) {
+            continue;
+        }
+
+        for (size_t b = 0; b * STORE_BLOCK_RECORDS < segment->count; b++) {
+            if (!zone_matches(&segment->blocks[b], emp_number, from, to)) {
+                continue;
+            }
+            size_t end = (b + 1) * STORE_BLOCK_RECORDS;
+            if (end > segment->count) {
+                end = segment->count;
+            }
+            for (size_t i = b * STORE_BLOCK_RECORDS; i < end; i++) {
+                const StoredAttendance *record = &segment->records[i];
+                if (record->punch_in < from || record->punch_in >= to ||
+                    (emp_number != STORE_ANY_EMPLOYEE && record->emp_number != emp_number)) {
+                    continue;
+                }
+                visited++;
+                if (visitor(record, data) != 0) {
+                    goto done;
+                }
+            }
+        }
+    }
+
+done:
+    pthread_rwlock_unlock(&store->lock);
+    return visited;
+}
+
+static int append_to_columns(const StoredAttendance *record, void *data) {
+    ColumnsVisit *visit = (ColumnsVisit *)data;
+
+    if (attendance_columns_append(visit->columns, record->emp_number, record->punch_in, record->punch_out,
+                                  record->punch_in_offset, record->punch_out_offset) != 0) {
+        visit->failed = 1;
+        return 1;
+    }
+    return 0;
+}
+
+long attendance_store_query_columns(AttendanceStore *store, int32_t emp_number, int64_t from, int64_t to,
+                                    AttendanceColumns *columns) {
+    ColumnsVisit visit = { columns, 0 };
+
+    long visited = attendance_store_query(store, emp_number, from, to, append_to_columns, &visit);
+    return visit.failed ? -1 : visited;
+}
+
+size_t attendance_store_count(AttendanceStore *store) {
+    size_t count = 0;
+
+    if (store == NULL || store->directory == NULL) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&store->lock);
+    for (size_t s = 0; s < store->segment_count; s++) {
+        count += store->segments[s].count;
+    }
+    pthread_rwlock_unlock(&store->lock);
+    return count;
+}
+
+static int16_t utc_offset_minutes(time_t when) {
+    struct tm local;
+
+    if (when == 0 || localtime_r(&when, &local) == NULL) {
+        return 0;
+    }
+    return (int16_t)(local.tm_gmtoff / 60);
+}
+
+int stored_attendance_from_record(const AttendanceRecord *record, StoreSource source, StoredAttendance *out) {
+    char *end = NULL;
+
+    errno = 0;
+    long emp_number = strtol(record->emp_number, &end, 10);
+    if (end == record->emp_number || *end != '\0' || errno != 0 || emp_number < 0 || emp_number > INT32_MAX) {
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->emp_number = (int32_t)emp_number;
+    out->punch_in = (int64_t)record->punch_in;
+    out->punch_out = (int64_t)record->punch_out;
+    out->punch_in_offset = utc_offset_minutes(record->punch_in);
+    out->punch_out_offset = utc_offset_minutes(record->punch_out);
+    out->source = (uint32_t)source;
+    return 0;
+}
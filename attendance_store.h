@@ -0,0 +1,150 @@
+#ifndef ATTENDANCE_STORE_H
+#define ATTENDANCE_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "attendance_columns.h"
+#include "attendance_record.h"
+
+#define ATTENDANCE_STORE_DIR "attendance_store"
+#define STORE_SEGMENT_RECORDS 131072    /* records per segment file (4 MiB) */
+#define STORE_BLOCK_RECORDS 1024        /* records per zone map entry */
+#define STORE_ANY_EMPLOYEE (-1)
+#define STORE_LOCK_FILE "lock"          /* in the store directory, serializes writers across processes */
+
+typedef enum {
+    STORE_SOURCE_SUBMITTED = 1,         /* punched in the client and accepted by the server */
+    STORE_SOURCE_IMPORTED,              /* accepted by a bulk import */
+    STORE_SOURCE_FETCHED                /* read back from the API */
+} StoreSource;
+
+/**
+ * Attendance record as stored in a segment (fixed layout, 32 bytes)
+ */
+typedef struct {
+    int32_t emp_number;
+    int16_t punch_in_offset;            /* UTC offset in minutes */
+    int16_t punch_out_offset;
+    int64_t punch_in;                   /* UTC epoch seconds */
+    int64_t punch_out;                  /* 0 if the record is still open */
+    uint32_t source;                    /* StoreSource */
+    uint32_t checksum;                  /* set by the store; detects torn appends */
+} StoredAttendance;
+
+/**
+ * Zone map of one block of STORE_BLOCK_RECORDS records
+ */
+typedef struct {
+    int64_t min_punch_in;
+    int64_t max_punch_in;
+    int32_t min_emp;
+    int32_t max_emp;
+} StoreBlockIndex;
+
+/**
+ * One segment file, mapped read-only; appends go through pwrite
+ */
+typedef struct {
+    uint32_t number;
+    void *map;
+    size_t map_size;
+    const StoredAttendance *records;
+    size_t count;
+    StoreBlockIndex range;              /* zone map of the whole segment */
+    StoreBlockIndex *blocks;            /* STORE_SEGMENT_RECORDS / STORE_BLOCK_RECORDS entries */
+} StoreSegment;
+
+/**
+ * Append-only attendance store.
+ *
+ * Records are appended to fixed-size segment files in a directory. Each
+ * segment keeps a sparse zone map (punch in and employee range per block of
+ * STORE_BLOCK_RECORDS records), written next to it as an index file once the
+ * segment is full, so a query only touches the blocks that can match. Reads
+ * go straight to the mapped segments. A record torn by a crash fails its
+ * checksum and is dropped when the store is reopened.
+ *
+ * Several processes may append to one store (the GUI, orangehrm_import,
+ * orangehrm_store): each append holds an exclusive flock on the store's
+ * lock file and first picks up the records and segments other processes
+ * added. Queries see those records after the next append or a reopen.
+ */
+typedef struct {
+    char *directory;
+    StoreSegment *segments;
+    size_t segment_count;
+    size_t segment_capacity;
+    int active_fd;                      /* last segment while it has room, -1 otherwise */
+    int lock_fd;                        /* STORE_LOCK_FILE, flocked while writing */
+    pthread_rwlock_t lock;              /* queries read, appends write */
+} AttendanceStore;
+
+/**
+ * Called for every record matching a query (under the store's read lock,
+ * so it must not append)
+ * @return 0 to continue, non-zero to stop the query
+ */
+typedef int (*StoreVisitor)(const StoredAttendance *record, void *data);
+
+/**
+ * Open a store, creating its directory if needed
+ * @param store Pointer to AttendanceStore structure
+ * @param directory Store directory (NULL for ATTENDANCE_STORE_DIR)
+ * @return 0 on success, -1 on failure
+ */
+int attendance_store_open(AttendanceStore *store, const char *directory);
+
+/**
+ * Unmap all segments and release resources
+ */
+void attendance_store_close(AttendanceStore *store);
+
+/**
+ * Append records (their checksums are filled in by the store)
+ * @return 0 on success, -1 on failure (records before the failure are kept)
+ */
+int attendance_store_append(AttendanceStore *store, const StoredAttendance *records, size_t count);
+
+/**
+ * Append every record of decoded attendance columns
+ * @return 0 on success, -1 on failure
+ */
+int attendance_store_append_columns(AttendanceStore *store, const AttendanceColumns *columns, StoreSource source);
+
+/**
+ * Flush appended records of the active segment to disk
+ * @return 0 on success, -1 on failure
+ */
+int attendance_store_sync(AttendanceStore *store);
+
+/**
+ * Visit records by employee and punch in range
+ * @param emp_number Employee number or STORE_ANY_EMPLOYEE
+ * @param from First punch in to include (UTC epoch seconds)
+ * @param to First punch in to exclude
+ * @param visitor Callback for each match, in append order
+ * @return Number of records visited, -1 on invalid parameters
+ */
+long attendance_store_query(AttendanceStore *store, int32_t emp_number, int64_t from, int64_t to,
+                            StoreVisitor visitor, void *data);
+
+/**
+ * Append the records of a query to attendance columns (for aggregation)
+ * @return Number of records appended, -1 on failure
+ */
+long attendance_store_query_columns(AttendanceStore *store, int32_t emp_number, int64_t from, int64_t to,
+                                    AttendanceColumns *columns);
+
+/**
+ * Total number of records in the store
+ */
+size_t attendance_store_count(AttendanceStore *store);
+
+/**
+ * Convert a submitted record, taking the UTC offsets from the local timezone
+ * @return 0 on success, -1 if the employee number is not numeric
+ */
+int stored_attendance_from_record(const AttendanceRecord *record, StoreSource source, StoredAttendance *out);
+
+#endif /* ATTENDANCE_STORE_H */
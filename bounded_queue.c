@@ -0,0 +1,104 @@
+#include "bounded_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+int bounded_queue_init(BoundedQueue *queue, size_t capacity) {
+    if (queue == NULL || capacity == 0) {
+        return -1;
+    }
+
+    queue->items = (void **)calloc(capacity, sizeof(void *));
+    if (queue->items == NULL) {
+        fprintf(stderr, "Failed to allocate queue\n");
+        return -1;
+    }
+
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = 0;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    return 0;
+}
+
+void bounded_queue_free(BoundedQueue *queue) {
+    if (queue == NULL || queue->items == NULL) {
+        return;
+    }
+
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->items);
+    queue->items = NULL;
+    queue->capacity = 0;
+    queue->count = 0;
+}
+
+int bounded_queue_push(BoundedQueue *queue, void *item, unsigned long long *wait_ns) {
+    pthread_mutex_lock(&queue->mutex);
+
+    if (queue->count == queue->capacity && !queue->closed) {
+        unsigned long long start = monotonic_ns();
+        while (queue->count == queue->capacity && !queue->closed) {
+            pthread_cond_wait(&queue->not_full, &queue->mutex);
+        }
+        if (wait_ns != NULL) {
+            *wait_ns += monotonic_ns() - start;
+        }
+    }
+
+    if (queue->closed) {
+        pthread_mutex_unlock(&queue->mutex);
+        return -1;
+    }
+
+    queue->items[(queue->head + queue->count) % queue->capacity] = item;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    return 0;
+}
+
+void *bounded_queue_pop(BoundedQueue *queue, unsigned long long *wait_ns) {
+    void *item = NULL;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    if (queue->count == 0 && !queue->closed) {
+        unsigned long long start = monotonic_ns();
+        while (queue->count == 0 && !queue->closed) {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        }
+        if (wait_ns != NULL) {
+            *wait_ns += monotonic_ns() - start;
+        }
+    }
+
+    if (queue->count > 0) {
+        item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+    return item;
+}
+
+void bounded_queue_close(BoundedQueue *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->closed = 1;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+}
@@ -0,0 +1,53 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+/**
+ * Fixed-capacity blocking FIFO of pointers, safe for many producers and consumers
+ */
+typedef struct {
+    void **items;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    int closed;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} BoundedQueue;
+
+/**
+ * Initialize a queue
+ * @param queue Pointer to BoundedQueue structure
+ * @param capacity Maximum number of queued items
+ * @return 0 on success, -1 on failure
+ */
+int bounded_queue_init(BoundedQueue *queue, size_t capacity);
+
+/**
+ * Free a queue (items still queued are not freed)
+ */
+void bounded_queue_free(BoundedQueue *queue);
+
+/**
+ * Append an item, blocking while the queue is full
+ * @param wait_ns Optional, incremented by nanoseconds spent blocked
+ * @return 0 on success, -1 if the queue was closed
+ */
+int bounded_queue_push(BoundedQueue *queue, void *item, unsigned long long *wait_ns);
+
+/**
+ * Remove the oldest item, blocking while the queue is empty
+ * @param wait_ns Optional, incremented by nanoseconds spent blocked
+ * @return The item, or NULL once the queue is closed and drained
+ */
+void *bounded_queue_pop(BoundedQueue *queue, unsigned long long *wait_ns);
+
+/**
+ * Close the queue: pending items can still be popped, pushes fail
+ */
+void bounded_queue_close(BoundedQueue *queue);
+
+#endif /* BOUNDED_QUEUE_H */
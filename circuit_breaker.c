@@ -0,0 +1,303 @@
+#include "circuit_breaker.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CIRCUIT_INITIAL_ENDPOINTS 64
+
+/**
+ * Outcome counts for one second of the sliding window
+ */
+typedef struct {
+    long second;
+    int requests;
+    int failures;
+} CircuitBucket;
+
+typedef struct {
+    char endpoint[CIRCUIT_ENDPOINT_SIZE];
+    CircuitState state;
+    long opened_at;
+    int probes_in_flight;
+    CircuitBucket buckets[CIRCUIT_MAX_WINDOW_SECONDS];
+} CircuitBreaker;
+
+/* window, min requests, failure %, open seconds, probes */
+#define CIRCUIT_DEFAULT_POLICY { 10, 5, 50, 15, 1 }
+
+static const CircuitBreakerPolicy DEFAULT_POLICY = CIRCUIT_DEFAULT_POLICY;
+
+static pthread_mutex_t g_breaker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CircuitBreakerPolicy g_policy = CIRCUIT_DEFAULT_POLICY;
+static CircuitBreaker *g_breakers = NULL;
+static int g_breaker_count = 0;
+static int g_breaker_capacity = 0;
+static uint32_t *g_breaker_slots = NULL;   /* open addressing over g_breakers, index + 1, 0 is empty */
+static uint32_t g_slot_mask = 0;
+static int g_overflow_logged = 0;
+
+static long monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec;
+}
+
+static int clamp(int value, int min, int max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+/**
+ * Copy the endpoint path without its query string
+ */
+static void endpoint_key(const char *endpoint, char *key) {
+    size_t len = strcspn(endpoint, "?");
+    if (len >= CIRCUIT_ENDPOINT_SIZE) {
+        len = CIRCUIT_ENDPOINT_SIZE - 1;
+    }
+    memcpy(key, endpoint, len);
+    key[len] = '\0';
+}
+
+static uint32_t hash_key(const char *key) {
+    uint32_t hash = 2166136261u;  /* FNV-1a */
+    for (const unsigned char *p = (const unsigned char *)key; *p != '\0'; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+static void insert_slot(uint32_t index) {
+    uint32_t i = hash_key(g_breakers[index].endpoint) & g_slot_mask;
+    while (g_breaker_slots[i] != 0) {
+        i = (i + 1) & g_slot_mask;
+    }
+    g_breaker_slots[i] = index + 1;
+}
+
+/**
+ * Double the registry and rehash it, keeping the slot table at most half full
+ * @return 0 on success, -1 at CIRCUIT_MAX_ENDPOINTS or if memory ran out
+ */
+static int grow_registry(void) {
+    int capacity = g_breaker_capacity == 0 ? CIRCUIT_INITIAL_ENDPOINTS : g_breaker_capacity * 2;
+    if (g_breaker_capacity >= CIRCUIT_MAX_ENDPOINTS) {
+        return -1;
+    }
+    if (capacity > CIRCUIT_MAX_ENDPOINTS) {
+        capacity = CIRCUIT_MAX_ENDPOINTS;
+    }
+
+    CircuitBreaker *breakers = (CircuitBreaker *)realloc(g_breakers, (size_t)capacity * sizeof(CircuitBreaker));
+    if (breakers == NULL) {
+        return -1;
+    }
+    g_breakers = breakers;
+
+    uint32_t slot_count = 1;
+    while (slot_count < (uint32_t)capacity * 2) {
+        slot_count <<= 1;
+    }
+    uint32_t *slots = (uint32_t *)calloc(slot_count, sizeof(uint32_t));
+    if (slots == NULL) {
+        return -1;  /* The larger array is kept, the old capacity still applies */
+    }
+    free(g_breaker_slots);
+    g_breaker_slots = slots;
+    g_slot_mask = slot_count - 1;
+    g_breaker_capacity = capacity;
+    for (int i = 0; i < g_breaker_count; i++) {
+        insert_slot((uint32_t)i);
+    }
+    return 0;
+}
+
+/**
+ * Find (or create) the breaker for an endpoint (caller holds g_breaker_mutex)
+ * @return NULL if the registry is full and create was requested
+ */
+static CircuitBreaker *find_breaker(const char *endpoint, int create) {
+    char key[CIRCUIT_ENDPOINT_SIZE];
+    endpoint_key(endpoint, key);
+
+    if (g_breaker_slots != NULL) {
+        for (uint32_t i = hash_key(key) & g_slot_mask; g_breaker_slots[i] != 0; i = (i + 1) & g_slot_mask) {
+            CircuitBreaker *breaker = &g_breakers[g_breaker_slots[i] - 1];
+            if (strcmp(breaker->endpoint, key) == 0) {
+                return breaker;
+            }
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+    if (g_breaker_count == g_breaker_capacity && grow_registry() != 0) {
+        if (!g_overflow_logged) {
+            fprintf(stderr, "Circuit breaker registry full (%d endpoints), %s and later endpoints are not protected\n",
+                    g_breaker_count, key);
+            g_overflow_logged = 1;
+        }
+        return NULL;
+    }
+
+    CircuitBreaker *breaker = &g_breakers[g_breaker_count];
+    memset(breaker, 0, sizeof(CircuitBreaker));
+    memcpy(breaker->endpoint, key, sizeof(key));
+    breaker->state = CIRCUIT_CLOSED;
+    insert_slot((uint32_t)g_breaker_count++);
+    return breaker;
+}
+
+static void clear_window(CircuitBreaker *breaker) {
+    memset(breaker->buckets, 0, sizeof(breaker->buckets));
+}
+
+static void open_breaker(CircuitBreaker *breaker, long now) {
+    breaker->state = CIRCUIT_OPEN;
+    breaker->opened_at = now;
+    breaker->probes_in_flight = 0;
+}
+
+void circuit_breaker_set_policy(const CircuitBreakerPolicy *policy) {
+    const CircuitBreakerPolicy *source = policy != NULL ? policy : &DEFAULT_POLICY;
+
+    pthread_mutex_lock(&g_breaker_mutex);
+    g_policy.window_seconds = clamp(source->window_seconds, 1, CIRCUIT_MAX_WINDOW_SECONDS);
+    g_policy.min_requests = clamp(source->min_requests, 1, 1000000);
+    g_policy.failure_rate_percent = clamp(source->failure_rate_percent, 1, 100);
+    g_policy.open_seconds = clamp(source->open_seconds, 1, 86400);
+    g_policy.half_open_probes = clamp(source->half_open_probes, 1, 1000);
+    pthread_mutex_unlock(&g_breaker_mutex);
+}
+
+int circuit_breaker_allow(const char *endpoint) {
+    int allowed = 1;
+
+    if (endpoint == NULL) {
+        return 1;
+    }
+
+    pthread_mutex_lock(&g_breaker_mutex);
+    CircuitBreaker *breaker = find_breaker(endpoint, 0);
+    if (breaker != NULL) {
+        if (breaker->state == CIRCUIT_OPEN &&
+            monotonic_seconds() - breaker->opened_at >= g_policy.open_seconds) {
+            breaker->state = CIRCUIT_HALF_OPEN;
+            breaker->probes_in_flight = 0;
+        }
+
+        if (breaker->state == CIRCUIT_OPEN) {
+            allowed = 0;
+        } else if (breaker->state == CIRCUIT_HALF_OPEN) {
+            if (breaker->probes_in_flight < g_policy.half_open_probes) {
+                breaker->probes_in_flight++;
+            } else {
+                allowed = 0;
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_breaker_mutex);
+
+    return allowed;
+}
+
+void circuit_breaker_record(const char *endpoint, int success) {
+    if (endpoint == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_breaker_mutex);
+    CircuitBreaker *breaker = find_breaker(endpoint, 1);
+    if (breaker == NULL) {
+        pthread_mutex_unlock(&g_breaker_mutex);
+        return;  /* Registry full: endpoint is not protected */
+    }
+
+    long now = monotonic_seconds();
+
+    switch (breaker->state) {
+    case CIRCUIT_HALF_OPEN:
+        if (breaker->probes_in_flight > 0) {
+            breaker->probes_in_flight--;
+        }
+        if (success) {
+            breaker->state = CIRCUIT_CLOSED;
+            clear_window(breaker);
+        } else {
+            open_breaker(breaker, now);
+        }
+        break;
+
+    case CIRCUIT_OPEN:
+        /* Late result of a request started before the breaker opened */
+        break;
+
+    case CIRCUIT_CLOSED: {
+        CircuitBucket *bucket = &breaker->buckets[now % g_policy.window_seconds];
+        if (bucket->second != now) {
+            bucket->second = now;
+            bucket->requests = 0;
+            bucket->failures = 0;
+        }
+        bucket->requests++;
+        if (!success) {
+            bucket->failures++;
+        }
+
+        if (!success) {
+            int requests = 0;
+            int failures = 0;
+            for (int i = 0; i < g_policy.window_seconds; i++) {
+                if (now - breaker->buckets[i].second < g_policy.window_seconds) {
+                    requests += breaker->buckets[i].requests;
+                    failures += breaker->buckets[i].failures;
+                }
+            }
+            if (requests >= g_policy.min_requests &&
+                failures * 100 >= requests * g_policy.failure_rate_percent) {
+                open_breaker(breaker, now);
+                clear_window(breaker);
+            }
+        }
+        break;
+    }
+    }
+
+    pthread_mutex_unlock(&g_breaker_mutex);
+}
+
+CircuitState circuit_breaker_state(const char *endpoint) {
+    CircuitState state = CIRCUIT_CLOSED;
+
+    if (endpoint == NULL) {
+        return state;
+    }
+
+    pthread_mutex_lock(&g_breaker_mutex);
+    CircuitBreaker *breaker = find_breaker(endpoint, 0);
+    if (breaker != NULL) {
+        state = breaker->state;
+        if (state == CIRCUIT_OPEN && monotonic_seconds() - breaker->opened_at >= g_policy.open_seconds) {
+            state = CIRCUIT_HALF_OPEN;  /* Next request will probe */
+        }
+    }
+    pthread_mutex_unlock(&g_breaker_mutex);
+
+    return state;
+}
+
+void circuit_breaker_reset(void) {
+    pthread_mutex_lock(&g_breaker_mutex);
+    free(g_breakers);
+    free(g_breaker_slots);
+    g_breakers = NULL;
+    g_breaker_slots = NULL;
+    g_breaker_count = 0;
+    g_breaker_capacity = 0;
+    g_slot_mask = 0;
+    g_overflow_logged = 0;
+    pthread_mutex_unlock(&g_breaker_mutex);
+}
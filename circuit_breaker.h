@@ -0,0 +1,59 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#define CIRCUIT_MAX_ENDPOINTS 4096   /* registry grows up to this many endpoints (tenant-scoped keys count apart) */
+#define CIRCUIT_MAX_WINDOW_SECONDS 60
+#define CIRCUIT_ENDPOINT_SIZE 128
+
+/**
+ * Breaker state of one endpoint
+ */
+typedef enum {
+    CIRCUIT_CLOSED = 0,     /* requests flow, outcomes are counted */
+    CIRCUIT_OPEN,           /* requests fail fast until the open period ends */
+    CIRCUIT_HALF_OPEN       /* a limited number of probe requests test recovery */
+} CircuitState;
+
+/**
+ * Thresholds shared by all endpoints
+ */
+typedef struct {
+    int window_seconds;         /* length of the sliding failure-rate window */
+    int min_requests;           /* calls needed in the window before the breaker may trip */
+    int failure_rate_percent;   /* failure rate that opens the breaker */
+    int open_seconds;           /* time to fail fast before probing */
+    int half_open_probes;       /* concurrent probe requests while half-open */
+} CircuitBreakerPolicy;
+
+/**
+ * Replace the breaker policy (defaults: 10s window, 5 requests, 50%, 15s open, 1 probe).
+ * Out of range values are clamped; existing endpoint state is kept.
+ * @param policy New policy, NULL restores the defaults
+ */
+void circuit_breaker_set_policy(const CircuitBreakerPolicy *policy);
+
+/**
+ * Ask whether a request to an endpoint may proceed
+ * @param endpoint Request path, anything after '?' is ignored
+ * @return 1 if the request may proceed, 0 if it must fail fast
+ */
+int circuit_breaker_allow(const char *endpoint);
+
+/**
+ * Record the outcome of a request that was allowed
+ * @param endpoint Request path, anything after '?' is ignored
+ * @param success 1 if the backend answered healthily, 0 otherwise
+ */
+void circuit_breaker_record(const char *endpoint, int success);
+
+/**
+ * Current state of an endpoint (CIRCUIT_CLOSED if never seen)
+ */
+CircuitState circuit_breaker_state(const char *endpoint);
+
+/**
+ * Forget all endpoint state
+ */
+void circuit_breaker_reset(void);
+
+#endif /* CIRCUIT_BREAKER_H */
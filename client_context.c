@@ -0,0 +1,499 @@
+#include "client_context.h"
+#include "token_holder.h"
+#include "json_scan.h"
+#include <errno.h>
+#include <pthread.h>
+
+#define CONTEXT_TOKEN_WAIT_MS 10000
+#define CONTEXT_MAX_WORKERS 256
+#define CONTEXT_FILE_MAX (1024 * 64)
+
+/**
+ * Queued request (strings copied)
+ */
+typedef struct ContextJob {
+    struct ContextJob *next;
+    char *url;
+    char *method;
+    char *data;
+    Future *future;
+} ContextJob;
+
+typedef struct {
+    char name[TENANT_NAME_SIZE];
+    Config config;              /* private copy; token_holder points at holder */
+    TokenHolder holder;
+    Transport *owned_transport; /* NULL if the caller supplied the transport */
+    int weight;
+    int max_concurrency;
+    int deficit;                /* requests left in the current turn */
+    int in_flight;
+    ContextJob *head;
+    ContextJob *tail;
+    TenantStats stats;
+} Tenant;
+
+struct ClientContext {
+    Tenant **tenants;
+    size_t tenant_count;
+    size_t tenant_capacity;
+    size_t cursor;              /* tenant whose turn it is */
+    size_t queued;              /* jobs queued over all tenants */
+    pthread_t *workers;
+    int worker_count;
+    int stopping;
+    pthread_mutex_t mutex;      /* queues, counters and the tenant list */
+    pthread_cond_t cond;        /* new job, finished job or shutdown */
+};
+
+static void job_free(ContextJob *job) {
+    mem_free(job->url);
+    mem_free(job->method);
+    mem_free(job->data);
+    mem_free(job);
+}
+
+static void response_buffer_destroy(void *value) {
+    response_buffer_free((ResponseBuffer *)value);
+    mem_free(value);
+}
+
+static Tenant *find_tenant(ClientContext *context, const char *name) {
+    for (size_t i = 0; i < context->tenant_count; i++) {
+        if (strcmp(context->tenants[i]->name, name) == 0) {
+            return context->tenants[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Deficit round robin: the tenant at the cursor starts requests until its
+ * turn's allowance is spent, its queue is empty or it reaches its
+ * concurrency limit; then the next tenant's turn begins with weight
+ * requests. Called with the mutex held.
+ * @return Job to run, NULL if no tenant may start one now
+ */
+static ContextJob *take_job(ClientContext *context, Tenant **owner) {
+    if (context->queued == 0) {
+        return NULL;
+    }
+
+    for (size_t step = 0; step <= context->tenant_count; step++) {
+        Tenant *tenant = context->tenants[context->cursor];
+        if (tenant->deficit > 0 && tenant->head != NULL && tenant->in_flight < tenant->max_concurrency) {
+            ContextJob *job = tenant->head;
+            tenant->head = job->next;
+            if (tenant->head == NULL) {
+                tenant->tail = NULL;
+            }
+            tenant->deficit--;
+            tenant->in_flight++;
+            tenant->stats.queued--;
+            context->queued--;
+            *owner = tenant;
+            return job;
+        }
+
+        /* Turn over; an unused allowance is not carried to the next turn */
+        tenant->deficit = 0;
+        context->cursor = (context->cursor + 1) % context->tenant_count;
+        context->tenants[context->cursor]->deficit = context->tenants[context->cursor]->weight;
+    }
+    return NULL;
+}
+
+static int run_job(Tenant *tenant, ContextJob *job, ResponseBuffer **out) {
+    ResponseBuffer *resp = (ResponseBuffer *)mem_alloc(MEM_RESPONSE, sizeof(ResponseBuffer));
+    if (resp == NULL || response_buffer_init(resp, MAX_RESPONSE_SIZE) != 0) {
+        mem_free(resp);
+        return -1;
+    }
+    *out = resp;  /* Error bodies are kept too */
+
+    if (token_holder_wait(&tenant->holder, CONTEXT_TOKEN_WAIT_MS) != 0) {
+        fprintf(stderr, "No access token for tenant %s\n", tenant->name);
+        return -1;
+    }
+    return api_request(job->url, job->method, job->data, &tenant->config, resp);
+}
+
+static void *context_worker(void *data) {
+    ClientContext *context = (ClientContext *)data;
+
+    pthread_mutex_lock(&context->mutex);
+    for (;;) {
+        Tenant *tenant = NULL;
+        ContextJob *job = take_job(context, &tenant);
+        if (job == NULL) {
+            if (context->stopping && context->queued == 0) {
+                break;  /* Stopping and drained */
+            }
+            pthread_cond_wait(&context->cond, &context->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&context->mutex);
+
+        ResponseBuffer *resp = NULL;
+        int result = run_job(tenant, job, &resp);
+        future_complete(job->future, result, resp, response_buffer_destroy);
+        future_release(job->future);
+        job_free(job);
+
+        pthread_mutex_lock(&context->mutex);
+        tenant->in_flight--;
+        tenant->stats.completed++;
+        if (result != 0) {
+            tenant->stats.failed++;
+        }
+        /* A tenant below its limit again may be the only one with work */
+        pthread_cond_broadcast(&context->cond);
+    }
+    pthread_mutex_unlock(&context->mutex);
+    return NULL;
+}
+
+ClientContext *client_context_create(int workers) {
+    if (workers <= 0) {
+        workers = CONTEXT_DEFAULT_WORKERS;
+    }
+    if (workers > CONTEXT_MAX_WORKERS) {
+        workers = CONTEXT_MAX_WORKERS;
+    }
+
+    if (orangehrm_client_init() != 0) {
+        return NULL;
+    }
+
+    ClientContext *context = (ClientContext *)calloc(1, sizeof(ClientContext));
+    if (context == NULL || (context->workers = (pthread_t *)calloc((size_t)workers, sizeof(pthread_t))) == NULL) {
+        fprintf(stderr, "Failed to allocate client context\n");
+        free(context);
+        orangehrm_client_cleanup();
+        return NULL;
+    }
+    pthread_mutex_init(&context->mutex, NULL);
+    pthread_cond_init(&context->cond, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&context->workers[i], NULL, context_worker, context) != 0) {
+            fprintf(stderr, "Error creating client context worker\n");
+            break;
+        }
+        context->worker_count++;
+    }
+    if (context->worker_count == 0) {
+        client_context_destroy(context);
+        return NULL;
+    }
+    return context;
+}
+
+static int copy_string(char **dest, const char *src) {
+    *dest = NULL;
+    if (src == NULL) {
+        return 0;
+    }
+    *dest = mem_strdup(MEM_CONFIG, src);
+    return *dest == NULL ? -1 : 0;
+}
+
+static void tenant_free(Tenant *tenant) {
+    if (tenant->holder.running) {
+        token_holder_stop(&tenant->holder);
+    }
+    tenant->config.token_holder = NULL;
+    config_free(&tenant->config);
+    transport_destroy(tenant->owned_transport);
+    free(tenant);
+}
+
+int client_context_add_tenant(ClientContext *context, const char *name, const Config *config, int weight,
+                              int max_concurrency) {
+    if (context == NULL || name == NULL || config == NULL || config->base_url == NULL) {
+        fprintf(stderr, "Invalid parameters for client_context_add_tenant\n");
+        return -1;
+    }
+    if (name[0] == '\0' || strlen(name) >= TENANT_NAME_SIZE) {
+        fprintf(stderr, "Invalid tenant name: %s\n", name);
+        return -1;
+    }
+
+    Tenant *tenant = (Tenant *)calloc(1, sizeof(Tenant));
+    if (tenant == NULL) {
+        fprintf(stderr, "Failed to allocate tenant\n");
+        return -1;
+    }
+    snprintf(tenant->name, sizeof(tenant->name), "%s", name);
+    tenant->weight = weight > 0 ? weight : TENANT_DEFAULT_WEIGHT;
+    tenant->max_concurrency = max_concurrency > 0 ? max_concurrency : TENANT_DEFAULT_MAX_CONCURRENCY;
+
+    if (copy_string(&tenant->config.base_url, config->base_url) != 0 ||
+        copy_string(&tenant->config.username, config->username) != 0 ||
+        copy_string(&tenant->config.password, config->password) != 0 ||
+        copy_string(&tenant->config.client_id, config->client_id) != 0 ||
+        copy_string(&tenant->config.client_secret, config->client_secret) != 0 ||
+        copy_string(&tenant->config.type, config->type) != 0 ||
+        copy_string(&tenant->config.tenant, name) != 0) {
+        fprintf(stderr, "Memory allocation failed for tenant %s\n", name);
+        tenant_free(tenant);
+        return -1;
+    }
+    tenant->config.warmup = config->warmup;
+    tenant->config.transport_options = config->transport_options;
+
+    /* Own transport, so each tenant keeps its own connection pool */
+    tenant->config.transport = config->transport;
+    if (tenant->config.transport == NULL) {
+        tenant->owned_transport = curl_transport_create_with_options(&config->transport_options);
+        if (tenant->owned_transport == NULL) {
+            tenant_free(tenant);
+            return -1;
+        }
+        tenant->config.transport = tenant->owned_transport;
+    }
+    if (tenant->config.warmup) {
+        orangehrm_warmup(&tenant->config);  /* Best effort */
+    }
+
+    if (token_holder_start(&tenant->holder, &tenant->config) != 0) {
+        tenant_free(tenant);
+        return -1;
+    }
+    tenant->config.token_holder = &tenant->holder;
+
+    pthread_mutex_lock(&context->mutex);
+    if (find_tenant(context, name) != NULL) {
+        pthread_mutex_unlock(&context->mutex);
+        fprintf(stderr, "Tenant %s already exists\n", name);
+        tenant_free(tenant);
+        return -1;
+    }
+    if (context->tenant_count == context->tenant_capacity) {
+        size_t capacity = context->tenant_capacity ? context->tenant_capacity * 2 : 4;
+        Tenant **tenants = (Tenant **)realloc(context->tenants, capacity * sizeof(Tenant *));
+        if (tenants == NULL) {
+            pthread_mutex_unlock(&context->mutex);
+            fprintf(stderr, "Failed to grow tenant list\n");
+            tenant_free(tenant);
+            return -1;
+        }
+        context->tenants = tenants;
+        context->tenant_capacity = capacity;
+    }
+    context->tenants[context->tenant_count++] = tenant;
+    pthread_mutex_unlock(&context->mutex);
+    return 0;
+}
+
+/**
+ * Add the tenants of a tenants file's "tenants" array
+ */
+static int load_tenants(ClientContext *context, const JsonSlice *list) {
+    JsonIterator iterator;
+    JsonSlice entry;
+    int rc;
+
+    if (json_scan_iter_init(&iterator, list) != 0 || list->type != JSON_SCAN_ARRAY) {
+        fprintf(stderr, "\"tenants\" must be an array\n");
+        return -1;
+    }
+
+    while ((rc = json_scan_iter_next(&iterator, NULL, &entry)) == JSON_SCAN_FOUND) {
+        char name[TENANT_NAME_SIZE];
+        char config_path[512];
+        long long weight = 0;
+        long long max_concurrency = 0;
+        JsonSlice field;
+        Config config;
+
+        if (json_scan_find(entry.ptr, entry.length, "name", &field) != JSON_SCAN_FOUND ||
+            json_scan_string(&field, name, sizeof(name)) < 0 ||
+            json_scan_find(entry.ptr, entry.length, "config", &field) != JSON_SCAN_FOUND ||
+            json_scan_string(&field, config_path, sizeof(config_path)) < 0) {
+            fprintf(stderr, "Tenant entries need a \"name\" and a \"config\" file\n");
+            return -1;
+        }
+        if (json_scan_find(entry.ptr, entry.length, "weight", &field) == JSON_SCAN_FOUND &&
+            json_scan_long(&field, &weight) != 0) {
+            fprintf(stderr, "Invalid weight for tenant %s\n", name);
+            return -1;
+        }
+        if (json_scan_find(entry.ptr, entry.length, "max_concurrency", &field) == JSON_SCAN_FOUND &&
+            json_scan_long(&field, &max_concurrency) != 0) {
+            fprintf(stderr, "Invalid max_concurrency for tenant %s\n", name);
+            return -1;
+        }
+        if (weight < 0 || weight > 1000 || max_concurrency < 0 || max_concurrency > CONTEXT_MAX_WORKERS) {
+            fprintf(stderr, "Weight or max_concurrency out of range for tenant %s\n", name);
+            return -1;
+        }
+
+        memset(&config, 0, sizeof(config));
+        if (load_config_file(&config, config_path) != 0) {
+            return -1;
+        }
+        rc = client_context_add_tenant(context, name, &config, (int)weight, (int)max_concurrency);
+        config_free(&config);
+        if (rc != 0) {
+            return -1;
+        }
+    }
+    return rc == JSON_SCAN_NOT_FOUND ? 0 : -1;
+}
+
+ClientContext *client_context_load(const char *path) {
+    ClientContext *context = NULL;
+    JsonSlice field;
+    long long workers = 0;
+    char *text = NULL;
+    size_t length;
+
+    if (path == NULL) {
+        fprintf(stderr, "Tenants file path is NULL\n");
+        return NULL;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open tenants file %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    text = (char *)malloc(CONTEXT_FILE_MAX);
+    if (text == NULL) {
+        fprintf(stderr, "Failed to allocate tenants file buffer\n");
+        fclose(file);
+        return NULL;
+    }
+    length = fread(text, 1, CONTEXT_FILE_MAX, file);
+    fclose(file);
+    if (length == CONTEXT_FILE_MAX) {
+        fprintf(stderr, "Tenants file %s is too large\n", path);
+        goto cleanup;
+    }
+
+    if (json_scan_find(text, length, "workers", &field) == JSON_SCAN_FOUND &&
+        (json_scan_long(&field, &workers) != 0 || workers < 0 || workers > CONTEXT_MAX_WORKERS)) {
+        fprintf(stderr, "Invalid workers in %s\n", path);
+        goto cleanup;
+    }
+    if (json_scan_find(text, length, "tenants", &field) != JSON_SCAN_FOUND) {
+        fprintf(stderr, "No \"tenants\" in %s\n", path);
+        goto cleanup;
+    }
+
+    context = client_context_create((int)workers);
+    if (context != NULL && load_tenants(context, &field) != 0) {
+        client_context_destroy(context);
+        context = NULL;
+    }
+
+cleanup:
+    free(text);
+    return context;
+}
+
+Future *client_context_request(ClientContext *context, const char *tenant_name, const char *url,
+                               const char *method, const char *data) {
+    if (context == NULL || tenant_name == NULL || url == NULL || method == NULL) {
+        fprintf(stderr, "Invalid parameters for client_context_request\n");
+        return NULL;
+    }
+
+    if (mem_budget_admit(sizeof(ContextJob) + strlen(url) + (data != NULL ? strlen(data) : 0)) != 0) {
+        return NULL;
+    }
+    ContextJob *job = (ContextJob *)mem_calloc(MEM_REQUEST, 1, sizeof(ContextJob));
+    if (job == NULL) {
+        fprintf(stderr, "Memory allocation failed for tenant request\n");
+        return NULL;
+    }
+    job->url = mem_strdup(MEM_REQUEST, url);
+    job->method = mem_strdup(MEM_REQUEST, method);
+    job->data = data != NULL ? mem_strdup(MEM_REQUEST, data) : NULL;
+    job->future = future_new();
+    if (job->url == NULL || job->method == NULL || (data != NULL && job->data == NULL) || job->future == NULL) {
+        fprintf(stderr, "Memory allocation failed for tenant request\n");
+        future_release(job->future);
+        job_free(job);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+    Tenant *tenant = find_tenant(context, tenant_name);
+    if (tenant == NULL || context->stopping) {
+        pthread_mutex_unlock(&context->mutex);
+        fprintf(stderr, tenant == NULL ? "Unknown tenant: %s\n" : "Client context is shutting down (%s)\n",
+                tenant_name);
+        future_release(job->future);
+        job_free(job);
+        return NULL;
+    }
+    if (tenant->tail != NULL) {
+        tenant->tail->next = job;
+    } else {
+        tenant->head = job;
+    }
+    tenant->tail = job;
+    tenant->stats.queued++;
+    tenant->stats.submitted++;
+    context->queued++;
+    Future *future = future_retain(job->future);  /* One reference for the caller, one for the worker */
+    pthread_cond_broadcast(&context->cond);
+    pthread_mutex_unlock(&context->mutex);
+    return future;
+}
+
+Config *client_context_config(ClientContext *context, const char *tenant_name) {
+    Config *config = NULL;
+
+    if (context == NULL || tenant_name == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&context->mutex);
+    Tenant *tenant = find_tenant(context, tenant_name);
+    if (tenant != NULL) {
+        config = &tenant->config;
+    }
+    pthread_mutex_unlock(&context->mutex);
+    return config;
+}
+
+int client_context_tenant_stats(ClientContext *context, const char *tenant_name, TenantStats *stats) {
+    if (context == NULL || tenant_name == NULL || stats == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&context->mutex);
+    Tenant *tenant = find_tenant(context, tenant_name);
+    if (tenant != NULL) {
+        *stats = tenant->stats;
+        stats->in_flight = tenant->in_flight;
+    }
+    pthread_mutex_unlock(&context->mutex);
+    return tenant != NULL ? 0 : -1;
+}
+
+void client_context_destroy(ClientContext *context) {
+    if (context == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&context->mutex);
+    context->stopping = 1;
+    pthread_cond_broadcast(&context->cond);
+    pthread_mutex_unlock(&context->mutex);
+
+    for (int i = 0; i < context->worker_count; i++) {
+        pthread_join(context->workers[i], NULL);
+    }
+
+    for (size_t i = 0; i < context->tenant_count; i++) {
+        tenant_free(context->tenants[i]);
+    }
+    pthread_mutex_destroy(&context->mutex);
+    pthread_cond_destroy(&context->cond);
+    free(context->tenants);
+    free(context->workers);
+    free(context);
+    orangehrm_client_cleanup();
+}
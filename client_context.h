@@ -0,0 +1,89 @@
+#ifndef CLIENT_CONTEXT_H
+#define CLIENT_CONTEXT_H
+
+#include "orangehrm_client.h"
+#include "future.h"
+
+#define CONTEXT_DEFAULT_WORKERS 8
+#define TENANT_DEFAULT_WEIGHT 1
+#define TENANT_DEFAULT_MAX_CONCURRENCY 4
+#define TENANT_NAME_SIZE 64
+
+/**
+ * Client serving several OrangeHRM tenants from one process.
+ *
+ * Every tenant has its own credentials, token holder, transport (so its
+ * own connection pool) and circuit breakers, and at most max_concurrency
+ * requests in flight. Queued requests are dispatched to a shared pool of
+ * worker threads by deficit round robin: each turn a tenant may start up
+ * to weight requests, so a tenant with a deep bulk queue gets its share
+ * of the workers but cannot starve the others.
+ */
+typedef struct ClientContext ClientContext;
+
+/**
+ * Request counters of one tenant
+ */
+typedef struct {
+    size_t queued;
+    int in_flight;
+    unsigned long long submitted;
+    unsigned long long completed;
+    unsigned long long failed;
+} TenantStats;
+
+/**
+ * Create a context without tenants (initializes the client)
+ * @param workers Worker threads shared by all tenants (0 for CONTEXT_DEFAULT_WORKERS)
+ * @return New context, NULL on failure
+ */
+ClientContext *client_context_create(int workers);
+
+/**
+ * Create a context from a tenants file:
+ * {"workers": 8, "tenants": [{"name": "acme", "config": "acme.json",
+ *   "weight": 2, "max_concurrency": 4}, ...]}
+ * Each "config" is a config.json style file (relative to the working directory).
+ * @return New context, NULL on failure
+ */
+ClientContext *client_context_load(const char *path);
+
+/**
+ * Add a tenant. The credentials are copied; a transport is created unless
+ * config->transport is set (then it is borrowed), and a token holder starts
+ * fetching the tenant's token.
+ * @param name Unique tenant name (shorter than TENANT_NAME_SIZE)
+ * @param weight Requests started per scheduling turn (0 for TENANT_DEFAULT_WEIGHT)
+ * @param max_concurrency Requests in flight at once (0 for TENANT_DEFAULT_MAX_CONCURRENCY)
+ * @return 0 on success, -1 on failure
+ */
+int client_context_add_tenant(ClientContext *context, const char *name, const Config *config, int weight,
+                              int max_concurrency);
+
+/**
+ * Queue an API request for a tenant
+ * @return Future whose value is the ResponseBuffer (owned by the future),
+ *         NULL if the tenant is unknown or the context is shutting down
+ */
+Future *client_context_request(ClientContext *context, const char *tenant, const char *url, const char *method,
+                               const char *data);
+
+/**
+ * Configuration of a tenant, for synchronous calls on the caller's thread
+ * (valid until the context is destroyed)
+ * @return Config, NULL if the tenant is unknown
+ */
+Config *client_context_config(ClientContext *context, const char *tenant);
+
+/**
+ * Read a tenant's request counters
+ * @return 0 on success, -1 if the tenant is unknown
+ */
+int client_context_tenant_stats(ClientContext *context, const char *tenant, TenantStats *stats);
+
+/**
+ * Finish queued requests, stop the tenants and release the client
+ */
+void client_context_destroy(ClientContext *context);
+
+#endif /* CLIENT_CONTEXT_H */
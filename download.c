@@ -0,0 +1,272 @@
+#include "download.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define HTTP_PARTIAL_CONTENT 206
+#define HTTP_RANGE_NOT_SATISFIABLE 416
+#define HTTP_CLIENT_ERROR 400
+
+/**
+ * Destination state shared with the transport callbacks
+ */
+typedef struct {
+    int fd;
+    int use_mmap;
+    int started;        /* response headers seen */
+    int discard;        /* drop the body (416 on a complete file) */
+    long status;
+    off_t resume_from;  /* bytes already on disk when resuming */
+    off_t position;     /* file offset of the next body byte */
+    size_t written;     /* body bytes written by this transfer */
+    int allocated;      /* file extended to the expected end; trim it to position when done */
+    char *map;          /* output window when writing through mmap */
+    size_t map_length;
+    off_t map_offset;   /* page-aligned file offset of the window */
+} DownloadSink;
+
+static int write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Failed to write download data");
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Map the remaining output range once Content-Length is known.
+ * The range is allocated first, so a full disk fails here with ENOSPC
+ * instead of faulting (SIGBUS) on a sparse page later.
+ * Leaves the sink on plain writes if the size is unknown or mapping fails.
+ * @return 0 on success or fallback, -1 if the disk has no room for the body
+ */
+static int map_output(DownloadSink *sink, long long length) {
+    if (length <= 0) {
+        return 0;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    off_t end = sink->position + (off_t)length;
+    off_t offset = sink->position - (sink->position % page);
+
+    int err = posix_fallocate(sink->fd, sink->position, (off_t)length);
+    if (err != 0) {
+        /* Drop any partial allocation; writes continue at position */
+        if (ftruncate(sink->fd, sink->position) != 0) {
+            perror("Failed to trim download file");
+            return -1;
+        }
+        if (err == ENOSPC || err == EFBIG) {
+            fprintf(stderr, "No room for download of %lld bytes: %s\n", length, strerror(err));
+            return -1;
+        }
+        fprintf(stderr, "Failed to allocate download file, falling back to writes: %s\n", strerror(err));
+        return 0;
+    }
+    sink->allocated = 1;
+
+    void *map = mmap(NULL, (size_t)(end - offset), PROT_READ | PROT_WRITE, MAP_SHARED, sink->fd, offset);
+    if (map == MAP_FAILED) {
+        perror("Failed to map download file, falling back to writes");
+        return 0;  /* The allocated tail is trimmed after the transfer */
+    }
+
+    sink->map = (char *)map;
+    sink->map_length = (size_t)(end - offset);
+    sink->map_offset = offset;
+    return 0;
+}
+
+/**
+ * Transport headers callback: inspect the status before any body byte is stored
+ * @return 0 to continue, -1 to abort the transfer
+ */
+static int start_sink(void *userdata, long status, long long content_length) {
+    DownloadSink *sink = (DownloadSink *)userdata;
+
+    sink->started = 1;
+    sink->status = status;
+
+    if (sink->resume_from > 0 && status == HTTP_RANGE_NOT_SATISFIABLE) {
+        sink->discard = 1;  /* File is already complete */
+        return 0;
+    }
+    if (status >= HTTP_CLIENT_ERROR) {
+        fprintf(stderr, "Download failed with HTTP status %ld\n", status);
+        return -1;
+    }
+
+    if (sink->resume_from > 0 && status != HTTP_PARTIAL_CONTENT) {
+        /* Server ignored the Range request and sends the whole body */
+        if (ftruncate(sink->fd, 0) != 0 || lseek(sink->fd, 0, SEEK_SET) != 0) {
+            perror("Failed to restart download file");
+            return -1;
+        }
+        sink->position = 0;
+    }
+
+    if (sink->use_mmap) {
+        return map_output(sink, content_length);
+    }
+    return 0;
+}
+
+/**
+ * Transport write callback streaming body bytes to the sink
+ */
+static size_t download_write_callback(void *ptr, size_t size, size_t nmemb, void *userdata) {
+    size_t realsize = size * nmemb;
+    DownloadSink *sink = (DownloadSink *)userdata;
+
+    if (sink->discard) {
+        return realsize;
+    }
+    if (sink->map != NULL) {
+        size_t at = (size_t)(sink->position - sink->map_offset);
+        if (at + realsize > sink->map_length) {
+            fprintf(stderr, "Download body exceeds Content-Length\n");
+            return 0;
+        }
+        memcpy(sink->map + at, ptr, realsize);
+    } else if (write_all(sink->fd, (const char *)ptr, realsize) != 0) {
+        return 0;
+    }
+
+    sink->position += (off_t)realsize;
+    sink->written += realsize;
+    return realsize;
+}
+
+/**
+ * Run the GET transfer into the sink
+ */
+static int perform_download(const char *url, Config *config, DownloadSink *sink) {
+    TransportRequest request;
+    TransportResponse response;
+    const char *headers[2];
+    size_t header_count = 0;
+    char full_url[MAX_URL_SIZE];
+    char auth_header[MAX_HEADER_SIZE];
+    char range_header[64];
+
+    if (client_auth_header(config, auth_header, sizeof(auth_header)) != 0) {
+        return -1;
+    }
+    headers[header_count++] = auth_header;
+    if (sink->resume_from > 0) {
+        snprintf(range_header, sizeof(range_header), "Range: bytes=%lld-", (long long)sink->resume_from);
+        headers[header_count++] = range_header;
+    }
+
+    snprintf(full_url, sizeof(full_url), "%s%s", config->base_url, url);
+
+    memset(&request, 0, sizeof(request));
+    request.method = "GET";
+    request.url = full_url;
+    request.path = url;
+    request.headers = headers;
+    request.header_count = header_count;
+    request.write_fn = download_write_callback;
+    request.write_data = sink;
+    request.headers_fn = start_sink;
+    request.headers_data = sink;
+    request.timeout_ms = -1;  /* Large exports may take long; the low-speed abort still applies */
+
+    int res = client_transport_perform(config, &request, &response);
+    if (!sink->started) {
+        sink->status = response.status;
+    }
+
+    if (sink->resume_from > 0 && sink->status == HTTP_RANGE_NOT_SATISFIABLE) {
+        return 0;  /* Nothing left to fetch */
+    }
+    if (res != 0) {
+        fprintf(stderr, "Download request failed\n");
+        return -1;
+    }
+    if (sink->status >= HTTP_CLIENT_ERROR) {
+        if (!sink->started) {
+            fprintf(stderr, "Download failed with HTTP status %ld\n", sink->status);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int download_request(const char *url, const char *path, Config *config,
+                     const DownloadOptions *options, size_t *bytes_written) {
+    DownloadSink sink;
+    struct stat st;
+    int result;
+
+    if (url == NULL || path == NULL || config == NULL) {
+        fprintf(stderr, "Invalid parameters for download_request\n");
+        return -1;
+    }
+
+    memset(&sink, 0, sizeof(sink));
+    int resume = options != NULL && options->resume;
+    sink.use_mmap = options != NULL && options->use_mmap;
+
+    sink.fd = open(path, O_RDWR | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+    if (sink.fd < 0) {
+        perror("Failed to open download file");
+        return -1;
+    }
+
+    if (resume && fstat(sink.fd, &st) == 0 && st.st_size > 0) {
+        sink.resume_from = st.st_size;
+        sink.position = st.st_size;
+        lseek(sink.fd, 0, SEEK_END);
+    }
+
+    result = perform_download(url, config, &sink);
+
+    if (sink.map != NULL) {
+        munmap(sink.map, sink.map_length);
+    }
+    /* Drop the unwritten tail if the body ended early, so a resume starts at the right offset */
+    if (sink.allocated && ftruncate(sink.fd, sink.position) != 0) {
+        perror("Failed to trim download file");
+        result = -1;
+    }
+    if (result == 0 && fsync(sink.fd) != 0) {
+        perror("Failed to flush download file");
+        result = -1;
+    }
+    close(sink.fd);
+
+    if (bytes_written != NULL) {
+        *bytes_written = sink.written;
+    }
+    return result;
+}
+
+int download_to_fd(const char *url, int fd, Config *config, size_t *bytes_written) {
+    DownloadSink sink;
+
+    if (url == NULL || fd < 0 || config == NULL) {
+        fprintf(stderr, "Invalid parameters for download_to_fd\n");
+        return -1;
+    }
+
+    memset(&sink, 0, sizeof(sink));
+    sink.fd = fd;
+
+    int result = perform_download(url, config, &sink);
+    if (bytes_written != NULL) {
+        *bytes_written = sink.written;
+    }
+    return result;
+}
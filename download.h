@@ -0,0 +1,39 @@
+#ifndef DOWNLOAD_H
+#define DOWNLOAD_H
+
+#include <stddef.h>
+#include "orangehrm_client.h"
+
+/**
+ * Options for downloading a response body to a file
+ */
+typedef struct {
+    int resume;     /* continue a partial file with a Range request */
+    int use_mmap;   /* write through a memory-mapped file when Content-Length is known
+                       (the space is allocated up front, a full disk fails the download) */
+} DownloadOptions;
+
+/**
+ * Stream a GET response body into a file without buffering it in memory.
+ * With resume set, an existing file is continued from its current size;
+ * a server that ignores the Range request causes the file to be rewritten
+ * from the start, and 416 (range not satisfiable) is treated as complete.
+ * @param url API endpoint (will be appended to base_url)
+ * @param path Output file path
+ * @param config Pointer to Config structure with credentials
+ * @param options Download options (NULL for plain streaming writes)
+ * @param bytes_written Optional, receives the number of body bytes written
+ * @return 0 on success, -1 on failure
+ */
+int download_request(const char *url, const char *path, Config *config,
+                     const DownloadOptions *options, size_t *bytes_written);
+
+/**
+ * Stream a GET response body into an already open file descriptor
+ * (file, pipe or socket) starting at its current position.
+ * @param fd Writable file descriptor
+ * @return 0 on success, -1 on failure
+ */
+int download_to_fd(const char *url, int fd, Config *config, size_t *bytes_written);
+
+#endif /* DOWNLOAD_H */
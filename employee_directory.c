@@ -0,0 +1,524 @@
+#include "employee_directory.h"
+#include "trace.h"
+#include "orangehrm_api.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define EMPLOYEE_INDEX_MAGIC "ORGEMPX1"
+#define EMPLOYEE_INDEX_VERSION 2      /* 2: id and name fields sized from the spec */
+#define EMPLOYEE_MIN_SLOTS 16
+#define EMPLOYEE_PAGE_BUFFER_SIZE (MAX_RESPONSE_SIZE * 4)
+
+/**
+ * On-disk index header (64 bytes, records follow immediately)
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_count;
+    uint32_t slot_count;
+    uint32_t reserved;
+    int64_t last_modified;
+    int64_t synced_at;
+    uint8_t padding[24];
+} EmployeeIndexHeader;
+
+/**
+ * Entry used while merging the existing index with fetched changes
+ */
+typedef struct {
+    EmployeeRecord record;
+    uint32_t seq;
+    int deleted;
+} MergeEntry;
+
+typedef struct {
+    MergeEntry *entries;
+    size_t count;
+    size_t capacity;
+} MergeList;
+
+static uint32_t hash_number(int32_t emp_number) {
+    uint32_t h = (uint32_t)emp_number;
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t hash_name(const char *name) {
+    uint32_t h = 2166136261U;
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        h ^= (uint32_t)tolower(*p);
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static uint32_t slot_count_for(uint32_t keys) {
+    uint32_t slots = EMPLOYEE_MIN_SLOTS;
+    while (slots < keys * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+/**
+ * Drop the current mapping (caller holds the write lock)
+ */
+static void unmap_index(EmployeeDirectory *dir) {
+    if (dir->map != NULL) {
+        munmap(dir->map, dir->map_size);
+    }
+    dir->map = NULL;
+    dir->map_size = 0;
+    dir->records = NULL;
+    dir->number_slots = NULL;
+    dir->name_slots = NULL;
+    dir->record_count = 0;
+    dir->slot_mask = 0;
+    dir->last_modified = 0;
+}
+
+/**
+ * Map the index file and validate its layout (caller holds the write lock)
+ */
+static int map_index(EmployeeDirectory *dir) {
+    struct stat st;
+    int fd = open(dir->path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;  /* No index yet, start empty */
+        }
+        perror("Failed to open employee index");
+        return -1;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(EmployeeIndexHeader)) {
+        fprintf(stderr, "Employee index %s is truncated\n", dir->path);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map employee index");
+        return -1;
+    }
+
+    const EmployeeIndexHeader *header = (const EmployeeIndexHeader *)map;
+    size_t expected = sizeof(EmployeeIndexHeader)
+                    + (size_t)header->record_count * sizeof(EmployeeRecord)
+                    + (size_t)header->slot_count * 2 * sizeof(uint32_t);
+
+    if (memcmp(header->magic, EMPLOYEE_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != EMPLOYEE_INDEX_VERSION ||
+        header->slot_count == 0 || (header->slot_count & (header->slot_count - 1)) != 0 ||
+        expected != (size_t)st.st_size) {
+        fprintf(stderr, "Employee index %s is invalid, ignoring it\n", dir->path);
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    dir->map = map;
+    dir->map_size = (size_t)st.st_size;
+    dir->records = (const EmployeeRecord *)((const char *)map + sizeof(EmployeeIndexHeader));
+    dir->number_slots = (const uint32_t *)(dir->records + header->record_count);
+    dir->name_slots = dir->number_slots + header->slot_count;
+    dir->record_count = header->record_count;
+    dir->slot_mask = header->slot_count - 1;
+    dir->last_modified = header->last_modified;
+    return 0;
+}
+
+int employee_directory_open(EmployeeDirectory *dir, const char *path) {
+    if (dir == NULL) {
+        return -1;
+    }
+
+    memset(dir, 0, sizeof(EmployeeDirectory));
+    dir->path = strdup(path != NULL ? path : EMPLOYEE_INDEX_FILE);
+    if (dir->path == NULL) {
+        fprintf(stderr, "Memory allocation failed for index path\n");
+        return -1;
+    }
+
+    pthread_rwlock_init(&dir->lock, NULL);
+    pthread_mutex_init(&dir->sync_lock, NULL);
+
+    if (map_index(dir) != 0) {
+        /* A corrupt index is rebuilt by the next full sync */
+        unmap_index(dir);
+    }
+    return 0;
+}
+
+void employee_directory_close(EmployeeDirectory *dir) {
+    if (dir == NULL || dir->path == NULL) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&dir->lock);
+    unmap_index(dir);
+    pthread_rwlock_unlock(&dir->lock);
+
+    pthread_rwlock_destroy(&dir->lock);
+    pthread_mutex_destroy(&dir->sync_lock);
+    free(dir->path);
+    dir->path = NULL;
+}
+
+int employee_directory_find_by_number(EmployeeDirectory *dir, int32_t emp_number, EmployeeRecord *out) {
+    int result = -1;
+
+    if (dir == NULL || out == NULL) {
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&dir->lock);
+    if (dir->record_count > 0) {
+        uint32_t i = hash_number(emp_number) & dir->slot_mask;
+        while (dir->number_slots[i] != 0) {
+            const EmployeeRecord *rec = &dir->records[dir->number_slots[i] - 1];
+            if (rec->emp_number == emp_number) {
+                *out = *rec;
+                result = 0;
+                break;
+            }
+            i = (i + 1) & dir->slot_mask;
+        }
+    }
+    pthread_rwlock_unlock(&dir->lock);
+
+    return result;
+}
+
+int employee_directory_find_by_name(EmployeeDirectory *dir, const char *name, EmployeeRecord *out) {
+    int result = -1;
+
+    if (dir == NULL || name == NULL || out == NULL || name[0] == '\0') {
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&dir->lock);
+    if (dir->record_count > 0) {
+        uint32_t i = hash_name(name) & dir->slot_mask;
+        while (dir->name_slots[i] != 0) {
+            const EmployeeRecord *rec = &dir->records[dir->name_slots[i] - 1];
+            if (strcasecmp(rec->name, name) == 0 || strcasecmp(rec->employee_id, name) == 0) {
+                *out = *rec;
+                result = 0;
+                break;
+            }
+            i = (i + 1) & dir->slot_mask;
+        }
+    }
+    pthread_rwlock_unlock(&dir->lock);
+
+    return result;
+}
+
+size_t employee_directory_count(EmployeeDirectory *dir) {
+    size_t count;
+
+    if (dir == NULL) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&dir->lock);
+    count = dir->record_count;
+    pthread_rwlock_unlock(&dir->lock);
+
+    return count;
+}
+
+static int merge_list_push(MergeList *list, const EmployeeRecord *record, int deleted) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        MergeEntry *entries = (MergeEntry *)mem_realloc(MEM_DIRECTORY, list->entries, capacity * sizeof(MergeEntry));
+        if (entries == NULL) {
+            fprintf(stderr, "Memory allocation failed for employee merge list\n");
+            return -1;
+        }
+        list->entries = entries;
+        list->capacity = capacity;
+    }
+
+    MergeEntry *entry = &list->entries[list->count];
+    entry->record = *record;
+    entry->seq = (uint32_t)list->count;
+    entry->deleted = deleted;
+    list->count++;
+    return 0;
+}
+
+static int compare_merge_entries(const void *a, const void *b) {
+    const MergeEntry *ea = (const MergeEntry *)a;
+    const MergeEntry *eb = (const MergeEntry *)b;
+
+    if (ea->record.emp_number != eb->record.emp_number) {
+        return ea->record.emp_number < eb->record.emp_number ? -1 : 1;
+    }
+    return ea->seq < eb->seq ? -1 : (ea->seq > eb->seq);
+}
+
+/**
+ * Parse the modification time field, accepting epoch seconds or "YYYY-MM-DD HH:MM:SS" (UTC)
+ */
+static int64_t parse_modified(const JsonSlice *value) {
+    char text[32];
+    long long seconds;
+    struct tm tm_info;
+
+    if (value->type == JSON_SCAN_NUMBER) {
+        return json_scan_long(value, &seconds) == 0 ? (int64_t)seconds : 0;
+    }
+
+    memset(&tm_info, 0, sizeof(tm_info));
+    if (value->type != JSON_SCAN_STRING || json_scan_string(value, text, sizeof(text)) < 0 ||
+        sscanf(text, "%d-%d-%d %d:%d:%d", &tm_info.tm_year, &tm_info.tm_mon,
+               &tm_info.tm_mday, &tm_info.tm_hour, &tm_info.tm_min, &tm_info.tm_sec) < 3) {
+        return 0;
+    }
+    tm_info.tm_year -= 1900;
+    tm_info.tm_mon -= 1;
+    return (int64_t)timegm(&tm_info);
+}
+
+/**
+ * Convert one decoded API employee into an index record
+ */
+static void parse_employee(const OhrmEmployee *employee, EmployeeRecord *record, int *deleted) {
+    memset(record, 0, sizeof(EmployeeRecord));
+    record->emp_number = (int32_t)employee->emp_number;
+    snprintf(record->employee_id, sizeof(record->employee_id), "%s", employee->employee_id);
+    snprintf(record->name, sizeof(record->name), "%s%s%s", employee->first_name,
+             (employee->first_name[0] && employee->last_name[0]) ? " " : "", employee->last_name);
+    if (employee->present & OHRM_EMPLOYEE_HAS_LAST_MODIFIED) {
+        record->modified_at = parse_modified(&employee->last_modified);
+    }
+    *deleted = employee->deleted || (employee->present & OHRM_EMPLOYEE_HAS_TERMINATION_ID) != 0;
+}
+
+/**
+ * Page through the employee endpoint, appending every employee to the list
+ * @return Number of employees received, -1 on failure
+ */
+static int fetch_employees(Config *config, int64_t since, MergeList *list) {
+    ResponseBuffer resp;
+    OhrmListEmployeesParams params;
+    int received = 0;
+
+    if (response_buffer_init(&resp, EMPLOYEE_PAGE_BUFFER_SIZE) != 0) {
+        return -1;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.limit = EMPLOYEE_SYNC_PAGE_SIZE;
+    if (since > 0) {
+        params.modified_after = since;
+        params.present |= OHRM_LIST_EMPLOYEES_HAS_MODIFIED_AFTER;
+    }
+
+    for (;;) {
+        OhrmEmployeeList page;
+        if (ohrm_list_employees(config, &params, &resp, NULL) != 0) {
+            received = -1;
+            break;
+        }
+
+        TRACE_BEGIN("parse_employees");
+        int parsed = ohrm_employee_list_parse(resp.buffer, resp.size, &page);
+        TRACE_END("parse_employees");
+        if (parsed != 0) {
+            fprintf(stderr, "Unexpected employee list response\n");
+            received = -1;
+            break;
+        }
+
+        /* Items without an empNumber or with oversized fields are skipped */
+        JsonIterator items;
+        JsonSlice index, item;
+        size_t page_len = 0;
+        json_scan_iter_init(&items, &page.data);
+        while (json_scan_iter_next(&items, &index, &item) == JSON_SCAN_FOUND) {
+            OhrmEmployee employee;
+            EmployeeRecord record;
+            int deleted;
+            page_len++;
+            if (ohrm_employee_decode(&item, &employee) != 0) {
+                continue;
+            }
+            parse_employee(&employee, &record, &deleted);
+            if (merge_list_push(list, &record, deleted) != 0) {
+                received = -1;
+                break;
+            }
+            received++;
+        }
+
+        if (received < 0 || page_len < EMPLOYEE_SYNC_PAGE_SIZE) {
+            break;
+        }
+        params.offset += (int64_t)page_len;
+    }
+
+    response_buffer_free(&resp);
+    return received;
+}
+
+static void insert_slot(uint32_t *slots, uint32_t mask, uint32_t hash, uint32_t value) {
+    uint32_t i = hash & mask;
+    while (slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = value;
+}
+
+/**
+ * Write records and their hash slots to a temporary file and rename it over the index
+ */
+static int write_index(const char *path, const EmployeeRecord *records, uint32_t count, int64_t last_modified) {
+    EmployeeIndexHeader header;
+    char tmp_path[MAX_URL_SIZE];
+    uint32_t slot_count = slot_count_for(count * 2);
+    uint32_t mask = slot_count - 1;
+    int result = -1;
+
+    uint32_t *slots = (uint32_t *)mem_calloc(MEM_DIRECTORY, (size_t)slot_count * 2, sizeof(uint32_t));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation failed for employee index slots\n");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        insert_slot(slots, mask, hash_number(records[i].emp_number), i + 1);
+        if (records[i].name[0] != '\0') {
+            insert_slot(slots + slot_count, mask, hash_name(records[i].name), i + 1);
+        }
+        if (records[i].employee_id[0] != '\0') {
+            insert_slot(slots + slot_count, mask, hash_name(records[i].employee_id), i + 1);
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EMPLOYEE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = EMPLOYEE_INDEX_VERSION;
+    header.record_count = count;
+    header.slot_count = slot_count;
+    header.last_modified = last_modified;
+    header.synced_at = (int64_t)time(NULL);
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        perror("Failed to create employee index");
+        mem_free(slots);
+        return -1;
+    }
+
+    if (fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(records, sizeof(EmployeeRecord), count, file) == count &&
+        fwrite(slots, sizeof(uint32_t), (size_t)slot_count * 2, file) == (size_t)slot_count * 2 &&
+        fflush(file) == 0 && fsync(fileno(file)) == 0) {
+        result = 0;
+    } else {
+        perror("Failed to write employee index");
+    }
+    fclose(file);
+    mem_free(slots);
+
+    if (result == 0 && rename(tmp_path, path) != 0) {
+        perror("Failed to replace employee index");
+        result = -1;
+    }
+    if (result != 0) {
+        unlink(tmp_path);
+    }
+    return result;
+}
+
+int employee_directory_sync(EmployeeDirectory *dir, Config *config) {
+    MergeList list;
+    EmployeeRecord *merged = NULL;
+    int64_t since;
+    int64_t last_modified;
+    int received;
+    int result = -1;
+
+    if (dir == NULL || config == NULL) {
+        fprintf(stderr, "Invalid parameters for employee_directory_sync\n");
+        return -1;
+    }
+
+    memset(&list, 0, sizeof(list));
+    pthread_mutex_lock(&dir->sync_lock);
+
+    /* Seed the merge with what is already indexed */
+    pthread_rwlock_rdlock(&dir->lock);
+    since = dir->last_modified;
+    for (uint32_t i = 0; i < dir->record_count; i++) {
+        if (merge_list_push(&list, &dir->records[i], 0) != 0) {
+            pthread_rwlock_unlock(&dir->lock);
+            goto cleanup;
+        }
+    }
+    pthread_rwlock_unlock(&dir->lock);
+
+    received = fetch_employees(config, since, &list);
+    if (received < 0) {
+        goto cleanup;
+    }
+
+    /* Sort by empNumber, later entries win, deleted employees drop out */
+    qsort(list.entries, list.count, sizeof(MergeEntry), compare_merge_entries);
+
+    merged = (EmployeeRecord *)mem_alloc(MEM_DIRECTORY, (list.count ? list.count : 1) * sizeof(EmployeeRecord));
+    if (merged == NULL) {
+        fprintf(stderr, "Memory allocation failed for employee index\n");
+        goto cleanup;
+    }
+
+    uint32_t count = 0;
+    last_modified = since;
+    for (size_t i = 0; i < list.count; i++) {
+        const MergeEntry *entry = &list.entries[i];
+        if (entry->record.modified_at > last_modified) {
+            last_modified = entry->record.modified_at;
+        }
+        if (i + 1 < list.count && list.entries[i + 1].record.emp_number == entry->record.emp_number) {
+            continue;  /* Superseded by a newer entry */
+        }
+        if (!entry->deleted) {
+            merged[count++] = entry->record;
+        }
+    }
+
+    if (write_index(dir->path, merged, count, last_modified) != 0) {
+        goto cleanup;
+    }
+
+    pthread_rwlock_wrlock(&dir->lock);
+    unmap_index(dir);
+    result = map_index(dir);
+    pthread_rwlock_unlock(&dir->lock);
+
+    if (result == 0) {
+        result = received;
+    }
+
+cleanup:
+    pthread_mutex_unlock(&dir->sync_lock);
+    mem_free(merged);
+    mem_free(list.entries);
+    return result;
+}
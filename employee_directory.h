@@ -0,0 +1,91 @@
+#ifndef EMPLOYEE_DIRECTORY_H
+#define EMPLOYEE_DIRECTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "orangehrm_client.h"
+
+#define EMPLOYEE_INDEX_FILE "employees.idx"
+/* Sized from the spec's maxLength in UTF-8 bytes, so decoded values are never cut:
+   employeeId up to 50 characters, "firstName lastName" up to 30 + 1 + 30 */
+#define EMPLOYEE_ID_SIZE 208
+#define EMPLOYEE_NAME_SIZE 248
+#define EMPLOYEE_SYNC_PAGE_SIZE 200
+
+/**
+ * Employee entry as stored in the on-disk index (fixed layout, 472 bytes)
+ */
+typedef struct {
+    int32_t emp_number;
+    uint32_t flags;                     /* reserved, always 0 */
+    int64_t modified_at;                /* server modification time (epoch seconds) */
+    char employee_id[EMPLOYEE_ID_SIZE];
+    char name[EMPLOYEE_NAME_SIZE];      /* "First Last" */
+} EmployeeRecord;
+
+/**
+ * Memory-mapped employee directory
+ *
+ * Lookups hash into open-addressing slot tables stored in the mapped file,
+ * so resolving an employee costs a couple of cache lines and no API call.
+ * A sync rewrites the index next to the old one and remaps it atomically.
+ */
+typedef struct {
+    char *path;
+    void *map;
+    size_t map_size;
+    const EmployeeRecord *records;
+    const uint32_t *number_slots;
+    const uint32_t *name_slots;
+    uint32_t record_count;
+    uint32_t slot_mask;
+    int64_t last_modified;              /* newest modified_at seen (incremental sync cursor) */
+    pthread_rwlock_t lock;              /* guards the mapping against a concurrent remap */
+    pthread_mutex_t sync_lock;          /* serializes syncs */
+} EmployeeDirectory;
+
+/**
+ * Open an employee index (a missing file yields an empty directory)
+ * @param dir Pointer to EmployeeDirectory structure
+ * @param path Index file path (NULL for EMPLOYEE_INDEX_FILE)
+ * @return 0 on success, -1 on failure
+ */
+int employee_directory_open(EmployeeDirectory *dir, const char *path);
+
+/**
+ * Unmap the index and release all resources
+ * @param dir Pointer to EmployeeDirectory structure
+ */
+void employee_directory_close(EmployeeDirectory *dir);
+
+/**
+ * Pull employees from the API and rewrite the index.
+ * The first sync pages through the full list; later syncs only request
+ * employees modified since the newest timestamp already indexed.
+ * @param dir Pointer to EmployeeDirectory structure
+ * @param config Pointer to Config structure with a valid access token
+ * @return Number of employees received on success, -1 on failure
+ */
+int employee_directory_sync(EmployeeDirectory *dir, Config *config);
+
+/**
+ * Look up an employee by empNumber
+ * @param out Receives a copy of the record
+ * @return 0 if found, -1 otherwise
+ */
+int employee_directory_find_by_number(EmployeeDirectory *dir, int32_t emp_number, EmployeeRecord *out);
+
+/**
+ * Look up an employee by full name (case-insensitive) or employee id
+ * @param out Receives a copy of the record
+ * @return 0 if found, -1 otherwise
+ */
+int employee_directory_find_by_name(EmployeeDirectory *dir, const char *name, EmployeeRecord *out);
+
+/**
+ * Number of employees currently indexed
+ */
+size_t employee_directory_count(EmployeeDirectory *dir);
+
+#endif /* EMPLOYEE_DIRECTORY_H */
@@ -0,0 +1,529 @@
+#include "future.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct ExecutorItem {
+    ExecutorTask task;
+    void *data;
+    struct ExecutorItem *next;
+} ExecutorItem;
+
+struct Executor {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    ExecutorItem *head;
+    ExecutorItem *tail;
+    int stopping;
+    int live_workers;   /* tasks may still be queued while any worker runs */
+    int thread_count;
+    pthread_t *threads;
+};
+
+typedef struct FutureCallback {
+    void (*fn)(Future *future, void *data);
+    void *data;
+    struct FutureCallback *next;
+} FutureCallback;
+
+struct Future {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    atomic_int refs;
+    int done;
+    int result;
+    void *value;
+    void (*free_value)(void *);
+    Future *source;             /* future whose value this one forwards (future_then) */
+    FutureCallback *callbacks;  /* most recently added first */
+};
+
+static Executor *g_default_executor = NULL;
+static pthread_mutex_t g_default_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ---- Executor ---- */
+
+static void *executor_worker(void *data) {
+    Executor *executor = (Executor *)data;
+
+    pthread_mutex_lock(&executor->mutex);
+    for (;;) {
+        while (executor->head == NULL && !executor->stopping) {
+            pthread_cond_wait(&executor->cond, &executor->mutex);
+        }
+        ExecutorItem *item = executor->head;
+        if (item == NULL) {
+            break;  /* Stopping and drained */
+        }
+        executor->head = item->next;
+        if (executor->head == NULL) {
+            executor->tail = NULL;
+        }
+        pthread_mutex_unlock(&executor->mutex);
+
+        item->task(item->data);
+        free(item);
+
+        pthread_mutex_lock(&executor->mutex);
+    }
+    executor->live_workers--;
+    pthread_mutex_unlock(&executor->mutex);
+
+    return NULL;
+}
+
+Executor *executor_create(int threads) {
+    if (threads <= 0) {
+        fprintf(stderr, "Executor needs at least one thread\n");
+        return NULL;
+    }
+
+    Executor *executor = (Executor *)calloc(1, sizeof(Executor));
+    if (executor == NULL) {
+        fprintf(stderr, "Failed to allocate executor\n");
+        return NULL;
+    }
+    executor->threads = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    if (executor->threads == NULL) {
+        fprintf(stderr, "Failed to allocate executor threads\n");
+        free(executor);
+        return NULL;
+    }
+
+    pthread_mutex_init(&executor->mutex, NULL);
+    pthread_cond_init(&executor->cond, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&executor->threads[i], NULL, executor_worker, executor) != 0) {
+            fprintf(stderr, "Error creating executor thread\n");
+            break;
+        }
+        executor->thread_count++;
+    }
+    executor->live_workers = executor->thread_count;
+
+    if (executor->thread_count == 0) {
+        executor_destroy(executor);
+        return NULL;
+    }
+    return executor;
+}
+
+void executor_destroy(Executor *executor) {
+    if (executor == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&executor->mutex);
+    executor->stopping = 1;
+    pthread_cond_broadcast(&executor->cond);
+    pthread_mutex_unlock(&executor->mutex);
+
+    for (int i = 0; i < executor->thread_count; i++) {
+        pthread_join(executor->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&executor->mutex);
+    pthread_cond_destroy(&executor->cond);
+    free(executor->threads);
+    free(executor);
+}
+
+int executor_submit(Executor *executor, ExecutorTask task, void *data) {
+    if (executor == NULL || task == NULL) {
+        return -1;
+    }
+
+    ExecutorItem *item = (ExecutorItem *)malloc(sizeof(ExecutorItem));
+    if (item == NULL) {
+        fprintf(stderr, "Failed to allocate executor task\n");
+        return -1;
+    }
+    item->task = task;
+    item->data = data;
+    item->next = NULL;
+
+    pthread_mutex_lock(&executor->mutex);
+    if (executor->live_workers == 0) {
+        pthread_mutex_unlock(&executor->mutex);
+        free(item);
+        fprintf(stderr, "Executor is shut down\n");
+        return -1;
+    }
+    if (executor->tail != NULL) {
+        executor->tail->next = item;
+    } else {
+        executor->head = item;
+    }
+    executor->tail = item;
+    pthread_cond_signal(&executor->cond);
+    pthread_mutex_unlock(&executor->mutex);
+
+    return 0;
+}
+
+Executor *executor_default(void) {
+    pthread_mutex_lock(&g_default_mutex);
+    if (g_default_executor == NULL) {
+        g_default_executor = executor_create(EXECUTOR_DEFAULT_THREADS);
+    }
+    Executor *executor = g_default_executor;
+    pthread_mutex_unlock(&g_default_mutex);
+    return executor;
+}
+
+void executor_default_shutdown(void) {
+    pthread_mutex_lock(&g_default_mutex);
+    Executor *executor = g_default_executor;
+    g_default_executor = NULL;
+    pthread_mutex_unlock(&g_default_mutex);
+
+    executor_destroy(executor);
+}
+
+/* ---- Futures ---- */
+
+Future *future_new(void) {
+    pthread_condattr_t attr;
+
+    Future *future = (Future *)calloc(1, sizeof(Future));
+    if (future == NULL) {
+        fprintf(stderr, "Failed to allocate future\n");
+        return NULL;
+    }
+
+    pthread_mutex_init(&future->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&future->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    atomic_init(&future->refs, 1);
+    future->result = -1;
+    return future;
+}
+
+Future *future_retain(Future *future) {
+    if (future != NULL) {
+        atomic_fetch_add_explicit(&future->refs, 1, memory_order_relaxed);
+    }
+    return future;
+}
+
+void future_release(Future *future) {
+    if (future == NULL || atomic_fetch_sub_explicit(&future->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    /* Continuations hold their own references, so none can be pending here */
+    if (future->free_value != NULL) {
+        future->free_value(future->value);
+    }
+    future_release(future->source);
+    pthread_mutex_destroy(&future->mutex);
+    pthread_cond_destroy(&future->cond);
+    free(future);
+}
+
+/**
+ * Mark the future done and run its continuations in registration order
+ */
+static void resolve(Future *future, int result, void *value, void (*free_value)(void *), Future *source) {
+    FutureCallback *callbacks = NULL;
+
+    pthread_mutex_lock(&future->mutex);
+    if (future->done) {
+        pthread_mutex_unlock(&future->mutex);
+        if (free_value != NULL) {
+            free_value(value);
+        }
+        return;
+    }
+    future->done = 1;
+    future->result = result;
+    future->value = value;
+    future->free_value = free_value;
+    future->source = future_retain(source);
+
+    /* Reverse into registration order */
+    while (future->callbacks != NULL) {
+        FutureCallback *next = future->callbacks->next;
+        future->callbacks->next = callbacks;
+        callbacks = future->callbacks;
+        future->callbacks = next;
+    }
+    pthread_cond_broadcast(&future->cond);
+    pthread_mutex_unlock(&future->mutex);
+
+    future_retain(future);  /* Continuations may drop the last outside reference */
+    while (callbacks != NULL) {
+        FutureCallback *next = callbacks->next;
+        callbacks->fn(future, callbacks->data);
+        free(callbacks);
+        callbacks = next;
+    }
+    future_release(future);
+}
+
+void future_complete(Future *future, int result, void *value, void (*free_value)(void *)) {
+    if (future == NULL) {
+        if (free_value != NULL) {
+            free_value(value);
+        }
+        return;
+    }
+    resolve(future, result, value, free_value, NULL);
+}
+
+/**
+ * Run fn when the future is done (immediately if it already is)
+ * @return 0 on success, -1 if the callback could not be registered
+ */
+static int on_complete(Future *future, void (*fn)(Future *, void *), void *data) {
+    pthread_mutex_lock(&future->mutex);
+    if (!future->done) {
+        FutureCallback *callback = (FutureCallback *)malloc(sizeof(FutureCallback));
+        if (callback == NULL) {
+            pthread_mutex_unlock(&future->mutex);
+            fprintf(stderr, "Failed to allocate future continuation\n");
+            return -1;
+        }
+        callback->fn = fn;
+        callback->data = data;
+        callback->next = future->callbacks;
+        future->callbacks = callback;
+        pthread_mutex_unlock(&future->mutex);
+        return 0;
+    }
+    pthread_mutex_unlock(&future->mutex);
+
+    fn(future, data);
+    return 0;
+}
+
+int future_wait_for(Future *future, int timeout_ms) {
+    struct timespec deadline;
+    int done;
+
+    if (future == NULL) {
+        return -1;
+    }
+
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&future->mutex);
+    while (!future->done) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&future->cond, &future->mutex);
+        } else if (pthread_cond_timedwait(&future->cond, &future->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    done = future->done;
+    pthread_mutex_unlock(&future->mutex);
+
+    return done ? 0 : -1;
+}
+
+int future_result(Future *future) {
+    int result;
+
+    if (future == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&future->mutex);
+    result = future->done ? future->result : -1;
+    pthread_mutex_unlock(&future->mutex);
+    return result;
+}
+
+void *future_value(Future *future) {
+    void *value = NULL;
+
+    if (future == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&future->mutex);
+    if (future->done) {
+        value = future->source != NULL ? future_value(future->source) : future->value;
+    }
+    pthread_mutex_unlock(&future->mutex);
+    return value;
+}
+
+/* ---- future_run ---- */
+
+typedef struct {
+    int (*task)(void *data, void **value);
+    void *data;
+    void (*free_value)(void *);
+    Future *future;
+} RunState;
+
+static void run_task(void *data) {
+    RunState *state = (RunState *)data;
+    void *value = NULL;
+
+    int result = state->task(state->data, &value);
+    future_complete(state->future, result, value, state->free_value);
+    future_release(state->future);
+    free(state);
+}
+
+Future *future_run(Executor *executor, int (*task)(void *data, void **value), void *data,
+                   void (*free_value)(void *)) {
+    if (task == NULL) {
+        return NULL;
+    }
+    if (executor == NULL) {
+        executor = executor_default();
+        if (executor == NULL) {
+            return NULL;
+        }
+    }
+
+    RunState *state = (RunState *)malloc(sizeof(RunState));
+    Future *future = future_new();
+    if (state == NULL || future == NULL) {
+        free(state);
+        future_release(future);
+        return NULL;
+    }
+
+    state->task = task;
+    state->data = data;
+    state->free_value = free_value;
+    state->future = future_retain(future);
+
+    if (executor_submit(executor, run_task, state) != 0) {
+        free(state);
+        future_release(future);
+        future_release(future);
+        return NULL;
+    }
+    return future;
+}
+
+/* ---- future_then ---- */
+
+typedef struct {
+    FutureThenFn fn;
+    void *data;
+    Future *out;
+} ThenState;
+
+/**
+ * Resolve the chained future with the inner step's outcome
+ */
+static void forward_result(Future *inner, void *data) {
+    Future *out = (Future *)data;
+    resolve(out, inner->result, NULL, NULL, inner);
+    future_release(out);
+}
+
+static void then_callback(Future *previous, void *data) {
+    ThenState *state = (ThenState *)data;
+    Future *out = state->out;
+
+    Future *inner = state->fn(previous, state->data);
+    free(state);
+
+    if (inner == NULL) {
+        future_complete(out, -1, NULL, NULL);
+        future_release(out);
+        return;
+    }
+    if (on_complete(inner, forward_result, out) != 0) {
+        future_complete(out, -1, NULL, NULL);
+        future_release(out);
+    }
+    future_release(inner);
+}
+
+Future *future_then(Future *future, FutureThenFn fn, void *data) {
+    if (future == NULL || fn == NULL) {
+        return NULL;
+    }
+
+    ThenState *state = (ThenState *)malloc(sizeof(ThenState));
+    Future *out = future_new();
+    if (state == NULL || out == NULL) {
+        free(state);
+        future_release(out);
+        return NULL;
+    }
+
+    state->fn = fn;
+    state->data = data;
+    state->out = future_retain(out);
+
+    if (on_complete(future, then_callback, state) != 0) {
+        free(state);
+        future_release(out);
+        future_release(out);
+        return NULL;
+    }
+    return out;
+}
+
+/* ---- future_when_all ---- */
+
+typedef struct {
+    atomic_int remaining;
+    atomic_int failed;
+    Future *out;
+} WhenAllState;
+
+static void when_all_callback(Future *future, void *data) {
+    WhenAllState *state = (WhenAllState *)data;
+
+    if (future == NULL || future->result != 0) {
+        atomic_store(&state->failed, 1);
+    }
+    if (atomic_fetch_sub(&state->remaining, 1) == 1) {
+        future_complete(state->out, atomic_load(&state->failed) ? -1 : 0, NULL, NULL);
+        future_release(state->out);
+        free(state);
+    }
+}
+
+Future *future_when_all(Future **futures, int count) {
+    if (count < 0 || (count > 0 && futures == NULL)) {
+        return NULL;
+    }
+
+    Future *out = future_new();
+    if (out == NULL) {
+        return NULL;
+    }
+    if (count == 0) {
+        future_complete(out, 0, NULL, NULL);
+        return out;
+    }
+
+    WhenAllState *state = (WhenAllState *)malloc(sizeof(WhenAllState));
+    if (state == NULL) {
+        future_release(out);
+        return NULL;
+    }
+    atomic_init(&state->remaining, count);
+    atomic_init(&state->failed, 0);
+    state->out = future_retain(out);
+
+    for (int i = 0; i < count; i++) {
+        if (futures[i] == NULL || on_complete(futures[i], when_all_callback, state) != 0) {
+            when_all_callback(NULL, state);  /* Counts as a failed input */
+        }
+    }
+    return out;
+}
@@ -0,0 +1,125 @@
+#ifndef FUTURE_H
+#define FUTURE_H
+
+#define EXECUTOR_DEFAULT_THREADS 4
+
+/**
+ * Fixed pool of worker threads running submitted tasks in FIFO order.
+ * This is the client's event loop: async calls and future continuations
+ * run here.
+ */
+typedef struct Executor Executor;
+
+/**
+ * Result of an asynchronous operation (reference counted)
+ */
+typedef struct Future Future;
+
+typedef void (*ExecutorTask)(void *data);
+
+/**
+ * Continuation for future_then: called with the completed previous future
+ * (borrowed) on the thread that completed it, or inside future_then if it
+ * was already done. It should start work, not block on it.
+ * @return Future for the next step (the chain takes over this reference),
+ *         or NULL to fail the chain
+ */
+typedef Future *(*FutureThenFn)(Future *previous, void *data);
+
+/**
+ * Create an executor
+ * @param threads Number of worker threads
+ * @return New executor, NULL on failure
+ */
+Executor *executor_create(int threads);
+
+/**
+ * Run queued tasks to completion, then stop and free the executor
+ */
+void executor_destroy(Executor *executor);
+
+/**
+ * Queue a task
+ * @return 0 on success, -1 if the executor is shutting down or out of memory
+ */
+int executor_submit(Executor *executor, ExecutorTask task, void *data);
+
+/**
+ * Shared executor used by the async client calls (created on first use
+ * with EXECUTOR_DEFAULT_THREADS workers)
+ * @return Executor, NULL on failure
+ */
+Executor *executor_default(void);
+
+/**
+ * Destroy the shared executor (called by orangehrm_client_cleanup)
+ */
+void executor_default_shutdown(void);
+
+/**
+ * Create a pending future with one reference
+ */
+Future *future_new(void);
+
+/**
+ * Resolve a future and run its continuations (only the first call counts)
+ * @param future Future to resolve
+ * @param result 0 for success, -1 for failure
+ * @param value Result value owned by the future from now on (may be NULL)
+ * @param free_value Frees value when the future is freed (may be NULL)
+ */
+void future_complete(Future *future, int result, void *value, void (*free_value)(void *));
+
+/**
+ * Run task on the executor and resolve the returned future with its result
+ * @param executor Executor, NULL for executor_default()
+ * @param task Returns 0 or -1 and may store a value to hand over
+ * @param data Passed to task
+ * @param free_value Frees the value stored by task
+ * @return New future, NULL on failure (task is not run, data stays with the caller)
+ */
+Future *future_run(Executor *executor, int (*task)(void *data, void **value), void *data,
+                   void (*free_value)(void *));
+
+/**
+ * Start the next step once future is done. fn sees the previous future
+ * whether it succeeded or failed, so it decides how to handle errors.
+ * @return Future resolving with the result of the future fn returns, NULL on failure
+ */
+Future *future_then(Future *future, FutureThenFn fn, void *data);
+
+/**
+ * Future resolving once all futures are done: result 0 if all succeeded,
+ * -1 otherwise (inspect the inputs for their values)
+ * @return New future, NULL on failure
+ */
+Future *future_when_all(Future **futures, int count);
+
+/**
+ * Wait for a future to complete
+ * @param timeout_ms Maximum time to wait, negative to wait forever
+ * @return 0 if the future is done, -1 on timeout
+ */
+int future_wait_for(Future *future, int timeout_ms);
+
+/**
+ * Result of a completed future (-1 while still pending)
+ */
+int future_result(Future *future);
+
+/**
+ * Value of a completed future (borrowed, valid while the future is referenced)
+ */
+void *future_value(Future *future);
+
+/**
+ * Take an extra reference
+ */
+Future *future_retain(Future *future);
+
+/**
+ * Drop a reference (NULL is ignored); the last one frees the future and its value
+ */
+void future_release(Future *future);
+
+#endif /* FUTURE_H */
@@ -0,0 +1,510 @@
+#include "json_scan.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const char *skip_ws(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Find the closing quote of a string
+ * @param p First byte after the opening quote
+ * @return Pointer to the closing quote, NULL if the string is unterminated
+ */
+static const char *string_end(const char *p, const char *end) {
+    for (;;) {
+#if defined(__SSE2__)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                      _mm_cmpeq_epi8(chunk, backslash)));
+            if (mask != 0) {
+                p += __builtin_ctz((unsigned int)mask);
+                break;
+            }
+            p += 16;
+        }
+#endif
+        while (p < end && *p != '"' && *p != '\\') {
+            p++;
+        }
+        if (p >= end) {
+            return NULL;
+        }
+        if (*p == '"') {
+            return p;
+        }
+        p += 2;  /* Backslash and the escaped byte */
+    }
+}
+
+static int is_structural(char c) {
+    return c == '"' || c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+/**
+ * Skip a whole object or array
+ * @param p Opening brace or bracket
+ * @return Pointer after the matching close, NULL if unterminated
+ */
+static const char *container_end(const char *p, const char *end) {
+    int depth = 0;
+
+    while (p < end) {
+#if defined(__SSE2__)
+        /* '[' / ']' become '{' / '}' when bit 0x20 is set; no other byte does */
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i open = _mm_set1_epi8('{');
+        const __m128i close = _mm_set1_epi8('}');
+        const __m128i fold = _mm_set1_epi8(0x20);
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+            __m128i folded = _mm_or_si128(chunk, fold);
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                        _mm_or_si128(_mm_cmpeq_epi8(folded, open),
+                                                     _mm_cmpeq_epi8(folded, close)));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0) {
+                p += __builtin_ctz((unsigned int)mask);
+                break;
+            }
+            p += 16;
+        }
+#endif
+        while (p < end && !is_structural(*p)) {
+            p++;
+        }
+        if (p >= end) {
+            return NULL;
+        }
+
+        if (*p == '"') {
+            p = string_end(p + 1, end);
+            if (p == NULL) {
+                return NULL;
+            }
+            p++;
+            continue;
+        }
+
+        depth += (*p == '{' || *p == '[') ? 1 : -1;
+        p++;
+        if (depth == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static const char *literal_end(const char *p, const char *end, const char *literal, size_t length) {
+    if ((size_t)(end - p) < length || memcmp(p, literal, length) != 0) {
+        return NULL;
+    }
+    return p + length;
+}
+
+/**
+ * Delimit the value starting at p
+ * @return Pointer after the value, NULL if it is malformed
+ */
+static const char *scan_value(const char *p, const char *end, JsonSlice *slice) {
+    const char *q;
+
+    if (p >= end) {
+        return NULL;
+    }
+
+    slice->ptr = p;
+    switch (*p) {
+    case '"':
+        q = string_end(p + 1, end);
+        if (q == NULL) {
+            return NULL;
+        }
+        slice->ptr = p + 1;
+        slice->length = (size_t)(q - (p + 1));
+        slice->type = JSON_SCAN_STRING;
+        return q + 1;
+    case '{':
+    case '[':
+        slice->type = *p == '{' ? JSON_SCAN_OBJECT : JSON_SCAN_ARRAY;
+        q = container_end(p, end);
+        break;
+    case 't':
+        slice->type = JSON_SCAN_TRUE;
+        q = literal_end(p, end, "true", 4);
+        break;
+    case 'f':
+        slice->type = JSON_SCAN_FALSE;
+        q = literal_end(p, end, "false", 5);
+        break;
+    case 'n':
+        slice->type = JSON_SCAN_NULL;
+        q = literal_end(p, end, "null", 4);
+        break;
+    default:
+        if (*p != '-' && (*p < '0' || *p > '9')) {
+            return NULL;
+        }
+        slice->type = JSON_SCAN_NUMBER;
+        q = p + 1;
+        while (q < end && ((*q >= '0' && *q <= '9') || *q == '.' || *q == 'e' || *q == 'E' ||
+                           *q == '+' || *q == '-')) {
+            q++;
+        }
+        break;
+    }
+
+    if (q != NULL) {
+        slice->length = (size_t)(q - p);
+    }
+    return q;
+}
+
+/**
+ * Find a key in the object at p
+ * @param value Receives the start of the member's value
+ */
+static int find_member(const char *p, const char *end, const char *key, size_t key_length, const char **value) {
+    JsonSlice skipped;
+
+    p = skip_ws(p + 1, end);
+    if (p < end && *p == '}') {
+        return JSON_SCAN_NOT_FOUND;
+    }
+
+    for (;;) {
+        if (p >= end || *p != '"') {
+            return JSON_SCAN_MALFORMED;
+        }
+        const char *key_end = string_end(p + 1, end);
+        if (key_end == NULL) {
+            return JSON_SCAN_MALFORMED;
+        }
+        int match = (size_t)(key_end - (p + 1)) == key_length && memcmp(p + 1, key, key_length) == 0;
+
+        p = skip_ws(key_end + 1, end);
+        if (p >= end || *p != ':') {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p + 1, end);
+        if (match) {
+            *value = p;
+            return JSON_SCAN_FOUND;
+        }
+
+        p = scan_value(p, end, &skipped);
+        if (p == NULL) {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p, end);
+        if (p < end && *p == '}') {
+            return JSON_SCAN_NOT_FOUND;
+        }
+        if (p >= end || *p != ',') {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p + 1, end);
+    }
+}
+
+/**
+ * Find the element with the given index in the array at p
+ */
+static int find_element(const char *p, const char *end, long index, const char **value) {
+    JsonSlice skipped;
+
+    p = skip_ws(p + 1, end);
+    if (p < end && *p == ']') {
+        return JSON_SCAN_NOT_FOUND;
+    }
+
+    for (long i = 0;; i++) {
+        if (i == index) {
+            *value = p;
+            return JSON_SCAN_FOUND;
+        }
+        p = scan_value(p, end, &skipped);
+        if (p == NULL) {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p, end);
+        if (p < end && *p == ']') {
+            return JSON_SCAN_NOT_FOUND;
+        }
+        if (p >= end || *p != ',') {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p + 1, end);
+    }
+}
+
+/**
+ * Parse a path component as an array index
+ * @return Index, -1 if the component is not a number
+ */
+static long component_index(const char *component, size_t length) {
+    long index = 0;
+
+    if (length == 0 || length > 9) {
+        return -1;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (component[i] < '0' || component[i] > '9') {
+            return -1;
+        }
+        index = index * 10 + (component[i] - '0');
+    }
+    return index;
+}
+
+int json_scan_find(const char *json, size_t length, const char *path, JsonSlice *out) {
+    const char *end = json + length;
+    const char *p;
+    const char *component = path;
+    JsonSlice slice;
+
+    if (json == NULL || path == NULL || out == NULL) {
+        return JSON_SCAN_MALFORMED;
+    }
+
+    p = skip_ws(json, end);
+    while (*component != '\0') {
+        size_t component_length = strcspn(component, ".");
+        int status;
+
+        if (p < end && *p == '{') {
+            status = find_member(p, end, component, component_length, &p);
+        } else if (p < end && *p == '[') {
+            long index = component_index(component, component_length);
+            status = index < 0 ? JSON_SCAN_NOT_FOUND : find_element(p, end, index, &p);
+        } else {
+            /* A scalar has no members; garbage is malformed */
+            status = scan_value(p, end, &slice) != NULL ? JSON_SCAN_NOT_FOUND : JSON_SCAN_MALFORMED;
+        }
+        if (status != JSON_SCAN_FOUND) {
+            return status;
+        }
+
+        component += component_length;
+        if (*component == '.') {
+            component++;
+        }
+    }
+
+    if (scan_value(p, end, out) == NULL) {
+        return JSON_SCAN_MALFORMED;
+    }
+    return JSON_SCAN_FOUND;
+}
+
+int json_scan_iter_init(JsonIterator *iterator, const JsonSlice *container) {
+    if (container == NULL || (container->type != JSON_SCAN_OBJECT && container->type != JSON_SCAN_ARRAY)) {
+        return -1;
+    }
+    /* The slice spans the brackets; start inside them */
+    iterator->p = container->ptr + 1;
+    iterator->end = container->ptr + container->length - 1;
+    iterator->close = container->type == JSON_SCAN_OBJECT ? '}' : ']';
+    iterator->started = 0;
+    return 0;
+}
+
+int json_scan_iter_next(JsonIterator *iterator, JsonSlice *key, JsonSlice *value) {
+    const char *p = skip_ws(iterator->p, iterator->end);
+    const char *end = iterator->end;
+
+    if (p >= end) {
+        return JSON_SCAN_NOT_FOUND;
+    }
+    if (iterator->started) {
+        if (*p != ',') {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p + 1, end);
+    }
+
+    if (iterator->close == '}') {
+        JsonSlice member_key;
+        p = scan_value(p, end, &member_key);
+        if (p == NULL || member_key.type != JSON_SCAN_STRING) {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p, end);
+        if (p >= end || *p != ':') {
+            return JSON_SCAN_MALFORMED;
+        }
+        p = skip_ws(p + 1, end);
+        if (key != NULL) {
+            *key = member_key;
+        }
+    }
+
+    p = scan_value(p, end, value);
+    if (p == NULL) {
+        return JSON_SCAN_MALFORMED;
+    }
+    iterator->p = p;
+    iterator->started = 1;
+    return JSON_SCAN_FOUND;
+}
+
+static int hex_value(const char *p, unsigned int *value) {
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *value <<= 4;
+        if (c >= '0' && c <= '9') {
+            *value |= (unsigned int)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            *value |= (unsigned int)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            *value |= (unsigned int)(c - 'A' + 10);
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Encode a code point as UTF-8
+ * @return Number of bytes written, 0 if it does not fit
+ */
+static size_t put_utf8(unsigned int code, char *out, size_t space) {
+    if (code < 0x80 && space >= 1) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800 && space >= 2) {
+        out[0] = (char)(0xC0 | (code >> 6));
+        out[1] = (char)(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000 && space >= 3) {
+        out[0] = (char)(0xE0 | (code >> 12));
+        out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (code & 0x3F));
+        return 3;
+    }
+    if (code >= 0x10000 && space >= 4) {
+        out[0] = (char)(0xF0 | (code >> 18));
+        out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        out[3] = (char)(0x80 | (code & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+int json_scan_string(const JsonSlice *slice, char *buffer, size_t size) {
+    size_t n = 0;
+
+    if (slice == NULL || slice->type != JSON_SCAN_STRING || buffer == NULL || size == 0) {
+        return -1;
+    }
+
+    const char *p = slice->ptr;
+    const char *end = p + slice->length;
+    while (p < end) {
+        /* Copy the run up to the next escape in one go */
+        const char *escape = (const char *)memchr(p, '\\', (size_t)(end - p));
+        size_t run = (size_t)((escape != NULL ? escape : end) - p);
+        if (n + run >= size) {
+            return -1;
+        }
+        memcpy(buffer + n, p, run);
+        n += run;
+        p += run;
+        if (p == end) {
+            break;
+        }
+
+        if (end - p < 2) {
+            return -1;
+        }
+        char c = p[1];
+        p += 2;
+        if (c == 'u') {
+            unsigned int code;
+            if (end - p < 4 || hex_value(p, &code) != 0) {
+                return -1;
+            }
+            p += 4;
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                unsigned int low;
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || hex_value(p + 2, &low) != 0 ||
+                    low < 0xDC00 || low > 0xDFFF) {
+                    return -1;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            }
+            size_t written = put_utf8(code, buffer + n, size - n - 1);
+            if (written == 0) {
+                return -1;
+            }
+            n += written;
+            continue;
+        }
+
+        switch (c) {
+        case '"':  c = '"';  break;
+        case '\\': c = '\\'; break;
+        case '/':  c = '/';  break;
+        case 'b':  c = '\b'; break;
+        case 'f':  c = '\f'; break;
+        case 'n':  c = '\n'; break;
+        case 'r':  c = '\r'; break;
+        case 't':  c = '\t'; break;
+        default:
+            return -1;
+        }
+        if (n + 1 >= size) {
+            return -1;
+        }
+        buffer[n++] = c;
+    }
+
+    buffer[n] = '\0';
+    return (int)n;
+}
+
+int json_scan_bool(const JsonSlice *slice, int *value) {
+    if (slice == NULL || (slice->type != JSON_SCAN_TRUE && slice->type != JSON_SCAN_FALSE)) {
+        return -1;
+    }
+    *value = slice->type == JSON_SCAN_TRUE;
+    return 0;
+}
+
+int json_scan_long(const JsonSlice *slice, long long *value) {
+    char digits[32];
+    char *parsed_end;
+
+    if (slice == NULL || (slice->type != JSON_SCAN_NUMBER && slice->type != JSON_SCAN_STRING) ||
+        slice->length == 0 || slice->length >= sizeof(digits)) {
+        return -1;
+    }
+
+    memcpy(digits, slice->ptr, slice->length);
+    digits[slice->length] = '\0';
+
+    errno = 0;
+    long long result = strtoll(digits, &parsed_end, 10);
+    if (errno != 0 || *parsed_end != '\0') {
+        return -1;
+    }
+    *value = result;
+    return 0;
+}
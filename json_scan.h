@@ -0,0 +1,100 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+
+/**
+ * Lazy JSON field lookup for hot, small responses.
+ *
+ * Instead of building a json-c object tree, the scanner walks the raw
+ * response bytes, descends only along the requested path and skips every
+ * other value structurally (SSE2 accelerated where available). Nothing is
+ * allocated; results point into the caller's buffer.
+ *
+ * Keys are compared byte-wise, so keys written with escape sequences do
+ * not match. Skipped values are not validated.
+ */
+
+#define JSON_SCAN_FOUND 0
+#define JSON_SCAN_NOT_FOUND 1
+#define JSON_SCAN_MALFORMED (-1)
+
+typedef enum {
+    JSON_SCAN_STRING = 0,
+    JSON_SCAN_NUMBER,
+    JSON_SCAN_TRUE,
+    JSON_SCAN_FALSE,
+    JSON_SCAN_NULL,
+    JSON_SCAN_OBJECT,
+    JSON_SCAN_ARRAY
+} JsonScanType;
+
+/**
+ * A value inside the scanned buffer (strings exclude their quotes and are
+ * still escaped)
+ */
+typedef struct {
+    const char *ptr;
+    size_t length;
+    JsonScanType type;
+} JsonSlice;
+
+/**
+ * Cursor over the members of an object or the elements of an array
+ */
+typedef struct {
+    const char *p;
+    const char *end;
+    char close;     /* '}' or ']' */
+    int started;
+} JsonIterator;
+
+/**
+ * Locate a value by path
+ * @param json Buffer holding a JSON document
+ * @param length Length of the document in bytes
+ * @param path Dot separated object keys; numeric components index arrays
+ *             (e.g. "access_token", "data.0.empNumber")
+ * @param out Receives the value on success
+ * @return JSON_SCAN_FOUND, JSON_SCAN_NOT_FOUND, or JSON_SCAN_MALFORMED if the
+ *         document is not valid along the way
+ */
+int json_scan_find(const char *json, size_t length, const char *path, JsonSlice *out);
+
+/**
+ * Start iterating an object or array value
+ * @return 0 on success, -1 if the slice is not an object or array
+ */
+int json_scan_iter_init(JsonIterator *iterator, const JsonSlice *container);
+
+/**
+ * Advance to the next member or element
+ * @param key Receives the member key (objects only, may be NULL)
+ * @param value Receives the member value or element
+ * @return JSON_SCAN_FOUND, JSON_SCAN_NOT_FOUND at the end, or JSON_SCAN_MALFORMED
+ */
+int json_scan_iter_next(JsonIterator *iterator, JsonSlice *key, JsonSlice *value);
+
+/**
+ * Copy a string value, resolving escape sequences (\uXXXX to UTF-8)
+ * @param slice String value from json_scan_find
+ * @param buffer Output buffer (NUL terminated on success)
+ * @param size Size of the output buffer; slice->length + 1 is always enough
+ * @return Length written, -1 if the value is not a string, is badly escaped
+ *         or does not fit
+ */
+int json_scan_string(const JsonSlice *slice, char *buffer, size_t size);
+
+/**
+ * Read a boolean value
+ * @return 0 on success, -1 if the value is not true or false
+ */
+int json_scan_bool(const JsonSlice *slice, int *value);
+
+/**
+ * Read an integer value (also accepts an integer written as a string)
+ * @return 0 on success, -1 if the value is not an integer
+ */
+int json_scan_long(const JsonSlice *slice, long long *value);
+
+#endif /* JSON_SCAN_H */
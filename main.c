@@ -1,14 +1,23 @@
 #include "orangehrm_client.h"
+#include "employee_directory.h"
+#include "attendance_record.h"
+#include "attendance_store.h"
+#include "circuit_breaker.h"
+#include "token_holder.h"
+#include "token_cache.h"
+#include "trace.h"
+#include "orangehrm_api.h"
 #include <gtk/gtk.h>
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
-#include <json-c/json.h>
 
 #define APP_ICON_PATH "assets/icon.png"
 #define TIMER_INTERVAL_MS 1000
+#define DIRECTORY_SYNC_INTERVAL_S 900
+#define TOKEN_WAIT_MS 10000
 
 /* Global state */
 static time_t g_start_time = 0;
@@ -18,6 +27,25 @@ static GtkWidget *g_time_label = NULL;
 static GtkWidget *g_main_window = NULL;
 static Config g_config;
 static pthread_mutex_t g_config_mutex = PTHREAD_MUTEX_INITIALIZER;
+static EmployeeDirectory g_directory;
+static TokenHolder g_token_holder;
+static AttendanceStore g_store;
+static int g_store_ready = 0;
+static int g_directory_ready = 0;
+
+/* Background workers still running; shutdown waits for them before tearing down shared state */
+static pthread_mutex_t g_workers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_workers_done = PTHREAD_COND_INITIALIZER;
+static int g_workers_active = 0;
+static int g_workers_closed = 0;
+
+/**
+ * Entry point and argument of a background worker
+ */
+typedef struct {
+    void *(*run)(void *);
+    void *data;
+} WorkerStart;
 
 /**
  * Thread data structure for passing punch data safely
@@ -202,7 +230,9 @@ typedef struct {
 
 static gboolean show_toast_idle(gpointer data) {
     ToastMessage *msg = (ToastMessage *)data;
+    TRACE_BEGIN("ui_show_toast");
     show_toast(msg->message, msg->is_error);
+    TRACE_END("ui_show_toast");
     free(msg->message);
     free(msg);
     return FALSE;
@@ -240,6 +270,248 @@ static void show_success_async(const char *message) {
     }
 }
 
+/**
+ * Thread entry of every background worker: run it, then count it finished
+ */
+static void *worker_main(void *data) {
+    WorkerStart start = *(WorkerStart *)data;
+    free(data);
+    start.run(start.data);
+
+    pthread_mutex_lock(&g_workers_mutex);
+    if (--g_workers_active == 0) {
+        pthread_cond_broadcast(&g_workers_done);
+    }
+    pthread_mutex_unlock(&g_workers_mutex);
+    return NULL;
+}
+
+/**
+ * Run a background worker on a detached thread, counted so shutdown can wait for it
+ * @return 0 on success, -1 if the thread was not started (data is not freed)
+ */
+static int start_worker(void *(*run)(void *), void *data) {
+    WorkerStart *start = (WorkerStart *)malloc(sizeof(WorkerStart));
+    if (start == NULL) {
+        return -1;
+    }
+    start->run = run;
+    start->data = data;
+
+    pthread_mutex_lock(&g_workers_mutex);
+    if (g_workers_closed) {
+        pthread_mutex_unlock(&g_workers_mutex);
+        free(start);
+        return -1;
+    }
+    g_workers_active++;
+    pthread_mutex_unlock(&g_workers_mutex);
+
+    pthread_t thread;
+    int ret = pthread_create(&thread, NULL, worker_main, start);
+    if (ret != 0) {
+        free(start);
+        pthread_mutex_lock(&g_workers_mutex);
+        if (--g_workers_active == 0) {
+            pthread_cond_broadcast(&g_workers_done);
+        }
+        pthread_mutex_unlock(&g_workers_mutex);
+        return -1;
+    }
+    pthread_detach(thread);
+    return 0;
+}
+
+/**
+ * Refuse new workers and wait for the running ones (their requests have deadlines)
+ */
+static void wait_for_workers(void) {
+    pthread_mutex_lock(&g_workers_mutex);
+    g_workers_closed = 1;
+    while (g_workers_active > 0) {
+        pthread_cond_wait(&g_workers_done, &g_workers_mutex);
+    }
+    pthread_mutex_unlock(&g_workers_mutex);
+}
+
+/**
+ * Copy config values into thread data under mutex protection
+ */
+static void copy_credentials(PunchThreadData *punch_data) {
+    pthread_mutex_lock(&g_config_mutex);
+    if (g_config.username != NULL) {
+        strncpy(punch_data->username, g_config.username, sizeof(punch_data->username) - 1);
+    }
+    if (g_config.base_url != NULL) {
+        strncpy(punch_data->base_url, g_config.base_url, sizeof(punch_data->base_url) - 1);
+    }
+    if (g_config.client_id != NULL) {
+        strncpy(punch_data->client_id, g_config.client_id, sizeof(punch_data->client_id) - 1);
+    }
+    if (g_config.client_secret != NULL) {
+        strncpy(punch_data->client_secret, g_config.client_secret, sizeof(punch_data->client_secret) - 1);
+    }
+    if (g_config.password != NULL) {
+        strncpy(punch_data->password, g_config.password, sizeof(punch_data->password) - 1);
+    }
+    if (g_config.type != NULL) {
+        strncpy(punch_data->type, g_config.type, sizeof(punch_data->type) - 1);
+    }
+    pthread_mutex_unlock(&g_config_mutex);
+}
+
+/**
+ * Point a thread-local config at the credentials copied into thread data
+ */
+static void thread_config_from(Config *thread_config, PunchThreadData *punch_data) {
+    memset(thread_config, 0, sizeof(Config));
+    thread_config->base_url = punch_data->base_url;
+    thread_config->username = punch_data->username;
+    thread_config->password = punch_data->password;
+    thread_config->client_id = punch_data->client_id;
+    thread_config->client_secret = punch_data->client_secret;
+    thread_config->type = punch_data->type;
+    thread_config->access_token = NULL;
+    if (g_token_holder.running) {
+        thread_config->token_holder = &g_token_holder;
+    }
+}
+
+/**
+ * Make a token available to a thread-local config: wait for the shared
+ * token, or fetch a private one if the shared refresher is not running
+ */
+static int obtain_token(Config *thread_config) {
+    if (thread_config->token_holder != NULL) {
+        return token_holder_wait(thread_config->token_holder, TOKEN_WAIT_MS);
+    }
+    return get_token(thread_config);
+}
+
+/**
+ * Resolve the configured username to an empNumber via the local directory.
+ * Falls back to the username itself when the employee is not indexed.
+ */
+static void resolve_emp_number(const char *username, char *emp_number, size_t size) {
+    EmployeeRecord record;
+    if (g_directory_ready && employee_directory_find_by_name(&g_directory, username, &record) == 0) {
+        snprintf(emp_number, size, "%d", (int)record.emp_number);
+    } else {
+        snprintf(emp_number, size, "%s", username);
+    }
+}
+
+/**
+ * Thread function to refresh the local employee directory
+ */
+static void* sync_directory_thread(void *data) {
+    PunchThreadData *sync_data = (PunchThreadData *)data;
+    Config thread_config;
+
+    trace_set_thread_name("directory_sync");
+    TRACE_BEGIN("directory_sync");
+    thread_config_from(&thread_config, sync_data);
+    thread_config.priority = REQUEST_PRIORITY_BULK;  /* Punches go first */
+
+    if (obtain_token(&thread_config) != 0) {
+        write_log("Employee directory sync: failed to obtain access token");
+    } else {
+        int received = employee_directory_sync(&g_directory, &thread_config);
+        if (received < 0) {
+            write_log("Employee directory sync failed");
+        } else {
+            printf("Employee directory synced (%d changes, %zu employees)\n",
+                   received, employee_directory_count(&g_directory));
+        }
+    }
+
+    TRACE_END("directory_sync");
+    mem_free(thread_config.access_token);
+    free(sync_data);
+    return NULL;
+}
+
+/**
+ * Thread function to open the server connection before the first punch
+ */
+static void* warmup_thread(void *data) {
+    PunchThreadData *warmup_data = (PunchThreadData *)data;
+    Config thread_config;
+
+    thread_config_from(&thread_config, warmup_data);
+    if (orangehrm_warmup(&thread_config) != 0) {
+        write_log("Connection warm-up failed");
+    }
+
+    free(warmup_data);
+    return NULL;
+}
+
+/**
+ * Warm up DNS, TCP and TLS in the background (the token holder fetches
+ * the first token at the same time)
+ */
+static void start_warmup(void) {
+    PunchThreadData *warmup_data = (PunchThreadData *)calloc(1, sizeof(PunchThreadData));
+    if (warmup_data == NULL) {
+        return;
+    }
+    copy_credentials(warmup_data);
+
+    if (start_worker(warmup_thread, warmup_data) != 0) {
+        fprintf(stderr, "Error creating warm-up thread\n");
+        free(warmup_data);
+    }
+}
+
+/**
+ * Start a background directory sync (full on first run, incremental afterwards)
+ */
+static gboolean start_directory_sync(gpointer data) {
+    (void)data;  /* Unused */
+
+    PunchThreadData *sync_data = (PunchThreadData *)calloc(1, sizeof(PunchThreadData));
+    if (sync_data == NULL) {
+        return TRUE;
+    }
+    copy_credentials(sync_data);
+
+    if (start_worker(sync_directory_thread, sync_data) != 0) {
+        fprintf(stderr, "Error creating directory sync thread\n");
+        free(sync_data);
+    }
+    return TRUE;  /* Keep syncing periodically */
+}
+
+/**
+ * Keep a local copy of an accepted record for dashboard and audit queries
+ */
+static void store_submitted(const char *emp_number, time_t punch_in, time_t punch_out) {
+    AttendanceRecord record;
+    StoredAttendance stored;
+
+    if (!g_store_ready) {
+        return;
+    }
+
+    /* An unresolved username can be longer than a record's empNumber; never store it cut */
+    size_t length = strlen(emp_number);
+    if (length >= sizeof(record.emp_number)) {
+        write_log("Employee number too long for the local store, record not kept");
+        return;
+    }
+
+    memset(&record, 0, sizeof(record));
+    memcpy(record.emp_number, emp_number, length + 1);
+    record.punch_in = punch_in;
+    record.punch_out = punch_out;
+    if (stored_attendance_from_record(&record, STORE_SOURCE_SUBMITTED, &stored) != 0 ||
+        attendance_store_append(&g_store, &stored, 1) != 0 ||
+        attendance_store_sync(&g_store) != 0) {
+        write_log("Failed to add attendance record to the local store");
+    }
+}
+
 /**
  * Thread function to submit attendance record
  */
@@ -248,9 +520,11 @@ static void* submit_attendance_thread(void *data) {
     int success = 1;
     Config thread_config;
     ResponseBuffer resp;
-    struct json_object *json_obj = NULL;
-    struct json_object *parsed_response = NULL;
-    
+    OhrmAttendanceRecordCreate body;
+    char json_string[OHRM_BODY_SIZE];
+
+    memset(&thread_config, 0, sizeof(thread_config));
+
     /* Initialize response buffer */
     if (response_buffer_init(&resp, MAX_RESPONSE_SIZE) != 0) {
         show_error_async("Failed to allocate memory for response");
@@ -258,6 +532,10 @@ static void* submit_attendance_thread(void *data) {
         return NULL;
     }
     
+    trace_set_thread_name("submit_attendance");
+    TRACE_BEGIN("submit_attendance");
+    TRACE_BEGIN("build_body");
+
     /* Format times */
     char formatted_start_day[32], formatted_start_time[32], start_time_zone[16];
     char formatted_end_day[32], formatted_end_time[32], end_time_zone[16];
@@ -273,57 +551,56 @@ static void* submit_attendance_thread(void *data) {
                 end_time_zone, sizeof(end_time_zone));
 
     /* Build JSON request */
-    json_obj = json_object_new_object();
-    if (json_obj == NULL) {
-        show_error_async("Failed to create JSON object");
+    char emp_number[256];
+    resolve_emp_number(punch_data->username, emp_number, sizeof(emp_number));
+    body.emp_number = emp_number;
+    body.punch_in_date = formatted_start_day;
+    body.punch_in_time = formatted_start_time;
+    body.punch_in_timezone_offset = start_time_zone;
+    body.punch_in_note = "App In";
+    body.punch_out_date = formatted_end_day;
+    body.punch_out_time = formatted_end_time;
+    body.punch_out_timezone_offset = end_time_zone;
+    body.punch_out_note = "App out";
+    if (ohrm_attendance_record_create_to_json(&body, json_string, sizeof(json_string)) < 0) {
+        show_error_async("Attendance record is too large");
+        TRACE_END("build_body");
         success = 0;
         goto cleanup;
     }
-    
-    json_object_object_add(json_obj, "empNumber", json_object_new_string(punch_data->username));
-    json_object_object_add(json_obj, "punchInDate", json_object_new_string(formatted_start_day));
-    json_object_object_add(json_obj, "punchInTime", json_object_new_string(formatted_start_time));
-    json_object_object_add(json_obj, "punchInTimezoneOffset", json_object_new_string(start_time_zone));
-    json_object_object_add(json_obj, "punchInNote", json_object_new_string("App In"));
-    json_object_object_add(json_obj, "punchOutDate", json_object_new_string(formatted_end_day));
-    json_object_object_add(json_obj, "punchOutTime", json_object_new_string(formatted_end_time));
-    json_object_object_add(json_obj, "punchOutTimezoneOffset", json_object_new_string(end_time_zone));
-    json_object_object_add(json_obj, "punchOutNote", json_object_new_string("App out"));
-
-    const char *json_string = json_object_to_json_string_ext(json_obj, JSON_C_TO_STRING_PRETTY);
+    TRACE_END("build_body");
     printf("Sending attendance record:\n%s\n", json_string);
     
     /* Set up thread-local config */
-    memset(&thread_config, 0, sizeof(Config));
-    thread_config.base_url = punch_data->base_url;
-    thread_config.username = punch_data->username;
-    thread_config.password = punch_data->password;
-    thread_config.client_id = punch_data->client_id;
-    thread_config.client_secret = punch_data->client_secret;
-    thread_config.type = punch_data->type;
-    thread_config.access_token = NULL;
+    thread_config_from(&thread_config, punch_data);
     
     /* Get access token */
-    if (get_token(&thread_config) != 0) {
+    if (obtain_token(&thread_config) != 0) {
         write_log("Failed to obtain access token");
         write_log(json_string);
-        show_error_async("Failed to obtain access token. Check your credentials.");
+        show_error_async(circuit_breaker_state(TOKEN_URL) == CIRCUIT_OPEN
+                         ? "Server unavailable. Please try again shortly."
+                         : "Failed to obtain access token. Check your credentials.");
         success = 0;
         goto cleanup;
     }
 
     /* Submit attendance record */
-    if (post_request("/api/attendanceRecords", json_string, &thread_config, &resp) != 0) {
+    if (post_request(ATTENDANCE_RECORDS_URL, json_string, &thread_config, &resp) != 0) {
         write_log("POST request failed");
         write_log(json_string);
-        show_error_async("Failed to submit attendance record. Network error.");
+        show_error_async(circuit_breaker_state(ATTENDANCE_RECORDS_URL) == CIRCUIT_OPEN
+                         ? "Server unavailable. Please try again shortly."
+                         : "Failed to submit attendance record. Network error.");
         success = 0;
         goto cleanup;
     }
 
-    /* Parse response */
-    parsed_response = json_tokener_parse(resp.buffer);
-    if (parsed_response == NULL) {
+    /* Check success field in response */
+    TRACE_BEGIN("parse_response");
+    int status = attendance_response_status(resp.buffer, resp.size);
+    TRACE_END("parse_response");
+    if (status == ATTENDANCE_INVALID_RESPONSE) {
         write_log("Error parsing JSON response");
         write_log(resp.buffer);
         show_error_async("Invalid response from server");
@@ -331,35 +608,25 @@ static void* submit_attendance_thread(void *data) {
         goto cleanup;
     }
 
-    /* Check success field in response */
-    struct json_object *success_obj;
-    if (json_object_object_get_ex(parsed_response, "success", &success_obj)) {
-        const char *success_str = json_object_get_string(success_obj);
-        if (success_str != NULL && strcmp(success_str, "false") == 0) {
-            write_log("Server returned success=false");
-            write_log(resp.buffer);
-            show_error_async("Server rejected the attendance record");
-            success = 0;
-        }
+    if (status == ATTENDANCE_REJECTED) {
+        write_log("Server returned success=false");
+        write_log(resp.buffer);
+        show_error_async("Server rejected the attendance record");
+        success = 0;
     }
     
     if (success) {
+        store_submitted(emp_number, punch_data->start_time, punch_data->stop_time);
         show_success_async("Attendance record submitted successfully!");
     }
 
 cleanup:
-    if (json_obj != NULL) {
-        json_object_put(json_obj);
-    }
-    if (parsed_response != NULL) {
-        json_object_put(parsed_response);
-    }
-    
     /* Free token if allocated */
-    free(thread_config.access_token);
+    mem_free(thread_config.access_token);
     
     response_buffer_free(&resp);
     free(punch_data);
+    TRACE_END("submit_attendance");
     
     return NULL;
 }
@@ -370,6 +637,7 @@ cleanup:
 static gboolean update_time_label(gpointer data) {
     (void)data;  /* Unused */
     
+    TRACE_BEGIN("ui_update_time");
     time_t current_time;
     time(&current_time);
     
@@ -378,6 +646,7 @@ static gboolean update_time_label(gpointer data) {
     char formatted_time[32];
     format_elapsed_time(elapsed_time, formatted_time, sizeof(formatted_time));
     gtk_label_set_text(GTK_LABEL(g_time_label), formatted_time);
+    TRACE_END("ui_update_time");
     
     return TRUE;  /* Continue timer */
 }
@@ -401,6 +670,8 @@ static void on_start_button_clicked(GtkWidget *widget, gpointer data) {
 static void on_stop_button_clicked(GtkWidget *widget, gpointer data) {
     GtkWidget *start_button = GTK_WIDGET(data);
     
+    TRACE_BEGIN("ui_stop_clicked");
+
     /* Stop the timer */
     if (g_timer_id != 0) {
         g_source_remove(g_timer_id);
@@ -423,44 +694,22 @@ static void on_stop_button_clicked(GtkWidget *widget, gpointer data) {
     PunchThreadData *punch_data = (PunchThreadData *)calloc(1, sizeof(PunchThreadData));
     if (punch_data == NULL) {
         show_error_async("Memory allocation failed");
+        TRACE_END("ui_stop_clicked");
         return;
     }
     
     punch_data->start_time = g_start_time;
     punch_data->stop_time = g_stop_time;
     
-    /* Copy config values under mutex protection */
-    pthread_mutex_lock(&g_config_mutex);
-    if (g_config.username != NULL) {
-        strncpy(punch_data->username, g_config.username, sizeof(punch_data->username) - 1);
-    }
-    if (g_config.base_url != NULL) {
-        strncpy(punch_data->base_url, g_config.base_url, sizeof(punch_data->base_url) - 1);
-    }
-    if (g_config.client_id != NULL) {
-        strncpy(punch_data->client_id, g_config.client_id, sizeof(punch_data->client_id) - 1);
-    }
-    if (g_config.client_secret != NULL) {
-        strncpy(punch_data->client_secret, g_config.client_secret, sizeof(punch_data->client_secret) - 1);
-    }
-    if (g_config.password != NULL) {
-        strncpy(punch_data->password, g_config.password, sizeof(punch_data->password) - 1);
-    }
-    if (g_config.type != NULL) {
-        strncpy(punch_data->type, g_config.type, sizeof(punch_data->type) - 1);
-    }
-    pthread_mutex_unlock(&g_config_mutex);
+    copy_credentials(punch_data);
 
     /* Submit in background thread */
-    pthread_t thread;
-    int ret = pthread_create(&thread, NULL, submit_attendance_thread, punch_data);
-    if (ret != 0) {
-        fprintf(stderr, "Error creating thread: %d\n", ret);
+    if (start_worker(submit_attendance_thread, punch_data) != 0) {
+        fprintf(stderr, "Error creating attendance submit thread\n");
         show_error_async("Failed to create background thread");
         free(punch_data);
-        return;
     }
-    pthread_detach(thread);
+    TRACE_END("ui_stop_clicked");
 }
 
 /**
@@ -544,6 +793,8 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "Failed to initialize OrangeHRM client\n");
         return -1;
     }
+
+    trace_set_thread_name("gtk_main");
     
     /* Load configuration */
     pthread_mutex_lock(&g_config_mutex);
@@ -555,20 +806,63 @@ int main(int argc, char *argv[]) {
         orangehrm_client_cleanup();
         return -1;
     }
+    if (orangehrm_set_default_transport_options(&g_config.transport_options) != 0) {
+        fprintf(stderr, "Keeping the default transport options\n");
+    }
+    if (g_config.memory_budget_kb > 0) {
+        mem_budget_set((size_t)g_config.memory_budget_kb * 1024, MEM_DEFAULT_BUDGET_WAIT_MS);
+    }
+    request_lanes_configure(&g_config.lanes);
+
+    /* Reuse the token and TLS sessions of the last run, if "token_cache" is set */
+    token_cache_open(&g_config);
+
+    /* One background refresher keeps a token ready for every request thread */
+    pthread_mutex_lock(&g_config_mutex);
+    if (token_holder_start(&g_token_holder, &g_config) != 0) {
+        fprintf(stderr, "Shared token refresher unavailable, fetching tokens per request\n");
+    }
+    pthread_mutex_unlock(&g_config_mutex);
+
+    if (g_config.warmup) {
+        start_warmup();
+    }
+
+    /* Open the local employee directory and keep it in sync */
+    g_directory_ready = employee_directory_open(&g_directory, NULL) == 0;
+    if (!g_directory_ready) {
+        fprintf(stderr, "Employee directory unavailable, punches use the configured username\n");
+    }
+
+    /* Accepted punches are kept in the local attendance store */
+    g_store_ready = attendance_store_open(&g_store, NULL) == 0;
 
     /* Create and show window */
     create_overlay_window();
+    if (g_directory_ready) {
+        start_directory_sync(NULL);
+        g_timeout_add_seconds(DIRECTORY_SYNC_INTERVAL_S, start_directory_sync, NULL);
+    }
     
     /* Run GTK main loop */
     gtk_main();
     
-    /* Cleanup */
+    /* Cleanup: punches, syncs and warm-up use everything below, so they finish first */
+    wait_for_workers();
+    token_holder_stop(&g_token_holder);
+    if (g_directory_ready) {
+        employee_directory_close(&g_directory);
+    }
+    if (g_store_ready) {
+        attendance_store_close(&g_store);
+    }
+    token_cache_close();
+    orangehrm_client_cleanup();
+
     pthread_mutex_lock(&g_config_mutex);
     config_free(&g_config);
     pthread_mutex_unlock(&g_config_mutex);
-    
     pthread_mutex_destroy(&g_config_mutex);
-    orangehrm_client_cleanup();
 
     return 0;
 }
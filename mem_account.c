@@ -0,0 +1,220 @@
+#include "mem_account.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Prefix of every tracked block (keeps the payload max-aligned)
+ */
+typedef union {
+    struct {
+        size_t size;
+        int subsystem;
+    } info;
+    max_align_t align;
+} MemHeader;
+
+typedef struct {
+    atomic_size_t live_bytes;
+    atomic_size_t peak_bytes;
+    atomic_ullong allocations;
+    atomic_ullong frees;
+} MemCounters;
+
+static const char *MEM_SUBSYSTEM_NAMES[MEM_SUBSYSTEM_COUNT] = {
+    "curl", "response", "request", "config", "directory"
+};
+
+static MemCounters g_counters[MEM_SUBSYSTEM_COUNT];
+static atomic_size_t g_live_bytes = 0;
+static atomic_size_t g_peak_bytes = 0;
+
+/* Budget: waiters sleep on g_budget_cond until frees bring live bytes down */
+static atomic_size_t g_budget_bytes = 0;
+static long g_budget_wait_ms = MEM_DEFAULT_BUDGET_WAIT_MS;
+static atomic_int g_budget_waiters = 0;
+static pthread_mutex_t g_budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_budget_cond = PTHREAD_COND_INITIALIZER;
+
+static void raise_peak(atomic_size_t *peak, size_t value) {
+    size_t current = atomic_load(peak);
+    while (value > current && !atomic_compare_exchange_weak(peak, &current, value)) {
+    }
+}
+
+static void account_grow(int subsystem, size_t bytes) {
+    MemCounters *counters = &g_counters[subsystem];
+    raise_peak(&counters->peak_bytes, atomic_fetch_add(&counters->live_bytes, bytes) + bytes);
+    raise_peak(&g_peak_bytes, atomic_fetch_add(&g_live_bytes, bytes) + bytes);
+}
+
+static void account_shrink(int subsystem, size_t bytes) {
+    atomic_fetch_sub(&g_counters[subsystem].live_bytes, bytes);
+    atomic_fetch_sub(&g_live_bytes, bytes);
+
+    /* Only take the lock when a request is waiting for memory */
+    if (atomic_load(&g_budget_waiters) > 0) {
+        pthread_mutex_lock(&g_budget_mutex);
+        pthread_cond_broadcast(&g_budget_cond);
+        pthread_mutex_unlock(&g_budget_mutex);
+    }
+}
+
+void *mem_alloc(MemSubsystem subsystem, size_t size) {
+    if ((unsigned)subsystem >= MEM_SUBSYSTEM_COUNT || size > SIZE_MAX - sizeof(MemHeader)) {
+        return NULL;
+    }
+
+    MemHeader *header = (MemHeader *)malloc(sizeof(MemHeader) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->info.size = size;
+    header->info.subsystem = (int)subsystem;
+    atomic_fetch_add(&g_counters[subsystem].allocations, 1);
+    account_grow(subsystem, size);
+    return header + 1;
+}
+
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = mem_alloc(subsystem, count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return mem_alloc(subsystem, size);
+    }
+    if (size > SIZE_MAX - sizeof(MemHeader)) {
+        return NULL;
+    }
+
+    /* The block stays with the subsystem that allocated it */
+    MemHeader *header = (MemHeader *)ptr - 1;
+    size_t old_size = header->info.size;
+    int owner = header->info.subsystem;
+    MemHeader *grown = (MemHeader *)realloc(header, sizeof(MemHeader) + size);
+    if (grown == NULL) {
+        return NULL;
+    }
+    grown->info.size = size;
+    if (size > old_size) {
+        account_grow(owner, size - old_size);
+    } else if (size < old_size) {
+        account_shrink(owner, old_size - size);
+    }
+    return grown + 1;
+}
+
+char *mem_strdup(MemSubsystem subsystem, const char *text) {
+    size_t length = strlen(text) + 1;
+    char *copy = (char *)mem_alloc(subsystem, length);
+    if (copy != NULL) {
+        memcpy(copy, text, length);
+    }
+    return copy;
+}
+
+void mem_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    MemHeader *header = (MemHeader *)ptr - 1;
+    int owner = header->info.subsystem;
+    atomic_fetch_add(&g_counters[owner].frees, 1);
+    account_shrink(owner, header->info.size);
+    free(header);
+}
+
+void mem_stats(MemSubsystem subsystem, MemStats *stats) {
+    memset(stats, 0, sizeof(MemStats));
+    if ((unsigned)subsystem >= MEM_SUBSYSTEM_COUNT) {
+        return;
+    }
+    stats->live_bytes = atomic_load(&g_counters[subsystem].live_bytes);
+    stats->peak_bytes = atomic_load(&g_counters[subsystem].peak_bytes);
+    stats->allocations = atomic_load(&g_counters[subsystem].allocations);
+    stats->frees = atomic_load(&g_counters[subsystem].frees);
+}
+
+size_t mem_live_bytes(void) {
+    return atomic_load(&g_live_bytes);
+}
+
+size_t mem_peak_bytes(void) {
+    return atomic_load(&g_peak_bytes);
+}
+
+void mem_budget_set(size_t budget_bytes, long wait_ms) {
+    pthread_mutex_lock(&g_budget_mutex);
+    g_budget_wait_ms = wait_ms > 0 ? wait_ms : 0;
+    atomic_store(&g_budget_bytes, budget_bytes);
+    pthread_cond_broadcast(&g_budget_cond);
+    pthread_mutex_unlock(&g_budget_mutex);
+}
+
+int mem_budget_admit(size_t bytes) {
+    size_t budget = atomic_load(&g_budget_bytes);
+    struct timespec deadline;
+    int result = 0;
+
+    if (budget == 0 || atomic_load(&g_live_bytes) + bytes <= budget) {
+        return 0;  /* Fast path: no budget or room left */
+    }
+    if (bytes > budget) {
+        fprintf(stderr, "Allocation of %zu bytes exceeds the memory budget of %zu bytes\n", bytes, budget);
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_budget_mutex);
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += g_budget_wait_ms / 1000;
+    deadline.tv_nsec += (g_budget_wait_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    /* Announce the waiter before re-checking, so a concurrent free wakes it */
+    atomic_fetch_add(&g_budget_waiters, 1);
+    for (;;) {
+        budget = atomic_load(&g_budget_bytes);
+        if (budget == 0 || atomic_load(&g_live_bytes) + bytes <= budget) {
+            break;
+        }
+        if (pthread_cond_timedwait(&g_budget_cond, &g_budget_mutex, &deadline) == ETIMEDOUT) {
+            result = -1;
+            break;
+        }
+    }
+    atomic_fetch_sub(&g_budget_waiters, 1);
+    pthread_mutex_unlock(&g_budget_mutex);
+
+    if (result != 0) {
+        fprintf(stderr, "Memory budget of %zu bytes exhausted (%zu live), request refused\n",
+                budget, mem_live_bytes());
+    }
+    return result;
+}
+
+void mem_report(FILE *out) {
+    fprintf(out, "%-12s %12s %12s %12s %12s\n", "memory", "live", "peak", "allocs", "frees");
+    for (int i = 0; i < MEM_SUBSYSTEM_COUNT; i++) {
+        MemStats stats;
+        mem_stats((MemSubsystem)i, &stats);
+        fprintf(out, "%-12s %12zu %12zu %12llu %12llu\n", MEM_SUBSYSTEM_NAMES[i], stats.live_bytes,
+                stats.peak_bytes, stats.allocations, stats.frees);
+    }
+    fprintf(out, "%-12s %12zu %12zu\n", "total", mem_live_bytes(), mem_peak_bytes());
+}
@@ -0,0 +1,80 @@
+#ifndef MEM_ACCOUNT_H
+#define MEM_ACCOUNT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define MEM_DEFAULT_BUDGET_WAIT_MS 5000
+
+/**
+ * Owner of a tracked allocation
+ */
+typedef enum {
+    MEM_CURL = 0,       /* libcurl handles, connection caches and header lists */
+    MEM_RESPONSE,       /* response buffers */
+    MEM_REQUEST,        /* copies held by queued async and tenant requests */
+    MEM_CONFIG,         /* duplicated config strings and access tokens */
+    MEM_DIRECTORY,      /* employee sync merge lists and index images */
+    MEM_SUBSYSTEM_COUNT
+} MemSubsystem;
+
+/**
+ * Counters of one subsystem
+ */
+typedef struct {
+    size_t live_bytes;
+    size_t peak_bytes;
+    unsigned long long allocations;
+    unsigned long long frees;
+} MemStats;
+
+/**
+ * Tracked allocation functions. Memory from these must be released with
+ * mem_free() (never free()), and memory from malloc() never with mem_free().
+ * They never wait for the budget; admission happens in mem_budget_admit().
+ */
+void *mem_alloc(MemSubsystem subsystem, size_t size);
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size);
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t size);
+char *mem_strdup(MemSubsystem subsystem, const char *text);
+void mem_free(void *ptr);
+
+/**
+ * Snapshot of one subsystem's counters
+ */
+void mem_stats(MemSubsystem subsystem, MemStats *stats);
+
+/**
+ * Live bytes over all subsystems
+ */
+size_t mem_live_bytes(void);
+
+/**
+ * Peak of mem_live_bytes() so far
+ */
+size_t mem_peak_bytes(void);
+
+/**
+ * Set a soft cap on live tracked bytes. New requests wait for memory to be
+ * released while the cap is exceeded, and fail after wait_ms.
+ * @param budget_bytes Cap, 0 to remove it
+ * @param wait_ms How long a request may wait for memory
+ */
+void mem_budget_set(size_t budget_bytes, long wait_ms);
+
+/**
+ * Wait until bytes more fit into the budget (returns at once without one).
+ * Entry points that queue copies of their input (async and tenant requests,
+ * batched records) call it before copying, so the queued copies count
+ * against the budget and a flood of callers waits here instead of growing
+ * the queues.
+ * @return 0 when admitted, -1 if the budget stayed exhausted or bytes exceeds it
+ */
+int mem_budget_admit(size_t bytes);
+
+/**
+ * Print live, peak and allocation counts per subsystem
+ */
+void mem_report(FILE *out);
+
+#endif /* MEM_ACCOUNT_H */
@@ -1,29 +1,79 @@
 #include "orangehrm_client.h"
+#include "circuit_breaker.h"
+#include "token_holder.h"
+#include "token_cache.h"
+#include "trace.h"
+#include "json_scan.h"
 #include <curl/curl.h>
 #include <json-c/json.h>
+#include <errno.h>
+#include <pthread.h>
 
-#define TOKEN_URL "/oauth/issueToken"
-#define API_URL "/api/v1/"
+#define HTTP_UNAUTHORIZED 401
+#define HTTP_SERVER_ERROR 500
 
-/* Global initialization flag */
+/* Number of orangehrm_client_init calls not yet matched by a cleanup */
 static int g_initialized = 0;
+static pthread_mutex_t g_init_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Transport used by configs without their own (owned if created by init) */
+static Transport *g_default_transport = NULL;
+static int g_owns_default_transport = 0;
+
+/* libcurl allocations are tracked under MEM_CURL */
+static void *curl_malloc_hook(size_t size) {
+    return mem_alloc(MEM_CURL, size);
+}
+
+static void curl_free_hook(void *ptr) {
+    mem_free(ptr);
+}
+
+static void *curl_realloc_hook(void *ptr, size_t size) {
+    return mem_realloc(MEM_CURL, ptr, size);
+}
+
+static char *curl_strdup_hook(const char *text) {
+    return mem_strdup(MEM_CURL, text);
+}
+
+static void *curl_calloc_hook(size_t count, size_t size) {
+    return mem_calloc(MEM_CURL, count, size);
+}
 
 /**
  * Initialize the OrangeHRM client
  * Must be called once at program startup before any API calls
  */
 int orangehrm_client_init(void) {
-    if (g_initialized) {
-        return 0;  /* Already initialized */
+    pthread_mutex_lock(&g_init_mutex);
+    if (g_initialized > 0) {
+        g_initialized++;  /* Already initialized */
+        pthread_mutex_unlock(&g_init_mutex);
+        return 0;
     }
     
-    CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
+    CURLcode res = curl_global_init_mem(CURL_GLOBAL_DEFAULT, curl_malloc_hook, curl_free_hook,
+                                        curl_realloc_hook, curl_strdup_hook, curl_calloc_hook);
     if (res != CURLE_OK) {
-        fprintf(stderr, "curl_global_init failed: %s\n", curl_easy_strerror(res));
+        fprintf(stderr, "curl_global_init_mem failed: %s\n", curl_easy_strerror(res));
+        pthread_mutex_unlock(&g_init_mutex);
         return -1;
     }
     
+    if (g_default_transport == NULL) {
+        g_default_transport = curl_transport_create();
+        if (g_default_transport == NULL) {
+            curl_global_cleanup();
+            pthread_mutex_unlock(&g_init_mutex);
+            return -1;
+        }
+        g_owns_default_transport = 1;
+    }
+    
+    trace_start_from_env();
     g_initialized = 1;
+    pthread_mutex_unlock(&g_init_mutex);
     return 0;
 }
 
@@ -32,21 +82,148 @@ int orangehrm_client_init(void) {
  * Must be called once at program shutdown
  */
 void orangehrm_client_cleanup(void) {
-    if (g_initialized) {
+    pthread_mutex_lock(&g_init_mutex);
+    if (g_initialized > 0 && --g_initialized == 0) {
+        executor_default_shutdown();  /* Finish queued async requests first */
+        trace_stop();
+        if (g_owns_default_transport) {
+            transport_destroy(g_default_transport);
+            g_default_transport = NULL;
+            g_owns_default_transport = 0;
+        }
         curl_global_cleanup();
-        g_initialized = 0;
     }
+    pthread_mutex_unlock(&g_init_mutex);
+}
+
+/**
+ * Replace the default transport (the caller keeps ownership)
+ */
+void orangehrm_set_default_transport(Transport *transport) {
+    if (g_owns_default_transport) {
+        transport_destroy(g_default_transport);
+        g_owns_default_transport = 0;
+    }
+    g_default_transport = transport;
+}
+
+Transport *orangehrm_default_transport(void) {
+    return g_default_transport;
+}
+
+int orangehrm_set_default_transport_options(const TransportOptions *options) {
+    Transport *transport = curl_transport_create_with_options(options);
+    if (transport == NULL) {
+        return -1;
+    }
+    orangehrm_set_default_transport(transport);
+    g_owns_default_transport = 1;
+    return 0;
 }
 
 /**
- * Initialize a response buffer with given capacity
+ * Send a request through the config's transport, guarded by the circuit breaker
+ */
+int client_transport_perform(Config *config, const TransportRequest *request, TransportResponse *response) {
+    Transport *transport = config->transport != NULL ? config->transport : g_default_transport;
+    char breaker_key[CIRCUIT_ENDPOINT_SIZE];
+    const char *endpoint = request->path;
+
+    response->status = 0;
+
+    if (transport == NULL) {
+        fprintf(stderr, "No transport available. Call orangehrm_client_init first.\n");
+        return -1;
+    }
+
+    /* One tenant's unhealthy server must not open the breaker for the others */
+    if (config->tenant != NULL) {
+        snprintf(breaker_key, sizeof(breaker_key), "%s:%s", config->tenant, request->path);
+        endpoint = breaker_key;
+    }
+
+    /* Fail fast while this endpoint is known to be unhealthy */
+    if (!circuit_breaker_allow(endpoint)) {
+        fprintf(stderr, "Circuit open for %s, failing fast\n", endpoint);
+        return -1;
+    }
+
+    /* Wait for a slot in the config's lane, so bulk work cannot hold up a user's punch */
+    TRACE_BEGIN("lane_wait");
+    request_lanes_acquire(config->priority);
+    TRACE_END("lane_wait");
+
+    TRACE_BEGIN("transfer");
+    int result = transport->perform(transport, request, response);
+    TRACE_END("transfer");
+    request_lanes_release(config->priority);
+
+    /* Client errors (4xx) still mean the server is up; transport errors and 5xx do not */
+    circuit_breaker_record(endpoint, response->status > 0 && response->status < HTTP_SERVER_ERROR);
+
+    /* Token revoked or expired early: stop reusing a persisted one and have the refresher fetch a new one */
+    if (response->status == HTTP_UNAUTHORIZED) {
+        token_cache_reject();
+        if (config->token_holder != NULL) {
+            token_holder_invalidate(config->token_holder);
+        }
+    }
+    return result;
+}
+
+/**
+ * Pre-open the connection to base_url
+ */
+int orangehrm_warmup(Config *config) {
+    if (config == NULL || config->base_url == NULL) {
+        fprintf(stderr, "Invalid parameters for orangehrm_warmup\n");
+        return -1;
+    }
+
+    Transport *transport = config->transport != NULL ? config->transport : g_default_transport;
+    if (transport == NULL) {
+        fprintf(stderr, "No transport available. Call orangehrm_client_init first.\n");
+        return -1;
+    }
+    return transport_warmup(transport, config->base_url);
+}
+
+/**
+ * Build the Authorization header from the shared token or the config's own token
+ */
+int client_auth_header(Config *config, char *header, size_t size) {
+    if (config->token_holder != NULL) {
+        SharedToken *token = token_holder_acquire(config->token_holder);
+        if (token == NULL) {
+            fprintf(stderr, "No shared access token available yet\n");
+            return -1;
+        }
+        snprintf(header, size, "Authorization: Bearer %s", token->value);
+        shared_token_release(token);
+        return 0;
+    }
+
+    if (config->access_token == NULL) {
+        fprintf(stderr, "No access token available. Call get_token first.\n");
+        return -1;
+    }
+    snprintf(header, size, "Authorization: Bearer %s", config->access_token);
+    return 0;
+}
+
+/**
+ * Initialize a response buffer with given capacity (waits for room under a memory budget)
  */
 int response_buffer_init(ResponseBuffer *resp, size_t capacity) {
     if (resp == NULL || capacity == 0) {
         return -1;
     }
     
-    resp->buffer = (char *)calloc(capacity, sizeof(char));
+    resp->buffer = NULL;
+    if (mem_budget_admit(capacity) != 0) {
+        return -1;
+    }
+    resp->buffer = (char *)mem_calloc(MEM_RESPONSE, capacity, sizeof(char));
     if (resp->buffer == NULL) {
         fprintf(stderr, "Failed to allocate response buffer\n");
         return -1;
@@ -62,7 +239,7 @@ int response_buffer_init(ResponseBuffer *resp, size_t capacity) {
  */
 void response_buffer_free(ResponseBuffer *resp) {
     if (resp != NULL) {
-        free(resp->buffer);
+        mem_free(resp->buffer);
         resp->buffer = NULL;
         resp->size = 0;
         resp->capacity = 0;
@@ -103,14 +280,16 @@ void config_free(Config *config) {
         return;
     }
     
-    free(config->base_url);
-    free(config->username);
-    free(config->password);
-    free(config->client_id);
-    free(config->client_secret);
-    free(config->access_token);
-    free(config->refresh_token);
-    free(config->type);
+    mem_free(config->base_url);
+    mem_free(config->username);
+    mem_free(config->password);
+    mem_free(config->client_id);
+    mem_free(config->client_secret);
+    mem_free(config->access_token);
+    mem_free(config->refresh_token);
+    mem_free(config->type);
+    mem_free(config->tenant);
+    mem_free(config->token_cache);
     
     /* Zero out for safety */
     memset(config, 0, sizeof(Config));
@@ -138,7 +317,7 @@ static char* json_get_string_dup(struct json_object *json, const char *key, int
         return NULL;
     }
     
-    char *dup = strdup(value);
+    char *dup = mem_strdup(MEM_CONFIG, value);
     if (dup == NULL) {
         fprintf(stderr, "Memory allocation failed for field '%s'\n", key);
     }
@@ -146,10 +325,31 @@ static char* json_get_string_dup(struct json_object *json, const char *key, int
     return dup;
 }
 
+/**
+ * Read an optional integer field from JSON
+ * @return 0 if present (value updated), -1 if absent
+ */
+static int json_get_long(struct json_object *json, const char *key, long *value) {
+    struct json_object *obj = NULL;
+
+    if (!json_object_object_get_ex(json, key, &obj) || obj == NULL) {
+        return -1;
+    }
+    *value = (long)json_object_get_int64(obj);
+    return 0;
+}
+
 /**
  * Load configuration from config.json file
  */
 int load_config(Config *config) {
+    return load_config_file(config, CONFIG_FILE);
+}
+
+/**
+ * Load configuration from a config.json style file
+ */
+int load_config_file(Config *config, const char *path) {
     FILE *file = NULL;
     struct json_object *parsed_json = NULL;
     int result = -1;
@@ -162,9 +362,14 @@ int load_config(Config *config) {
     /* Initialize config to zeros */
     memset(config, 0, sizeof(Config));
     
-    file = fopen(CONFIG_FILE, "r");
+    if (path == NULL) {
+        fprintf(stderr, "Config path is NULL\n");
+        return -1;
+    }
+    
+    file = fopen(path, "r");
     if (!file) {
-        perror("Failed to open config file");
+        fprintf(stderr, "Failed to open config file %s: %s\n", path, strerror(errno));
         return -1;
     }
 
@@ -203,6 +408,53 @@ int load_config(Config *config) {
     /* Extract optional fields (username/password for password grant) */
     config->username = json_get_string_dup(parsed_json, "username", 0);
     config->password = json_get_string_dup(parsed_json, "password", 0);
+
+    /* Optional encrypted token and TLS session cache, opened with token_cache_open() */
+    config->token_cache = json_get_string_dup(parsed_json, "token_cache", 0);
+    
+    /* Optional connection warm-up at startup */
+    struct json_object *warmup_obj;
+    if (json_object_object_get_ex(parsed_json, "warmup", &warmup_obj)) {
+        config->warmup = json_object_get_boolean(warmup_obj);
+    }
+
+    /* Optional cap on client memory, applied with mem_budget_set() */
+    json_get_long(parsed_json, "memory_budget_kb", &config->memory_budget_kb);
+
+    /* Optional deadlines and socket tuning (absent keys keep the defaults) */
+    struct json_object *transport_obj;
+    if (json_object_object_get_ex(parsed_json, "transport", &transport_obj)) {
+        TransportOptions *options = &config->transport_options;
+        json_get_long(transport_obj, "connect_timeout_ms", &options->connect_timeout_ms);
+        json_get_long(transport_obj, "request_timeout_ms", &options->request_timeout_ms);
+        json_get_long(transport_obj, "low_speed_limit", &options->low_speed_limit);
+        json_get_long(transport_obj, "low_speed_time_s", &options->low_speed_time_s);
+        json_get_long(transport_obj, "keepalive_idle_s", &options->keepalive_idle_s);
+        json_get_long(transport_obj, "keepalive_interval_s", &options->keepalive_interval_s);
+        json_get_long(transport_obj, "happy_eyeballs_timeout_ms", &options->happy_eyeballs_timeout_ms);
+        struct json_object *nodelay_obj;
+        if (json_object_object_get_ex(transport_obj, "tcp_nodelay", &nodelay_obj)) {
+            options->tcp_nodelay = json_object_get_boolean(nodelay_obj) ? 1 : -1;
+        }
+        long max_host_connections = 0;
+        json_get_long(transport_obj, "max_host_connections", &max_host_connections);
+        options->max_host_connections = (int)max_host_connections;
+        long connection_pool_size = 0;
+        json_get_long(transport_obj, "connection_pool_size", &connection_pool_size);
+        options->connection_pool_size = (int)connection_pool_size;
+    }
+
+    /* Optional request lanes; by default bulk work is kept within the per-host connection limit */
+    struct json_object *lanes_obj;
+    long max_in_flight = 0;
+    long interactive_reserved = 0;
+    if (json_object_object_get_ex(parsed_json, "lanes", &lanes_obj)) {
+        json_get_long(lanes_obj, "max_in_flight", &max_in_flight);
+        json_get_long(lanes_obj, "interactive_reserved", &interactive_reserved);
+    }
+    config->lanes.max_in_flight = max_in_flight != 0 ? (int)max_in_flight
+                                                     : config->transport_options.max_host_connections;
+    config->lanes.interactive_reserved = (int)interactive_reserved;
     
     /* Validate grant type has required fields */
     if (strcmp(config->type, "password") == 0) {
@@ -235,21 +487,29 @@ cleanup:
  */
 int get_token(Config *config) {
     char post_data[MAX_HEADER_SIZE];
+    char full_url[MAX_URL_SIZE];
     ResponseBuffer resp;
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
+    TransportRequest request;
+    TransportResponse response;
     int result = -1;
     
     if (config == NULL) {
         fprintf(stderr, "Config is NULL\n");
         return -1;
     }
+
+    /* A token persisted by an earlier process is used until the server rejects it */
+    if (token_cache_claim(config) == 0) {
+        return 0;
+    }
     
     /* Initialize response buffer */
     if (response_buffer_init(&resp, MAX_RESPONSE_SIZE) != 0) {
         return -1;
     }
     
+    TRACE_BEGIN("get_token");
+
     /* Build POST data based on grant type */
     if (strcmp(config->type, "client_credentials") == 0) {
         snprintf(post_data, sizeof(post_data), 
@@ -267,78 +527,74 @@ int get_token(Config *config) {
     }
 
     /* Set up headers */
-    headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-    if (headers == NULL) {
-        fprintf(stderr, "Failed to create headers\n");
-        goto cleanup;
-    }
-
-    /* Initialize CURL */
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "Failed to initialize CURL\n");
-        goto cleanup;
-    }
+    const char *headers[] = { "Content-Type: application/x-www-form-urlencoded" };
     
     /* Build full URL */
-    char full_url[MAX_URL_SIZE];
     snprintf(full_url, sizeof(full_url), "%s%s", config->base_url, TOKEN_URL);
 
-    curl_easy_setopt(curl, CURLOPT_URL, full_url);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resp);
+    memset(&request, 0, sizeof(request));
+    request.method = "POST";
+    request.url = full_url;
+    request.path = TOKEN_URL;
+    request.headers = headers;
+    request.header_count = 1;
+    request.body = post_data;
+    request.write_fn = write_callback;
+    request.write_data = &resp;
 
     /* Perform the request */
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "Token request failed: %s\n", curl_easy_strerror(res));
+    if (client_transport_perform(config, &request, &response) != 0) {
+        fprintf(stderr, "Token request failed\n");
         goto cleanup;
     }
 
-    /* Parse response */
-    struct json_object *parsed_json = json_tokener_parse(resp.buffer);
-    if (parsed_json == NULL) {
+    /* Parse response: only two fields are needed, so scan instead of building a tree */
+    TRACE_BEGIN("parse_token");
+    JsonSlice access_token, expires_in;
+    int scan = json_scan_find(resp.buffer, resp.size, "access_token", &access_token);
+    TRACE_END("parse_token");
+    if (scan == JSON_SCAN_MALFORMED) {
         fprintf(stderr, "Error parsing token response JSON\n");
         goto cleanup;
     }
-
-    struct json_object *access_token_obj;
-    if (!json_object_object_get_ex(parsed_json, "access_token", &access_token_obj)) {
+    if (scan == JSON_SCAN_NOT_FOUND) {
         fprintf(stderr, "Error: access_token not found in response\n");
-        json_object_put(parsed_json);
         goto cleanup;
     }
-
-    /* Store access token */
-    const char *access_token = json_object_get_string(access_token_obj);
-    if (access_token == NULL) {
+    if (access_token.type != JSON_SCAN_STRING) {
         fprintf(stderr, "Error: access_token is null\n");
-        json_object_put(parsed_json);
         goto cleanup;
     }
-    
-    /* Free old token if exists */
-    free(config->access_token);
-    config->access_token = strdup(access_token);
-    
-    if (config->access_token == NULL) {
+
+    /* Store access token (unescaped text is never longer than the raw value) */
+    char *token = (char *)mem_alloc(MEM_CONFIG, access_token.length + 1);
+    if (token == NULL) {
         fprintf(stderr, "Failed to allocate memory for access token\n");
-        json_object_put(parsed_json);
         goto cleanup;
     }
+    if (json_scan_string(&access_token, token, access_token.length + 1) < 0) {
+        fprintf(stderr, "Error: access_token is not a valid JSON string\n");
+        mem_free(token);
+        goto cleanup;
+    }
+    
+    /* Free old token if exists */
+    mem_free(config->access_token);
+    config->access_token = token;
+
+    /* Remember when the token expires so a refresher can renew it in time */
+    long long expires_in_s;
+    config->token_expires_at = 0;
+    if (json_scan_find(resp.buffer, resp.size, "expires_in", &expires_in) == JSON_SCAN_FOUND &&
+        json_scan_long(&expires_in, &expires_in_s) == 0 && expires_in_s > 0) {
+        config->token_expires_at = time(NULL) + (time_t)expires_in_s;
+    }
+    token_cache_store(config);
 
-    json_object_put(parsed_json);
     result = 0;  /* Success */
 
 cleanup:
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
-    if (headers) {
-        curl_slist_free_all(headers);
-    }
+    TRACE_END("get_token");
     response_buffer_free(&resp);
     
     return result;
@@ -369,17 +625,26 @@ int delete_request(const char *url, Config *config, ResponseBuffer *resp) {
  * General function for sending API requests
  */
 int api_request(const char *url, const char *method, const char *data, Config *config, ResponseBuffer *resp) {
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    int result = -1;
+    long status;
+    return api_request_status(url, method, data, config, resp, &status);
+}
+
+int api_request_status(const char *url, const char *method, const char *data, Config *config,
+                       ResponseBuffer *resp, long *status) {
+    TransportRequest request;
+    TransportResponse response;
+    const char *headers[2];
+    size_t header_count = 0;
     
+    *status = 0;
     if (url == NULL || method == NULL || config == NULL || resp == NULL) {
         fprintf(stderr, "Invalid parameters for api_request\n");
         return -1;
     }
     
-    if (config->access_token == NULL) {
-        fprintf(stderr, "No access token available. Call get_token first.\n");
+    if (strcmp(method, "GET") != 0 && strcmp(method, "POST") != 0 && strcmp(method, "PUT") != 0 &&
+        strcmp(method, "PATCH") != 0 && strcmp(method, "DELETE") != 0) {
+        fprintf(stderr, "Unknown HTTP method: %s\n", method);
         return -1;
     }
     
@@ -390,69 +655,118 @@ int api_request(const char *url, const char *method, const char *data, Config *c
     }
     
     /* Build full URL */
+    TRACE_BEGIN("build_headers");
     char full_url[MAX_URL_SIZE];
     snprintf(full_url, sizeof(full_url), "%s%s", config->base_url, url);
 
-    curl = curl_easy_init();
-    if (!curl) {
-        fprintf(stderr, "Failed to initialize CURL\n");
-        return -1;
-    }
-
     /* Set up authorization header */
     char auth_header[MAX_HEADER_SIZE];
-    snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", config->access_token);
-    headers = curl_slist_append(headers, auth_header);
-    
-    if (headers == NULL) {
-        fprintf(stderr, "Failed to create headers\n");
-        goto cleanup;
+    if (client_auth_header(config, auth_header, sizeof(auth_header)) != 0) {
+        TRACE_END("build_headers");
+        return -1;
     }
-
-    curl_easy_setopt(curl, CURLOPT_URL, full_url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp);
+    headers[header_count++] = auth_header;
 
     /* Set request body if provided */
     if (data != NULL) {
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data);
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-    }
-
-    /* Set HTTP method */
-    if (strcmp(method, "GET") == 0) {
-        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-    } else if (strcmp(method, "POST") == 0) {
-        curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    } else if (strcmp(method, "PUT") == 0) {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-    } else if (strcmp(method, "PATCH") == 0) {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
-    } else if (strcmp(method, "DELETE") == 0) {
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-    } else {
-        fprintf(stderr, "Unknown HTTP method: %s\n", method);
-        goto cleanup;
+        headers[header_count++] = "Content-Type: application/json";
     }
-    
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    memset(&request, 0, sizeof(request));
+    request.method = method;
+    request.url = full_url;
+    request.path = url;
+    request.headers = headers;
+    request.header_count = header_count;
+    request.body = data;
+    request.write_fn = write_callback;
+    request.write_data = resp;
+    TRACE_END("build_headers");
 
     /* Perform the request */
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "%s request failed: %s\n", method, curl_easy_strerror(res));
-        goto cleanup;
+    int result = client_transport_perform(config, &request, &response);
+    *status = response.status;
+    return result;
+}
+
+/**
+ * Arguments of a queued api_request (strings copied)
+ */
+typedef struct {
+    char *url;
+    char *method;
+    char *data;
+    Config *config;
+} AsyncRequest;
+
+static void async_request_free(AsyncRequest *request) {
+    mem_free(request->url);
+    mem_free(request->method);
+    mem_free(request->data);
+    mem_free(request);
+}
+
+static void response_buffer_destroy(void *value) {
+    response_buffer_free((ResponseBuffer *)value);
+    mem_free(value);
+}
+
+static int run_api_request(void *data, void **value) {
+    AsyncRequest *request = (AsyncRequest *)data;
+    int result = -1;
+
+    ResponseBuffer *resp = (ResponseBuffer *)mem_alloc(MEM_RESPONSE, sizeof(ResponseBuffer));
+    if (resp != NULL && response_buffer_init(resp, MAX_RESPONSE_SIZE) == 0) {
+        result = api_request(request->url, request->method, request->data, request->config, resp);
+        *value = resp;  /* Error bodies are kept too */
+    } else {
+        mem_free(resp);
     }
 
-    result = 0;  /* Success */
+    async_request_free(request);
+    return result;
+}
 
-cleanup:
-    if (curl) {
-        curl_easy_cleanup(curl);
+Future *api_request_async(const char *url, const char *method, const char *data, Config *config) {
+    if (url == NULL || method == NULL || config == NULL) {
+        fprintf(stderr, "Invalid parameters for api_request_async\n");
+        return NULL;
     }
-    if (headers) {
-        curl_slist_free_all(headers);
+
+    if (mem_budget_admit(sizeof(AsyncRequest) + strlen(url) + (data != NULL ? strlen(data) : 0)) != 0) {
+        return NULL;
+    }
+    AsyncRequest *request = (AsyncRequest *)mem_calloc(MEM_REQUEST, 1, sizeof(AsyncRequest));
+    if (request == NULL) {
+        fprintf(stderr, "Memory allocation failed for async request\n");
+        return NULL;
+    }
+    request->url = mem_strdup(MEM_REQUEST, url);
+    request->method = mem_strdup(MEM_REQUEST, method);
+    request->data = data != NULL ? mem_strdup(MEM_REQUEST, data) : NULL;
+    request->config = config;
+    if (request->url == NULL || request->method == NULL || (data != NULL && request->data == NULL)) {
+        fprintf(stderr, "Memory allocation failed for async request\n");
+        async_request_free(request);
+        return NULL;
     }
 
-    return result;
+    Future *future = future_run(NULL, run_api_request, request, response_buffer_destroy);
+    if (future == NULL) {
+        async_request_free(request);
+    }
+    return future;
+}
+
+static int run_get_token(void *data, void **value) {
+    (void)value;  /* No value, the token lands in the config */
+    return get_token((Config *)data);
+}
+
+Future *get_token_async(Config *config) {
+    if (config == NULL) {
+        fprintf(stderr, "Config is NULL\n");
+        return NULL;
+    }
+    return future_run(NULL, run_get_token, config, NULL);
 }
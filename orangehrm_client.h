@@ -4,15 +4,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <curl/curl.h>
+#include "transport.h"
+#include "future.h"
+#include "mem_account.h"
+#include "request_lanes.h"
+#include "orangehrm_api_types.h"
 
 #define CONFIG_FILE "config.json"
+#define TOKEN_URL OHRM_ISSUE_TOKEN_PATH
 #define MAX_RESPONSE_SIZE (1024 * 100)  /* 100KB response buffer */
 #define MAX_URL_SIZE 512
 #define MAX_HEADER_SIZE 1024
 
+struct TokenHolder;
+
 /**
  * Configuration structure for OrangeHRM API client
+ * (config_free releases the strings with mem_free, so set them with mem_strdup(MEM_CONFIG, ...))
  */
 typedef struct {
     char *base_url;
@@ -21,8 +31,18 @@ typedef struct {
     char *client_id;
     char *client_secret;
     char *access_token;
+    time_t token_expires_at;    /* from expires_in, 0 if the server sent none */
     char *refresh_token;
     char *type;
+    Transport *transport;   /* NULL uses the client default transport */
+    struct TokenHolder *token_holder;   /* shared token used instead of access_token (not owned) */
+    int warmup;             /* "warmup": pre-open the connection at startup */
+    char *tenant;           /* scopes circuit breakers to one tenant (NULL with a single tenant) */
+    TransportOptions transport_options; /* "transport": deadlines and socket tuning for transports made for it */
+    long memory_budget_kb;  /* "memory_budget_kb": cap on tracked client memory, 0 for none */
+    RequestPriority priority;   /* lane of this config's requests, interactive unless set */
+    RequestLanesOptions lanes;  /* "lanes": process-wide lane limits for request_lanes_configure() */
+    char *token_cache;      /* "token_cache": encrypted token and TLS session cache file, NULL for none */
 } Config;
 
 /**
@@ -35,21 +55,71 @@ typedef struct {
 } ResponseBuffer;
 
 /**
- * Initialize the OrangeHRM client (call once at startup)
+ * Initialize the OrangeHRM client. Calls are counted, so independent users
+ * in one process (e.g. several client contexts) can each initialize.
  * @return 0 on success, -1 on failure
  */
 int orangehrm_client_init(void);
 
 /**
- * Cleanup the OrangeHRM client (call once at shutdown)
+ * Release one orangehrm_client_init(); the last one shuts the client down
  */
 void orangehrm_client_cleanup(void);
 
 /**
- * Initialize a response buffer
+ * Replace the transport used by configs without their own
+ * (the caller keeps ownership; NULL leaves requests without a transport)
+ * @param transport Transport to use, e.g. from loopback_transport_create()
+ */
+void orangehrm_set_default_transport(Transport *transport);
+
+/**
+ * Transport used by configs without their own
+ */
+Transport *orangehrm_default_transport(void);
+
+/**
+ * Recreate the default curl transport with other options, e.g. a loaded
+ * config's transport_options (call before requests are in flight; a
+ * transport set with orangehrm_set_default_transport is replaced too)
+ * @return 0 on success, -1 on failure (the old transport is kept)
+ */
+int orangehrm_set_default_transport_options(const TransportOptions *options);
+
+/**
+ * Send one request through the config's transport, guarded by the circuit breaker
+ * (per tenant when config->tenant is set).
+ * A 401 drops a persisted token (see token_cache.h) and asks the config's token holder for a fresh token.
+ * @param config Config selecting the transport
+ * @param request Request to send (request->path keys the circuit breaker)
+ * @param response Receives the HTTP status
+ * @return 0 if a response was received, -1 on failure or fast-fail
+ */
+int client_transport_perform(Config *config, const TransportRequest *request, TransportResponse *response);
+
+/**
+ * Resolve base_url and open a connection to it through the config's
+ * transport, so the first request does not pay DNS, TCP and TLS setup
+ * @param config Config selecting the server and transport
+ * @return 0 on success, -1 on failure
+ */
+int orangehrm_warmup(Config *config);
+
+/**
+ * Build the Authorization header from the config's token holder, or from
+ * access_token when the config has no holder
+ * @param config Config with a token holder or access token
+ * @param header Output buffer
+ * @param size Size of the output buffer
+ * @return 0 on success, -1 if no token is available
+ */
+int client_auth_header(Config *config, char *header, size_t size);
+
+/**
+ * Initialize a response buffer (waits for room while a memory budget is exhausted)
  * @param resp Pointer to ResponseBuffer structure
  * @param capacity Initial capacity in bytes
- * @return 0 on success, -1 on failure
+ * @return 0 on success, -1 on failure or if the budget stayed exhausted
  */
 int response_buffer_init(ResponseBuffer *resp, size_t capacity);
 
@@ -66,6 +136,14 @@ void response_buffer_free(ResponseBuffer *resp);
  */
 int load_config(Config *config);
 
+/**
+ * Load configuration from a JSON file with the layout of config.json
+ * @param config Pointer to Config structure to populate
+ * @param path Configuration file path
+ * @return 0 on success, -1 on failure
+ */
+int load_config_file(Config *config, const char *path);
+
 /**
  * Free all memory allocated for config
  * @param config Pointer to Config structure to free
@@ -73,14 +151,17 @@ int load_config(Config *config);
 void config_free(Config *config);
 
 /**
- * Obtain an access token using OAuth2
+ * Obtain an access token using OAuth2 (fails fast while the token endpoint circuit is open),
+ * or reuse the one in the token cache when it is open and still valid
  * @param config Pointer to Config structure (token stored here)
  * @return 0 on success, -1 on failure
  */
 int get_token(Config *config);
 
 /**
- * General API request function
+ * General API request function.
+ * Fails immediately, without network I/O, while the circuit breaker for the
+ * endpoint is open (see circuit_breaker.h).
  * @param url API endpoint (will be appended to base_url)
  * @param method HTTP method (GET, POST, PUT, PATCH, DELETE)
  * @param data Request body data (can be NULL for GET/DELETE)
@@ -90,6 +171,29 @@ int get_token(Config *config);
  */
 int api_request(const char *url, const char *method, const char *data, Config *config, ResponseBuffer *resp);
 
+/**
+ * api_request that also reports the HTTP status
+ * @param status Receives the status, 0 if no response arrived
+ */
+int api_request_status(const char *url, const char *method, const char *data, Config *config,
+                       ResponseBuffer *resp, long *status);
+
+/**
+ * Start api_request on the client executor (see future.h)
+ * @param config Must stay valid, and not be changed, until the future is done
+ * @return Future whose value is the ResponseBuffer (owned by the future),
+ *         NULL if the request could not be queued
+ */
+Future *api_request_async(const char *url, const char *method, const char *data, Config *config);
+
+/**
+ * Start get_token on the client executor; the token is stored in config
+ * @param config Must stay valid until the future is done, and not be used
+ *               by other requests meanwhile
+ * @return Future without a value, NULL if the request could not be queued
+ */
+Future *get_token_async(Config *config);
+
 /**
  * Send a POST request
  */
@@ -0,0 +1,125 @@
+#include "request_lanes.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+static const char *LANE_NAMES[REQUEST_PRIORITY_COUNT] = { "interactive", "bulk" };
+
+/* Every counter below is guarded by g_lanes_mutex */
+static pthread_mutex_t g_lanes_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_lane_cond[REQUEST_PRIORITY_COUNT] = {
+    PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER
+};
+static LaneStats g_lanes[REQUEST_PRIORITY_COUNT];
+static int g_max_in_flight = 0;     /* 0: requests are counted but never wait */
+static int g_bulk_limit = 0;
+static int g_total_in_flight = 0;
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static int may_start(RequestPriority priority) {
+    if (g_max_in_flight <= 0) {
+        return 1;
+    }
+    if (g_total_in_flight >= g_max_in_flight) {
+        return 0;
+    }
+    if (priority == REQUEST_PRIORITY_INTERACTIVE) {
+        return 1;
+    }
+    /* Bulk stays out of the reserved slots and behind queued interactive requests */
+    return g_lanes[REQUEST_PRIORITY_BULK].in_flight < g_bulk_limit &&
+           g_lanes[REQUEST_PRIORITY_INTERACTIVE].waiting == 0;
+}
+
+/**
+ * Hand a free slot to the next waiter, interactive first
+ */
+static void wake_next(void) {
+    if (g_lanes[REQUEST_PRIORITY_INTERACTIVE].waiting > 0 && may_start(REQUEST_PRIORITY_INTERACTIVE)) {
+        pthread_cond_signal(&g_lane_cond[REQUEST_PRIORITY_INTERACTIVE]);
+    } else if (g_lanes[REQUEST_PRIORITY_BULK].waiting > 0 && may_start(REQUEST_PRIORITY_BULK)) {
+        pthread_cond_signal(&g_lane_cond[REQUEST_PRIORITY_BULK]);
+    }
+}
+
+void request_lanes_configure(const RequestLanesOptions *options) {
+    pthread_mutex_lock(&g_lanes_mutex);
+    g_max_in_flight = options != NULL && options->max_in_flight > 0 ? options->max_in_flight : 0;
+    if (g_max_in_flight > 0) {
+        int reserved = options->interactive_reserved == 0 ? LANES_DEFAULT_INTERACTIVE_RESERVED
+                                                           : options->interactive_reserved;
+        if (reserved < 0) {
+            reserved = 0;
+        }
+        if (reserved > g_max_in_flight - 1) {
+            reserved = g_max_in_flight - 1;  /* Bulk keeps at least one slot, or it would never finish */
+        }
+        g_bulk_limit = g_max_in_flight - reserved;
+    }
+    for (int i = 0; i < REQUEST_PRIORITY_COUNT; i++) {
+        pthread_cond_broadcast(&g_lane_cond[i]);
+    }
+    pthread_mutex_unlock(&g_lanes_mutex);
+}
+
+void request_lanes_acquire(RequestPriority priority) {
+    LaneStats *lane;
+
+    if ((unsigned)priority >= REQUEST_PRIORITY_COUNT) {
+        priority = REQUEST_PRIORITY_INTERACTIVE;
+    }
+    lane = &g_lanes[priority];
+
+    pthread_mutex_lock(&g_lanes_mutex);
+    if (!may_start(priority)) {
+        unsigned long long start = monotonic_ns();
+        lane->waiting++;
+        while (!may_start(priority)) {
+            pthread_cond_wait(&g_lane_cond[priority], &g_lanes_mutex);
+        }
+        lane->waiting--;
+        unsigned long long waited = monotonic_ns() - start;
+        lane->wait_ns += waited;
+        if (waited > lane->max_wait_ns) {
+            lane->max_wait_ns = waited;
+        }
+    }
+    lane->in_flight++;
+    lane->admitted++;
+    g_total_in_flight++;
+
+    /* The last interactive waiter leaving may unblock bulk requests */
+    wake_next();
+    pthread_mutex_unlock(&g_lanes_mutex);
+}
+
+void request_lanes_release(RequestPriority priority) {
+    if ((unsigned)priority >= REQUEST_PRIORITY_COUNT) {
+        priority = REQUEST_PRIORITY_INTERACTIVE;
+    }
+
+    pthread_mutex_lock(&g_lanes_mutex);
+    g_lanes[priority].in_flight--;
+    g_total_in_flight--;
+    wake_next();
+    pthread_mutex_unlock(&g_lanes_mutex);
+}
+
+void request_lanes_stats(RequestPriority priority, LaneStats *stats) {
+    if ((unsigned)priority >= REQUEST_PRIORITY_COUNT) {
+        memset(stats, 0, sizeof(LaneStats));
+        return;
+    }
+    pthread_mutex_lock(&g_lanes_mutex);
+    *stats = g_lanes[priority];
+    pthread_mutex_unlock(&g_lanes_mutex);
+}
+
+const char *request_priority_name(RequestPriority priority) {
+    return (unsigned)priority < REQUEST_PRIORITY_COUNT ? LANE_NAMES[priority] : "unknown";
+}
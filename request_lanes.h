@@ -0,0 +1,64 @@
+#ifndef REQUEST_LANES_H
+#define REQUEST_LANES_H
+
+#define LANES_DEFAULT_INTERACTIVE_RESERVED 1
+
+/**
+ * Lane of a request. Interactive requests are what a user is waiting on
+ * (a punch from the GUI); bulk requests are background syncs and imports.
+ */
+typedef enum {
+    REQUEST_PRIORITY_INTERACTIVE = 0,
+    REQUEST_PRIORITY_BULK,
+    REQUEST_PRIORITY_COUNT
+} RequestPriority;
+
+/**
+ * Concurrency shared by the lanes. Zeroed options leave requests ungated.
+ */
+typedef struct {
+    int max_in_flight;          /* requests in flight over both lanes, 0 or negative for no limit */
+    int interactive_reserved;   /* slots bulk requests may never take (0 for LANES_DEFAULT_INTERACTIVE_RESERVED,
+                                   negative for none) */
+} RequestLanesOptions;
+
+/**
+ * Counters of one lane
+ */
+typedef struct {
+    int in_flight;
+    int waiting;
+    unsigned long long admitted;
+    unsigned long long wait_ns;         /* time spent queued, summed over requests */
+    unsigned long long max_wait_ns;
+} LaneStats;
+
+/**
+ * Set the process-wide lane limits (waiting requests are re-checked).
+ * Bulk requests get at most max_in_flight - interactive_reserved slots, and
+ * a free slot goes to a queued interactive request before any bulk one.
+ * @param options Limits, NULL to remove them
+ */
+void request_lanes_configure(const RequestLanesOptions *options);
+
+/**
+ * Wait for a slot in the request's lane (returns at once without limits)
+ */
+void request_lanes_acquire(RequestPriority priority);
+
+/**
+ * Give back a slot taken with request_lanes_acquire()
+ */
+void request_lanes_release(RequestPriority priority);
+
+/**
+ * Snapshot of one lane's counters
+ */
+void request_lanes_stats(RequestPriority priority, LaneStats *stats);
+
+/**
+ * Lane name for reports ("interactive" or "bulk")
+ */
+const char *request_priority_name(RequestPriority priority);
+
+#endif /* REQUEST_LANES_H */
@@ -0,0 +1,401 @@
+#include "token_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#define CACHE_MAGIC "OHTC"
+#define CACHE_MAGIC_SIZE 4
+#define CACHE_SALT_SIZE 16
+#define CACHE_IV_SIZE 12
+#define CACHE_TAG_SIZE 16
+#define CACHE_KEY_SIZE 32
+#define CACHE_HEADER_SIZE (CACHE_MAGIC_SIZE + 1 + CACHE_SALT_SIZE + CACHE_IV_SIZE)
+#define CACHE_IDENTITY_SIZE 1024
+
+/**
+ * Process-wide cache state (guarded by g_cache_mutex)
+ */
+typedef struct {
+    int open;
+    char *path;
+    char identity[CACHE_IDENTITY_SIZE];     /* credentials the file is bound to */
+    unsigned char salt[CACHE_SALT_SIZE];
+    unsigned char key[CACHE_KEY_SIZE];
+    Transport *transport;                   /* TLS sessions are read from and written to it */
+    char *token;
+    time_t expires_at;
+    int servable;                           /* token came from the file and has not been rejected */
+} TokenCache;
+
+static TokenCache g_cache;
+static pthread_mutex_t g_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void build_identity(const Config *config, char *identity, size_t size) {
+    snprintf(identity, size, "%s|%s|%s|%s",
+             config->type != NULL ? config->type : "",
+             config->base_url != NULL ? config->base_url : "",
+             config->client_id != NULL ? config->client_id : "",
+             config->username != NULL ? config->username : "");
+}
+
+/**
+ * Derive the file key from the client secret (and password, for the password grant)
+ */
+static int derive_key(const Config *config, const unsigned char *salt, unsigned char *key) {
+    char secret[MAX_HEADER_SIZE];
+    int length = snprintf(secret, sizeof(secret), "%s\n%s",
+                          config->client_secret != NULL ? config->client_secret : "",
+                          config->password != NULL ? config->password : "");
+    int ok = length >= 0 && (size_t)length < sizeof(secret) &&
+             PKCS5_PBKDF2_HMAC(secret, length, salt, CACHE_SALT_SIZE, TOKEN_CACHE_KDF_ITERATIONS,
+                               EVP_sha256(), CACHE_KEY_SIZE, key) == 1;
+    OPENSSL_cleanse(secret, sizeof(secret));
+    if (!ok) {
+        fprintf(stderr, "Failed to derive the token cache key\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void put_u64(unsigned char *out, unsigned long long value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static unsigned long long get_u64(const unsigned char *in) {
+    unsigned long long value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (unsigned long long)in[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * AES-256-GCM over the body; the header and identity are authenticated too
+ * @param tag Written when encrypting, checked when decrypting
+ * @return 0 on success, -1 on failure (including a tag mismatch)
+ */
+static int seal(int encrypt, const unsigned char *header, const unsigned char *in, size_t length,
+                unsigned char *out, unsigned char *tag) {
+    const unsigned char *iv = header + CACHE_MAGIC_SIZE + 1 + CACHE_SALT_SIZE;
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int out_length = 0;
+    int ok = ctx != NULL &&
+             EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), NULL, NULL, NULL, encrypt) == 1 &&
+             EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, CACHE_IV_SIZE, NULL) == 1 &&
+             EVP_CipherInit_ex(ctx, NULL, NULL, g_cache.key, iv, encrypt) == 1 &&
+             EVP_CipherUpdate(ctx, NULL, &out_length, header, CACHE_HEADER_SIZE) == 1 &&
+             EVP_CipherUpdate(ctx, NULL, &out_length, (const unsigned char *)g_cache.identity,
+                              (int)strlen(g_cache.identity)) == 1 &&
+             EVP_CipherUpdate(ctx, out, &out_length, in, (int)length) == 1;
+    if (ok && !encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, CACHE_TAG_SIZE, tag) == 1;
+    }
+    ok = ok && EVP_CipherFinal_ex(ctx, out + out_length, &out_length) == 1;
+    if (ok && encrypt) {
+        ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, CACHE_TAG_SIZE, tag) == 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return ok ? 0 : -1;
+}
+
+/**
+ * Read and decrypt the cache file into g_cache (key derived from the file's salt)
+ * @param tls Receives the TLS session records (release with free()), NULL if none
+ * @return 0 if the file was read, -1 if it is missing or unusable
+ */
+static int read_cache_file(const Config *config, unsigned char **tls, size_t *tls_length) {
+    unsigned char *file_data = NULL;
+    unsigned char *plain = NULL;
+    size_t length = 0;
+    size_t body_length = 0;
+    int result = -1;
+
+    *tls = NULL;
+    *tls_length = 0;
+
+    FILE *file = fopen(g_cache.path, "rb");
+    if (file == NULL) {
+        if (errno != ENOENT) {
+            fprintf(stderr, "Failed to open token cache %s: %s\n", g_cache.path, strerror(errno));
+        }
+        return -1;
+    }
+    file_data = (unsigned char *)malloc(TOKEN_CACHE_MAX_FILE_SIZE);
+    if (file_data != NULL) {
+        length = fread(file_data, 1, TOKEN_CACHE_MAX_FILE_SIZE, file);
+    }
+    fclose(file);
+    if (file_data == NULL) {
+        fprintf(stderr, "Failed to allocate token cache buffer\n");
+        return -1;
+    }
+
+    if (length < CACHE_HEADER_SIZE + CACHE_TAG_SIZE + 24 ||
+        memcmp(file_data, CACHE_MAGIC, CACHE_MAGIC_SIZE) != 0 ||
+        file_data[CACHE_MAGIC_SIZE] != TOKEN_CACHE_VERSION) {
+        fprintf(stderr, "Ignoring token cache %s: unknown format\n", g_cache.path);
+        goto cleanup;
+    }
+    memcpy(g_cache.salt, file_data + CACHE_MAGIC_SIZE + 1, CACHE_SALT_SIZE);
+    if (derive_key(config, g_cache.salt, g_cache.key) != 0) {
+        goto cleanup;
+    }
+
+    body_length = length - CACHE_HEADER_SIZE - CACHE_TAG_SIZE;
+    plain = (unsigned char *)malloc(body_length);
+    if (plain == NULL ||
+        seal(0, file_data, file_data + CACHE_HEADER_SIZE + CACHE_TAG_SIZE, body_length,
+             plain, file_data + CACHE_HEADER_SIZE) != 0) {
+        fprintf(stderr, "Ignoring token cache %s: written for other credentials or damaged\n", g_cache.path);
+        goto cleanup;
+    }
+
+    /* expires_at, token length, token, TLS length, TLS session records */
+    unsigned long long token_length = get_u64(plain + 8);
+    if (token_length > body_length - 24 || get_u64(plain + 16 + token_length) != body_length - 24 - token_length) {
+        fprintf(stderr, "Ignoring token cache %s: malformed contents\n", g_cache.path);
+        goto cleanup;
+    }
+    if (token_length > 0) {
+        g_cache.token = (char *)mem_alloc(MEM_CONFIG, token_length + 1);
+        if (g_cache.token == NULL) {
+            goto cleanup;
+        }
+        memcpy(g_cache.token, plain + 16, token_length);
+        g_cache.token[token_length] = '\0';
+        g_cache.expires_at = (time_t)get_u64(plain);
+        g_cache.servable = 1;
+    }
+    *tls_length = body_length - 24 - token_length;
+    if (*tls_length > 0) {
+        *tls = (unsigned char *)malloc(*tls_length);
+        if (*tls == NULL) {
+            *tls_length = 0;
+        } else {
+            memcpy(*tls, plain + 24 + token_length, *tls_length);
+        }
+    }
+    result = 0;
+
+cleanup:
+    if (plain != NULL) {
+        OPENSSL_cleanse(plain, body_length);
+        free(plain);
+    }
+    free(file_data);
+    return result;
+}
+
+/**
+ * Encrypt the token and the transport's TLS sessions and replace the file atomically
+ */
+static int write_cache_file(void) {
+    unsigned char *tls = NULL;
+    unsigned char *plain = NULL;
+    unsigned char *file_data = NULL;
+    size_t tls_length = 0;
+    size_t token_length = g_cache.token != NULL ? strlen(g_cache.token) : 0;
+    char tmp_path[MAX_URL_SIZE];
+    int fd = -1;
+    int created = 0;
+    int result = -1;
+
+    if (g_cache.transport != NULL && strcmp(g_cache.transport->name, "curl") == 0) {
+        curl_transport_export_tls_sessions(g_cache.transport, &tls, &tls_length);
+    }
+
+    size_t body_length = 24 + token_length + tls_length;
+    size_t length = CACHE_HEADER_SIZE + CACHE_TAG_SIZE + body_length;
+    if (length > TOKEN_CACHE_MAX_FILE_SIZE) {
+        tls_length = 0;  /* Too many sessions: keep the token, resume TLS from scratch */
+        body_length = 24 + token_length;
+        length = CACHE_HEADER_SIZE + CACHE_TAG_SIZE + body_length;
+    }
+    plain = (unsigned char *)malloc(body_length);
+    file_data = (unsigned char *)malloc(length);
+    if (plain == NULL || file_data == NULL) {
+        fprintf(stderr, "Failed to allocate token cache buffer\n");
+        goto cleanup;
+    }
+
+    put_u64(plain, token_length > 0 ? (unsigned long long)g_cache.expires_at : 0);
+    put_u64(plain + 8, token_length);
+    memcpy(plain + 16, g_cache.token != NULL ? g_cache.token : "", token_length);
+    put_u64(plain + 16 + token_length, tls_length);
+    if (tls_length > 0) {
+        memcpy(plain + 24 + token_length, tls, tls_length);
+    }
+
+    /* A fresh IV for every write; the key stays the same for the file's salt */
+    memcpy(file_data, CACHE_MAGIC, CACHE_MAGIC_SIZE);
+    file_data[CACHE_MAGIC_SIZE] = TOKEN_CACHE_VERSION;
+    memcpy(file_data + CACHE_MAGIC_SIZE + 1, g_cache.salt, CACHE_SALT_SIZE);
+    if (RAND_bytes(file_data + CACHE_MAGIC_SIZE + 1 + CACHE_SALT_SIZE, CACHE_IV_SIZE) != 1 ||
+        seal(1, file_data, plain, body_length, file_data + CACHE_HEADER_SIZE + CACHE_TAG_SIZE,
+             file_data + CACHE_HEADER_SIZE) != 0) {
+        fprintf(stderr, "Failed to encrypt the token cache\n");
+        goto cleanup;
+    }
+
+    /* Write next to the file and rename, so readers never see a partial cache */
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", g_cache.path) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "Token cache path too long\n");
+        goto cleanup;
+    }
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to write token cache %s: %s\n", tmp_path, strerror(errno));
+        goto cleanup;
+    }
+    created = 1;
+    size_t written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, file_data + written, length - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            fprintf(stderr, "Failed to write token cache %s: %s\n", tmp_path, strerror(errno));
+            goto cleanup;
+        }
+        written += (size_t)n;
+    }
+    if (fsync(fd) != 0 || close(fd) != 0) {
+        fd = -1;
+        fprintf(stderr, "Failed to write token cache %s: %s\n", tmp_path, strerror(errno));
+        goto cleanup;
+    }
+    fd = -1;
+    if (rename(tmp_path, g_cache.path) != 0) {
+        fprintf(stderr, "Failed to replace token cache %s: %s\n", g_cache.path, strerror(errno));
+        goto cleanup;
+    }
+    result = 0;
+
+cleanup:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (result != 0 && created) {
+        unlink(tmp_path);
+    }
+    if (plain != NULL) {
+        OPENSSL_cleanse(plain, body_length);
+        free(plain);
+    }
+    free(file_data);
+    free(tls);
+    return result;
+}
+
+int token_cache_open(const Config *config) {
+    unsigned char *tls = NULL;
+    size_t tls_length = 0;
+
+    if (config == NULL || config->token_cache == NULL || config->token_cache[0] == '\0') {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_cache_mutex);
+    if (g_cache.open) {
+        pthread_mutex_unlock(&g_cache_mutex);
+        fprintf(stderr, "Token cache is already open\n");
+        return -1;
+    }
+    g_cache.path = mem_strdup(MEM_CONFIG, config->token_cache);
+    if (g_cache.path == NULL) {
+        pthread_mutex_unlock(&g_cache_mutex);
+        return -1;
+    }
+    build_identity(config, g_cache.identity, sizeof(g_cache.identity));
+    g_cache.transport = config->transport != NULL ? config->transport : orangehrm_default_transport();
+
+    if (read_cache_file(config, &tls, &tls_length) != 0) {
+        /* Start over with a new salt; the file is rewritten on the first store */
+        if (RAND_bytes(g_cache.salt, CACHE_SALT_SIZE) != 1 || derive_key(config, g_cache.salt, g_cache.key) != 0) {
+            fprintf(stderr, "Failed to set up the token cache key\n");
+            mem_free(g_cache.path);
+            memset(&g_cache, 0, sizeof(g_cache));
+            pthread_mutex_unlock(&g_cache_mutex);
+            return -1;
+        }
+    }
+    if (tls_length > 0 && g_cache.transport != NULL && strcmp(g_cache.transport->name, "curl") == 0) {
+        curl_transport_import_tls_sessions(g_cache.transport, tls, tls_length);
+    }
+    g_cache.open = 1;
+    pthread_mutex_unlock(&g_cache_mutex);
+
+    free(tls);
+    return 0;
+}
+
+int token_cache_claim(Config *config) {
+    char identity[CACHE_IDENTITY_SIZE];
+    int result = -1;
+
+    build_identity(config, identity, sizeof(identity));
+    pthread_mutex_lock(&g_cache_mutex);
+    if (g_cache.open && g_cache.servable && strcmp(identity, g_cache.identity) == 0 &&
+        g_cache.expires_at - time(NULL) > TOKEN_CACHE_MIN_REMAINING_S) {
+        char *token = mem_strdup(MEM_CONFIG, g_cache.token);
+        if (token != NULL) {
+            mem_free(config->access_token);
+            config->access_token = token;
+            config->token_expires_at = g_cache.expires_at;
+            result = 0;
+        }
+    }
+    pthread_mutex_unlock(&g_cache_mutex);
+    return result;
+}
+
+void token_cache_store(const Config *config) {
+    char identity[CACHE_IDENTITY_SIZE];
+
+    if (config->access_token == NULL || config->token_expires_at == 0) {
+        return;  /* Without an expiry a cached token could never be trusted */
+    }
+    build_identity(config, identity, sizeof(identity));
+    pthread_mutex_lock(&g_cache_mutex);
+    if (g_cache.open && strcmp(identity, g_cache.identity) == 0) {
+        char *token = mem_strdup(MEM_CONFIG, config->access_token);
+        if (token != NULL) {
+            mem_free(g_cache.token);
+            g_cache.token = token;
+            g_cache.expires_at = config->token_expires_at;
+            g_cache.servable = 0;  /* In this process the caller's own copy is used */
+            write_cache_file();
+        }
+    }
+    pthread_mutex_unlock(&g_cache_mutex);
+}
+
+void token_cache_reject(void) {
+    pthread_mutex_lock(&g_cache_mutex);
+    if (g_cache.servable) {
+        g_cache.servable = 0;
+        mem_free(g_cache.token);
+        g_cache.token = NULL;
+        g_cache.expires_at = 0;
+    }
+    pthread_mutex_unlock(&g_cache_mutex);
+}
+
+void token_cache_close(void) {
+    pthread_mutex_lock(&g_cache_mutex);
+    if (g_cache.open) {
+        write_cache_file();  /* Session tickets rotate; keep the newest for the next start */
+        mem_free(g_cache.token);
+        mem_free(g_cache.path);
+        OPENSSL_cleanse(g_cache.key, sizeof(g_cache.key));
+        memset(&g_cache, 0, sizeof(g_cache));
+    }
+    pthread_mutex_unlock(&g_cache_mutex);
+}
@@ -0,0 +1,62 @@
+#ifndef TOKEN_CACHE_H
+#define TOKEN_CACHE_H
+
+#include "orangehrm_client.h"
+
+#define TOKEN_CACHE_VERSION 1
+#define TOKEN_CACHE_KDF_ITERATIONS 10000    /* PBKDF2-HMAC-SHA256 rounds for the file key */
+#define TOKEN_CACHE_MIN_REMAINING_S 120     /* serve a cached token only with this much life left
+                                               (above TOKEN_REFRESH_MARGIN_S, so refreshes go to the server) */
+#define TOKEN_CACHE_MAX_FILE_SIZE (256 * 1024)
+
+/**
+ * Encrypted on-disk cache of the access token and TLS sessions (opt-in
+ * with the "token_cache" config key), so a short-lived process can skip
+ * the OAuth exchange and resume TLS instead of doing a full handshake.
+ *
+ * The file is sealed with AES-256-GCM under a key derived from the client
+ * credentials, and bound to the server and client identity: a file written
+ * for other credentials, or tampered with, reads as empty. It is loaded at
+ * startup but the token is validated lazily: get_token() hands out the
+ * cached token while it has TOKEN_CACHE_MIN_REMAINING_S left, and the first
+ * 401 drops it so the next get_token() asks the server. Tokens fetched from
+ * the server are written back (tokens without expires_in are not cached).
+ *
+ * The cache is process wide; only configs with the credentials it was
+ * opened with use it.
+ */
+
+/**
+ * Load the cache file named by config->token_cache and seed the TLS
+ * session cache of config's transport (the default transport if it has
+ * none; set its options first). A missing, foreign or damaged file
+ * just starts an empty cache.
+ * @return 0 if the cache is active, -1 if config has no token_cache or on failure
+ */
+int token_cache_open(const Config *config);
+
+/**
+ * Use the cached token for config if the credentials match and it has not
+ * expired or been rejected (called by get_token)
+ * @return 0 if access_token and token_expires_at were set, -1 otherwise
+ */
+int token_cache_claim(Config *config);
+
+/**
+ * Remember config's freshly fetched token and write the cache, with the
+ * transport's current TLS sessions (called by get_token)
+ */
+void token_cache_store(const Config *config);
+
+/**
+ * Stop handing out the cached token (called on a 401)
+ */
+void token_cache_reject(void);
+
+/**
+ * Write the cache with the latest TLS sessions and close it. Call before
+ * orangehrm_client_cleanup(), while the transport still exists.
+ */
+void token_cache_close(void);
+
+#endif /* TOKEN_CACHE_H */
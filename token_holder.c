@@ -0,0 +1,296 @@
+#include "token_holder.h"
+#include "trace.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define TOKEN_MIN_REFRESH_INTERVAL_S 5
+
+/* Hazard slots: a reader publishes the token it is about to reference here */
+static _Atomic(SharedToken *) g_hazards[TOKEN_HAZARD_SLOTS];
+static atomic_int g_slot_owned[TOKEN_HAZARD_SLOTS];
+static _Thread_local int tls_slot = -1;
+static pthread_key_t g_slot_key;
+static pthread_once_t g_slot_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Thread exit destructor: hand the thread's hazard slot back
+ */
+static void release_slot(void *value) {
+    int slot = (int)(intptr_t)value - 1;
+    atomic_store(&g_hazards[slot], NULL);
+    atomic_store(&g_slot_owned[slot], 0);
+}
+
+static void make_slot_key(void) {
+    pthread_key_create(&g_slot_key, release_slot);
+}
+
+/**
+ * Claim a hazard slot for the calling thread (once per thread)
+ * @return Slot index, -1 if all slots are taken
+ */
+static int claim_slot(void) {
+    if (tls_slot >= 0) {
+        return tls_slot;
+    }
+
+    pthread_once(&g_slot_once, make_slot_key);
+    for (int i = 0; i < TOKEN_HAZARD_SLOTS; i++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&g_slot_owned[i], &expected, 1)) {
+            tls_slot = i;
+            pthread_setspecific(g_slot_key, (void *)(intptr_t)(i + 1));
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void monotonic_deadline(struct timespec *deadline, long ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ms / 1000;
+    deadline->tv_nsec += (ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+void shared_token_release(SharedToken *token) {
+    if (token != NULL && atomic_fetch_sub_explicit(&token->refs, 1, memory_order_acq_rel) == 1) {
+        free(token);
+    }
+}
+
+SharedToken *token_holder_acquire(TokenHolder *holder) {
+    SharedToken *token;
+    int slot = claim_slot();
+
+    if (slot < 0) {
+        /* Out of hazard slots: serialize with the publisher instead */
+        pthread_mutex_lock(&holder->mutex);
+        token = atomic_load(&holder->current);
+        if (token != NULL) {
+            atomic_fetch_add_explicit(&token->refs, 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&holder->mutex);
+        return token;
+    }
+
+    for (;;) {
+        token = atomic_load(&holder->current);
+        if (token == NULL) {
+            return NULL;
+        }
+        atomic_store(&g_hazards[slot], token);
+        if (atomic_load(&holder->current) == token) {
+            break;  /* Publisher will wait for us before dropping its reference */
+        }
+    }
+
+    atomic_fetch_add_explicit(&token->refs, 1, memory_order_relaxed);
+    atomic_store_explicit(&g_hazards[slot], NULL, memory_order_release);
+    return token;
+}
+
+/**
+ * Swap in a new token and drop the holder's reference to the old one
+ * once no reader is between loading it and taking its reference
+ */
+static void publish_token(TokenHolder *holder, SharedToken *token) {
+    pthread_mutex_lock(&holder->mutex);
+    SharedToken *old = atomic_exchange(&holder->current, token);
+    pthread_cond_broadcast(&holder->cond);
+    pthread_mutex_unlock(&holder->mutex);
+
+    if (old == NULL) {
+        return;
+    }
+    for (int i = 0; i < TOKEN_HAZARD_SLOTS; i++) {
+        while (atomic_load(&g_hazards[i]) == old) {
+            sched_yield();
+        }
+    }
+    shared_token_release(old);
+}
+
+/**
+ * Fetch a token with the holder's private credentials
+ * @return New token with one reference (the holder's), NULL on failure
+ */
+static SharedToken *fetch_token(TokenHolder *holder) {
+    if (get_token(&holder->config) != 0) {
+        return NULL;
+    }
+
+    size_t length = strlen(holder->config.access_token);
+    SharedToken *token = (SharedToken *)malloc(sizeof(SharedToken) + length + 1);
+    if (token == NULL) {
+        fprintf(stderr, "Failed to allocate shared token\n");
+        return NULL;
+    }
+
+    atomic_init(&token->refs, 1);
+    token->expires_at = holder->config.token_expires_at > 0
+                      ? holder->config.token_expires_at
+                      : time(NULL) + TOKEN_DEFAULT_LIFETIME_S;
+    memcpy(token->value, holder->config.access_token, length + 1);
+    return token;
+}
+
+/**
+ * Background refresher: fetch, publish, sleep until shortly before expiry
+ */
+static void *refresh_thread(void *data) {
+    TokenHolder *holder = (TokenHolder *)data;
+    long backoff_s = 1;
+
+    trace_set_thread_name("token_refresher");
+    pthread_mutex_lock(&holder->mutex);
+    while (!holder->stop) {
+        long sleep_s;
+        holder->refresh_requested = 0;
+        pthread_mutex_unlock(&holder->mutex);
+
+        SharedToken *token = fetch_token(holder);
+        if (token != NULL) {
+            sleep_s = (long)(token->expires_at - time(NULL)) - TOKEN_REFRESH_MARGIN_S;
+            if (sleep_s < TOKEN_MIN_REFRESH_INTERVAL_S) {
+                sleep_s = TOKEN_MIN_REFRESH_INTERVAL_S;
+            }
+            publish_token(holder, token);
+            backoff_s = 1;
+        } else {
+            fprintf(stderr, "Token refresh failed, retrying in %lds\n", backoff_s);
+            sleep_s = backoff_s;
+            backoff_s = backoff_s * 2 > TOKEN_RETRY_MAX_S ? TOKEN_RETRY_MAX_S : backoff_s * 2;
+        }
+
+        struct timespec earliest, deadline;
+        long earliest_s = sleep_s < TOKEN_MIN_REFRESH_INTERVAL_S ? sleep_s : TOKEN_MIN_REFRESH_INTERVAL_S;
+        monotonic_deadline(&earliest, earliest_s * 1000);
+        monotonic_deadline(&deadline, sleep_s * 1000);
+
+        pthread_mutex_lock(&holder->mutex);
+        /* Invalidations are honored at most once per minimum interval */
+        while (!holder->stop) {
+            if (pthread_cond_timedwait(&holder->cond, &holder->mutex, &earliest) == ETIMEDOUT) {
+                break;
+            }
+        }
+        while (!holder->stop && !holder->refresh_requested) {
+            if (pthread_cond_timedwait(&holder->cond, &holder->mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&holder->mutex);
+
+    return NULL;
+}
+
+static int copy_string(char **dest, const char *src) {
+    *dest = NULL;
+    if (src == NULL) {
+        return 0;
+    }
+    *dest = mem_strdup(MEM_CONFIG, src);
+    return *dest == NULL ? -1 : 0;
+}
+
+int token_holder_start(TokenHolder *holder, const Config *config) {
+    pthread_condattr_t attr;
+
+    if (holder == NULL || config == NULL) {
+        fprintf(stderr, "Invalid parameters for token_holder_start\n");
+        return -1;
+    }
+
+    memset(holder, 0, sizeof(TokenHolder));
+    atomic_init(&holder->current, NULL);
+
+    if (copy_string(&holder->config.base_url, config->base_url) != 0 ||
+        copy_string(&holder->config.username, config->username) != 0 ||
+        copy_string(&holder->config.password, config->password) != 0 ||
+        copy_string(&holder->config.client_id, config->client_id) != 0 ||
+        copy_string(&holder->config.client_secret, config->client_secret) != 0 ||
+        copy_string(&holder->config.type, config->type) != 0 ||
+        copy_string(&holder->config.tenant, config->tenant) != 0) {
+        fprintf(stderr, "Memory allocation failed for token holder credentials\n");
+        config_free(&holder->config);
+        return -1;
+    }
+    holder->config.transport = config->transport;
+
+    pthread_mutex_init(&holder->mutex, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&holder->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&holder->refresher, NULL, refresh_thread, holder) != 0) {
+        fprintf(stderr, "Error creating token refresh thread\n");
+        pthread_mutex_destroy(&holder->mutex);
+        pthread_cond_destroy(&holder->cond);
+        config_free(&holder->config);
+        return -1;
+    }
+
+    holder->running = 1;
+    return 0;
+}
+
+void token_holder_stop(TokenHolder *holder) {
+    if (holder == NULL || !holder->running) {
+        return;
+    }
+
+    pthread_mutex_lock(&holder->mutex);
+    holder->stop = 1;
+    pthread_cond_broadcast(&holder->cond);
+    pthread_mutex_unlock(&holder->mutex);
+    pthread_join(holder->refresher, NULL);
+
+    shared_token_release(atomic_exchange(&holder->current, NULL));
+    pthread_mutex_destroy(&holder->mutex);
+    pthread_cond_destroy(&holder->cond);
+    config_free(&holder->config);
+    holder->running = 0;
+}
+
+int token_holder_wait(TokenHolder *holder, int timeout_ms) {
+    struct timespec deadline;
+    int result = 0;
+
+    if (holder == NULL || !holder->running) {
+        return -1;
+    }
+    if (atomic_load(&holder->current) != NULL) {
+        return 0;
+    }
+
+    monotonic_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&holder->mutex);
+    while (atomic_load(&holder->current) == NULL) {
+        if (pthread_cond_timedwait(&holder->cond, &holder->mutex, &deadline) == ETIMEDOUT) {
+            result = atomic_load(&holder->current) != NULL ? 0 : -1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&holder->mutex);
+
+    return result;
+}
+
+void token_holder_invalidate(TokenHolder *holder) {
+    if (holder == NULL || !holder->running) {
+        return;
+    }
+
+    pthread_mutex_lock(&holder->mutex);
+    holder->refresh_requested = 1;
+    pthread_cond_broadcast(&holder->cond);
+    pthread_mutex_unlock(&holder->mutex);
+}
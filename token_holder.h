@@ -0,0 +1,80 @@
+#ifndef TOKEN_HOLDER_H
+#define TOKEN_HOLDER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "orangehrm_client.h"
+
+#define TOKEN_HAZARD_SLOTS 256          /* reader threads served lock-free (process wide) */
+#define TOKEN_REFRESH_MARGIN_S 60       /* refresh this long before expiry */
+#define TOKEN_DEFAULT_LIFETIME_S 3600   /* assumed lifetime when expires_in is missing */
+#define TOKEN_RETRY_MAX_S 60            /* cap of the refresh retry backoff */
+
+/**
+ * Immutable, reference counted access token
+ */
+typedef struct {
+    atomic_int refs;
+    time_t expires_at;
+    char value[];
+} SharedToken;
+
+/**
+ * Token shared by all threads of a process.
+ *
+ * Readers load the current token through an atomic pointer, protected by a
+ * per-thread hazard slot while they take a reference, so the hot path takes
+ * no lock. A single background thread fetches tokens with a private copy of
+ * the credentials and publishes each one ahead of the previous one's expiry;
+ * replaced tokens are freed when their last reader releases them.
+ */
+typedef struct TokenHolder {
+    _Atomic(SharedToken *) current;
+    Config config;              /* private credentials used by the refresher */
+    pthread_t refresher;
+    int running;
+    int stop;
+    int refresh_requested;
+    pthread_mutex_t mutex;      /* refresher wakeups and the slow reader path only */
+    pthread_cond_t cond;
+} TokenHolder;
+
+/**
+ * Copy credentials and start the background refresher (first fetch is immediate)
+ * @param holder Pointer to TokenHolder structure
+ * @param config Credentials and transport to copy
+ * @return 0 on success, -1 on failure
+ */
+int token_holder_start(TokenHolder *holder, const Config *config);
+
+/**
+ * Stop the refresher and release the current token.
+ * Readers must have released their tokens.
+ */
+void token_holder_stop(TokenHolder *holder);
+
+/**
+ * Take a reference to the current token without locking
+ * @return Token (release with shared_token_release), NULL if none yet
+ */
+SharedToken *token_holder_acquire(TokenHolder *holder);
+
+/**
+ * Drop a reference taken by token_holder_acquire (NULL is ignored)
+ */
+void shared_token_release(SharedToken *token);
+
+/**
+ * Wait until a token is available
+ * @param timeout_ms Maximum time to wait
+ * @return 0 if a token is available, -1 on timeout
+ */
+int token_holder_wait(TokenHolder *holder, int timeout_ms);
+
+/**
+ * Ask the refresher to fetch a new token now (e.g. after a 401)
+ */
+void token_holder_invalidate(TokenHolder *holder);
+
+#endif /* TOKEN_HOLDER_H */
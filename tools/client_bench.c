@@ -0,0 +1,207 @@
+#include "orangehrm_client.h"
+#include "attendance_record.h"
+#include "orangehrm_api.h"
+#include <pthread.h>
+#include <time.h>
+
+/**
+ * Client CPU benchmark over the in-process loopback transport:
+ * client_bench [--iterations N] [--threads N] [--budget-ns N]
+ *
+ * Measures header building, buffering, JSON handling and locking in the
+ * request pipeline without any network I/O. With --budget-ns the exit
+ * status is non-zero when an operation is slower than the budget.
+ */
+
+#define BENCH_DEFAULT_ITERATIONS 100000
+
+static const char TOKEN_RESPONSE[] =
+    "{\"access_token\":\"0123456789abcdef0123456789abcdef01234567\","
+    "\"token_type\":\"Bearer\",\"expires_in\":3600,\"scope\":null}";
+
+static const char ATTENDANCE_RESPONSE[] =
+    "{\"success\":true,\"data\":{\"id\":4711,\"empNumber\":12,"
+    "\"punchInUserTime\":\"2024-03-01 09:00\",\"punchOutUserTime\":\"2024-03-01 17:30\"}}";
+
+static const char EMPLOYEE_RESPONSE[] =
+    "{\"data\":[{\"empNumber\":12,\"employeeId\":\"0012\",\"firstName\":\"Ann\",\"lastName\":\"Lee\"},"
+    "{\"empNumber\":13,\"employeeId\":\"0013\",\"firstName\":\"Bo\",\"lastName\":\"Chen\"}],"
+    "\"meta\":{\"total\":2}}";
+
+typedef enum {
+    BENCH_TOKEN = 0,
+    BENCH_GET,
+    BENCH_POST,
+    BENCH_COUNT
+} BenchOperation;
+
+static const char *BENCH_NAMES[BENCH_COUNT] = { "get_token", "get_request", "post_attendance" };
+
+typedef struct {
+    Config *config;
+    BenchOperation operation;
+    long iterations;
+    int failures;
+} BenchThread;
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static int response_succeeded(const ResponseBuffer *resp) {
+    return attendance_response_status(resp->buffer, resp->size) == ATTENDANCE_ACCEPTED;
+}
+
+static void *bench_thread(void *data) {
+    BenchThread *bench = (BenchThread *)data;
+    Config config = *bench->config;
+    ResponseBuffer resp;
+    TimeFormatCache cache;
+    AttendanceRecord record;
+    OhrmListEmployeesParams page;
+    char body[ATTENDANCE_JSON_SIZE];
+
+    config.access_token = NULL;
+    if (response_buffer_init(&resp, MAX_RESPONSE_SIZE) != 0 || get_token(&config) != 0) {
+        bench->failures++;
+        response_buffer_free(&resp);
+        return NULL;
+    }
+
+    time_format_cache_init(&cache);
+    memset(&record, 0, sizeof(record));
+    snprintf(record.emp_number, sizeof(record.emp_number), "12");
+    snprintf(record.punch_in_note, sizeof(record.punch_in_note), "App In");
+    snprintf(record.punch_out_note, sizeof(record.punch_out_note), "App out");
+    record.punch_in = time(NULL);
+    memset(&page, 0, sizeof(page));
+    page.limit = 2;
+
+    for (long i = 0; i < bench->iterations; i++) {
+        switch (bench->operation) {
+        case BENCH_TOKEN:
+            bench->failures += get_token(&config) != 0;
+            break;
+        case BENCH_GET:
+            bench->failures += ohrm_list_employees(&config, &page, &resp, NULL) != 0;
+            break;
+        case BENCH_POST: {
+            FormattedPunch in, out;
+            record.punch_out = record.punch_in + 3600 + i;
+            format_punch_time(&cache, record.punch_in, &in);
+            format_punch_time(&cache, record.punch_out, &out);
+            if (attendance_record_to_json(&record, &in, &out, body, sizeof(body)) < 0 ||
+                post_request(ATTENDANCE_RECORDS_URL, body, &config, &resp) != 0 ||
+                !response_succeeded(&resp)) {
+                bench->failures++;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    mem_free(config.access_token);
+    response_buffer_free(&resp);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = BENCH_DEFAULT_ITERATIONS;
+    int threads = 1;
+    double budget_ns = 0.0;
+    int exit_code = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--budget-ns") == 0 && i + 1 < argc) {
+            budget_ns = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--iterations N] [--threads N] [--budget-ns N]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (iterations <= 0 || threads <= 0) {
+        fprintf(stderr, "Iterations and threads must be positive\n");
+        return -1;
+    }
+
+    if (orangehrm_client_init() != 0) {
+        fprintf(stderr, "Failed to initialize OrangeHRM client\n");
+        return -1;
+    }
+
+    Transport *loopback = loopback_transport_create();
+    if (loopback == NULL ||
+        loopback_transport_add_route(loopback, "POST", TOKEN_URL, 200, TOKEN_RESPONSE) != 0 ||
+        loopback_transport_add_route(loopback, "POST", ATTENDANCE_RECORDS_URL, 200, ATTENDANCE_RESPONSE) != 0 ||
+        loopback_transport_add_route(loopback, "GET", OHRM_LIST_EMPLOYEES_PATH, 200, EMPLOYEE_RESPONSE) != 0) {
+        transport_destroy(loopback);
+        orangehrm_client_cleanup();
+        return -1;
+    }
+
+    Config config;
+    memset(&config, 0, sizeof(config));
+    config.base_url = "http://loopback.invalid";
+    config.client_id = "bench";
+    config.client_secret = "bench-secret";
+    config.type = "client_credentials";
+    config.transport = loopback;
+
+    BenchThread *workers = (BenchThread *)calloc((size_t)threads, sizeof(BenchThread));
+    pthread_t *thread_ids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    if (workers == NULL || thread_ids == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit_code = -1;
+        goto cleanup;
+    }
+
+    printf("%-16s %8s %10s %12s %12s %8s\n", "operation", "threads", "iterations", "ns/op", "ops/s", "failed");
+    for (int op = 0; op < BENCH_COUNT; op++) {
+        int failures = 0;
+        int started = 0;
+        unsigned long long start = monotonic_ns();
+
+        for (int t = 0; t < threads; t++) {
+            workers[t].config = &config;
+            workers[t].operation = (BenchOperation)op;
+            workers[t].iterations = iterations;
+            workers[t].failures = 0;
+            if (pthread_create(&thread_ids[t], NULL, bench_thread, &workers[t]) != 0) {
+                fprintf(stderr, "Error creating benchmark thread\n");
+                break;
+            }
+            started++;
+        }
+        for (int t = 0; t < started; t++) {
+            pthread_join(thread_ids[t], NULL);
+            failures += workers[t].failures;
+        }
+
+        double elapsed_ns = (double)(monotonic_ns() - start);
+        double total_ops = (double)iterations * started;
+        /* Per-thread latency: wall time divided by each thread's own iterations */
+        double ns_per_op = elapsed_ns / (double)iterations;
+        printf("%-16s %8d %10ld %12.0f %12.0f %8d\n", BENCH_NAMES[op], started, iterations,
+               ns_per_op, total_ops / (elapsed_ns / 1e9), failures);
+
+        if (failures > 0 || started < threads || (budget_ns > 0.0 && ns_per_op > budget_ns)) {
+            exit_code = 1;
+        }
+    }
+    printf("Loopback requests served: %llu\n", loopback_transport_request_count(loopback));
+
+cleanup:
+    free(workers);
+    free(thread_ids);
+    transport_destroy(loopback);
+    orangehrm_client_cleanup();
+    return exit_code;
+}
@@ -0,0 +1,184 @@
+#include "attendance_aggregate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Worked-hours aggregation benchmark over synthetic attendance columns:
+ * hours_bench [--rows N] [--employees N] [--threads N] [--repeat N]
+ *
+ * Generates one shift per employee and day (with occasional open records,
+ * split shifts and overlapping double punches) in list-endpoint order, then
+ * aggregates it with 1, 2, 4, ... up to --threads workers and checks every
+ * run against the single-threaded totals.
+ */
+
+#define BENCH_DEFAULT_ROWS 5000000
+#define BENCH_DEFAULT_EMPLOYEES 20000
+#define BENCH_DEFAULT_REPEAT 3
+#define BENCH_FIRST_DAY 19723   /* 2024-01-01 */
+
+typedef struct {
+    size_t days;
+    uint64_t records;
+    uint64_t open_records;
+    uint64_t overlaps;
+    int64_t worked_s;
+    int64_t overtime_s;
+    int64_t overlap_s;
+} HoursTotals;
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    /* xorshift64* */
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static int generate_columns(AttendanceColumns *columns, size_t rows, int employees) {
+    static const int16_t OFFSETS[] = { 0, 60, 330, -300 };
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    for (int64_t day = BENCH_FIRST_DAY; columns->count < rows; day++) {
+        for (int emp = 1; emp <= employees && columns->count < rows; emp++) {
+            uint64_t r = next_random(&state);
+            int16_t offset = OFFSETS[emp % 4];
+            int64_t punch_in = day * 86400 + 8 * 3600 + (int64_t)(r % 7200) - offset * 60;
+            int64_t punch_out = punch_in + 7 * 3600 + (int64_t)((r >> 16) % (4 * 3600));
+            unsigned kind = (unsigned)((r >> 40) % 100);
+
+            if (kind == 0) {
+                punch_out = 0;
+            } else if (kind < 3 && columns->count + 1 < rows) {
+                /* Double punch overlapping the end of the shift */
+                if (attendance_columns_append(columns, emp, punch_out - 1800, punch_out + 3600,
+                                              offset, offset) != 0) {
+                    return -1;
+                }
+            } else if (kind < 10 && columns->count + 1 < rows) {
+                /* Split shift: lunch break, afternoon as a second record */
+                int64_t lunch = punch_in + 4 * 3600;
+                if (attendance_columns_append(columns, emp, lunch + 1800, punch_out, offset, offset) != 0) {
+                    return -1;
+                }
+                punch_out = lunch;
+            }
+            if (attendance_columns_append(columns, emp, punch_in, punch_out, offset, offset) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void sum_hours(const WorkedHours *hours, HoursTotals *totals) {
+    memset(totals, 0, sizeof(*totals));
+    totals->days = hours->count;
+    for (size_t i = 0; i < hours->count; i++) {
+        const WorkedDay *day = &hours->days[i];
+        totals->records += day->records;
+        totals->open_records += day->open_records;
+        totals->overlaps += day->overlaps;
+        totals->worked_s += day->worked_s;
+        totals->overtime_s += day->overtime_s;
+        totals->overlap_s += day->overlap_s;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t rows = BENCH_DEFAULT_ROWS;
+    int employees = BENCH_DEFAULT_EMPLOYEES;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int repeat = BENCH_DEFAULT_REPEAT;
+    int exit_code = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            rows = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--employees") == 0 && i + 1 < argc) {
+            employees = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--rows N] [--employees N] [--threads N] [--repeat N]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (rows == 0 || employees <= 0 || max_threads <= 0 || repeat <= 0) {
+        fprintf(stderr, "Rows, employees, threads and repeat must be positive\n");
+        return -1;
+    }
+    if (max_threads > AGGREGATE_MAX_THREADS) {
+        max_threads = AGGREGATE_MAX_THREADS;
+    }
+
+    AttendanceColumns columns;
+    attendance_columns_init(&columns);
+    unsigned long long start = monotonic_ns();
+    if (generate_columns(&columns, rows, employees) != 0) {
+        fprintf(stderr, "Failed to generate %zu attendance rows\n", rows);
+        attendance_columns_free(&columns);
+        return -1;
+    }
+    printf("Generated %zu rows for %d employees in %.0f ms\n", columns.count, employees,
+           (double)(monotonic_ns() - start) / 1e6);
+
+    HoursTotals reference;
+    memset(&reference, 0, sizeof(reference));
+    double single_ns = 0.0;
+
+    printf("%8s %10s %12s %12s %8s %10s\n", "threads", "ms", "rows/s", "ns/row", "speedup", "days");
+    for (int threads = 1;; threads = threads * 2 > max_threads ? max_threads : threads * 2) {
+        double best_ns = 0.0;
+        HoursTotals totals;
+
+        for (int r = 0; r < repeat; r++) {
+            WorkedHours hours;
+            start = monotonic_ns();
+            if (attendance_aggregate_hours(&columns, AGGREGATE_DEFAULT_DAILY_HOURS_S, threads, &hours) != 0) {
+                fprintf(stderr, "Aggregation failed with %d threads\n", threads);
+                attendance_columns_free(&columns);
+                return -1;
+            }
+            double elapsed_ns = (double)(monotonic_ns() - start);
+            if (r == 0 || elapsed_ns < best_ns) {
+                best_ns = elapsed_ns;
+            }
+            sum_hours(&hours, &totals);
+            worked_hours_free(&hours);
+        }
+
+        if (threads == 1) {
+            reference = totals;
+            single_ns = best_ns;
+        } else if (memcmp(&totals, &reference, sizeof(totals)) != 0) {
+            fprintf(stderr, "Totals with %d threads differ from the single-threaded run\n", threads);
+            exit_code = 1;
+        }
+        printf("%8d %10.1f %12.0f %12.2f %8.2f %10zu\n", threads, best_ns / 1e6,
+               (double)columns.count / (best_ns / 1e9), best_ns / (double)columns.count,
+               single_ns / best_ns, totals.days);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+
+    printf("Worked %.0f h, overtime %.0f h, %llu overlaps (%.0f h), %llu open records\n",
+           (double)reference.worked_s / 3600.0, (double)reference.overtime_s / 3600.0,
+           (unsigned long long)reference.overlaps, (double)reference.overlap_s / 3600.0,
+           (unsigned long long)reference.open_records);
+
+    attendance_columns_free(&columns);
+    return exit_code;
+}
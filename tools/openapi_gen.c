@@ -0,0 +1,1228 @@
+#include "json_scan.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Build-time generator of typed endpoint bindings:
+ * openapi_gen SPEC [OVERLAY...] OUTDIR
+ *
+ * Reads an OpenAPI 3 document (JSON), plus overlay documents whose paths
+ * and schemas are merged into it (local extensions kept out of the
+ * upstream spec; $refs resolve across documents), and writes to OUTDIR:
+ *   orangehrm_api_types.h  path constants, request/response structs, codecs
+ *   orangehrm_api.h        one typed call per operation
+ *   orangehrm_api.c        straight-line serializers, decoders and calls
+ *
+ * Serializers write into a caller buffer and decoders walk the response
+ * once with json_scan, dispatching on key length, so neither allocates.
+ * Supported: components/schemas objects with string, integer, number,
+ * boolean, $ref and array properties, query parameters, JSON request
+ * bodies and $ref responses. Anything else stops the build with an error.
+ */
+
+#define GEN_NAME_SIZE 96
+#define GEN_MAX_SCHEMAS 64
+#define GEN_MAX_FIELDS 64
+#define GEN_MAX_OPERATIONS 64
+#define GEN_MAX_PARAMS 16
+#define GEN_MAX_DOCUMENTS 4
+#define GEN_DEFAULT_STRING_LENGTH 255
+#define GEN_SCHEMA_REF_PREFIX "#/components/schemas/"
+
+typedef enum {
+    FIELD_STRING = 0,
+    FIELD_INTEGER,
+    FIELD_NUMBER,
+    FIELD_BOOLEAN,
+    FIELD_OBJECT,   /* $ref: nested struct */
+    FIELD_ARRAY,    /* kept as a JsonSlice; items decoded by the caller */
+    FIELD_RAW       /* oneOf, inline objects: kept as a JsonSlice */
+} FieldKind;
+
+#define ROLE_REQUEST 1
+#define ROLE_RESPONSE 2
+
+typedef struct {
+    char json_name[GEN_NAME_SIZE];
+    char c_name[GEN_NAME_SIZE];
+    char macro[GEN_NAME_SIZE * 3];
+    FieldKind kind;
+    int required;
+    int nullable;
+    long max_length;    /* strings: characters */
+    int ref;            /* schema of FIELD_OBJECT or of FIELD_ARRAY items, -1 if none */
+} Field;
+
+typedef struct {
+    char name[GEN_NAME_SIZE];
+    char c_type[GEN_NAME_SIZE + 8];
+    char prefix[GEN_NAME_SIZE + 8];     /* ohrm_snake_name */
+    char macro[GEN_NAME_SIZE + 8];      /* OHRM_SNAKE_NAME */
+    JsonSlice body;
+    Field fields[GEN_MAX_FIELDS];
+    int field_count;
+    int role;
+    int emitted;
+} Schema;
+
+typedef struct {
+    char json_name[GEN_NAME_SIZE];
+    char c_name[GEN_NAME_SIZE];
+    char macro[GEN_NAME_SIZE * 3];
+    FieldKind kind;     /* string, integer or boolean */
+    int required;
+} Param;
+
+typedef struct {
+    char id[GEN_NAME_SIZE];
+    char prefix[GEN_NAME_SIZE + 8];
+    char macro[GEN_NAME_SIZE + 8];
+    char summary[256];
+    char path[256];
+    char method[8];
+    Param params[GEN_MAX_PARAMS];
+    int param_count;
+    int has_body;
+    int body_schema;    /* JSON request body, -1 if none */
+    int body_items;     /* item schema of a JSON array request body, -1 if none */
+    int result_schema;  /* JSON response, -1 if none */
+} Operation;
+
+typedef struct {
+    Schema schemas[GEN_MAX_SCHEMAS];
+    int schema_count;
+    Operation operations[GEN_MAX_OPERATIONS];
+    int operation_count;
+} Spec;
+
+static const char *METHODS[] = { "get", "post", "put", "patch", "delete" };
+
+/* ---- Spec reading ---- */
+
+static int slice_string(const JsonSlice *slice, char *buffer, size_t size) {
+    return slice->type == JSON_SCAN_STRING && json_scan_string(slice, buffer, size) >= 0 ? 0 : -1;
+}
+
+static int find(const JsonSlice *in, const char *path, JsonSlice *out) {
+    return json_scan_find(in->ptr, in->length, path, out) == JSON_SCAN_FOUND ? 0 : -1;
+}
+
+static int find_string(const JsonSlice *in, const char *path, char *buffer, size_t size) {
+    JsonSlice value;
+    return find(in, path, &value) == 0 ? slice_string(&value, buffer, size) : -1;
+}
+
+static int find_flag(const JsonSlice *in, const char *path) {
+    JsonSlice value;
+    int flag = 0;
+    return find(in, path, &value) == 0 && json_scan_bool(&value, &flag) == 0 && flag;
+}
+
+/**
+ * "<owner macro>_HAS_<NAME>" presence bit name of a field or parameter
+ */
+static void upper_case(const char *name, char *out, size_t size);
+
+static void presence_macro(const char *owner, const char *c_name, char *out, size_t size) {
+    char upper[GEN_NAME_SIZE];
+    char macro[GEN_NAME_SIZE * 3];
+
+    upper_case(c_name, upper, sizeof(upper));
+    snprintf(macro, sizeof(macro), "%s_HAS_%s", owner, upper);
+    snprintf(out, size, "%s", macro);
+}
+
+/**
+ * camelCase to snake_case ("empNumber" -> "emp_number")
+ */
+static void snake_case(const char *name, char *out, size_t size) {
+    size_t pos = 0;
+    for (size_t i = 0; name[i] != '\0' && pos + 2 < size; i++) {
+        unsigned char c = (unsigned char)name[i];
+        if (isupper(c) && i > 0 && (islower((unsigned char)name[i - 1]) || isdigit((unsigned char)name[i - 1]))) {
+            out[pos++] = '_';
+        }
+        out[pos++] = isalnum(c) ? (char)tolower(c) : '_';
+    }
+    out[pos] = '\0';
+}
+
+static void upper_case(const char *name, char *out, size_t size) {
+    size_t i = 0;
+    for (; name[i] != '\0' && i + 1 < size; i++) {
+        out[i] = (char)toupper((unsigned char)name[i]);
+    }
+    out[i] = '\0';
+}
+
+static int schema_index(const Spec *spec, const char *name) {
+    for (int i = 0; i < spec->schema_count; i++) {
+        if (strcmp(spec->schemas[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Resolve {"$ref": "#/components/schemas/Name"}
+ * @return Schema index, -1 if the value has no $ref, -2 if it cannot be resolved
+ */
+static int resolve_ref(const Spec *spec, const JsonSlice *value) {
+    char ref[GEN_NAME_SIZE * 2];
+    if (find_string(value, "$ref", ref, sizeof(ref)) != 0) {
+        return -1;
+    }
+    size_t prefix = strlen(GEN_SCHEMA_REF_PREFIX);
+    int index = strncmp(ref, GEN_SCHEMA_REF_PREFIX, prefix) == 0 ? schema_index(spec, ref + prefix) : -1;
+    if (index < 0) {
+        fprintf(stderr, "openapi_gen: cannot resolve $ref %s\n", ref);
+        return -2;
+    }
+    return index;
+}
+
+static int field_kind(const char *type, FieldKind *kind) {
+    static const struct { const char *name; FieldKind kind; } TYPES[] = {
+        { "string", FIELD_STRING }, { "integer", FIELD_INTEGER }, { "number", FIELD_NUMBER },
+        { "boolean", FIELD_BOOLEAN }, { "array", FIELD_ARRAY }, { "object", FIELD_RAW }
+    };
+    for (size_t i = 0; i < sizeof(TYPES) / sizeof(TYPES[0]); i++) {
+        if (strcmp(type, TYPES[i].name) == 0) {
+            *kind = TYPES[i].kind;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int parse_field(const Spec *spec, Schema *schema, const JsonSlice *key, const JsonSlice *value) {
+    Field *field = &schema->fields[schema->field_count];
+    char type[32];
+    char format[32];
+    JsonSlice items, number;
+    long long max_length;
+
+    if (schema->field_count == GEN_MAX_FIELDS) {
+        fprintf(stderr, "openapi_gen: %s has more than %d properties\n", schema->name, GEN_MAX_FIELDS);
+        return -1;
+    }
+    memset(field, 0, sizeof(Field));
+    if (slice_string(key, field->json_name, sizeof(field->json_name)) != 0) {
+        return -1;
+    }
+    snake_case(field->json_name, field->c_name, sizeof(field->c_name));
+    presence_macro(schema->macro, field->c_name, field->macro, sizeof(field->macro));
+    field->nullable = find_flag(value, "nullable");
+    field->ref = resolve_ref(spec, value);
+    if (field->ref == -2) {
+        return -1;
+    }
+
+    if (field->ref >= 0) {
+        field->kind = FIELD_OBJECT;
+    } else if (find_string(value, "type", type, sizeof(type)) != 0) {
+        field->kind = FIELD_RAW;  /* oneOf, anyOf, untyped */
+    } else if (field_kind(type, &field->kind) != 0) {
+        fprintf(stderr, "openapi_gen: %s.%s has unsupported type %s\n", schema->name, field->json_name, type);
+        return -1;
+    }
+
+    if (field->kind == FIELD_ARRAY && find(value, "items", &items) == 0 &&
+        (field->ref = resolve_ref(spec, &items)) == -2) {
+        return -1;
+    }
+    if (field->kind == FIELD_STRING) {
+        if (find_string(value, "format", format, sizeof(format)) != 0) {
+            format[0] = '\0';
+        }
+        if (find(value, "maxLength", &number) == 0 && json_scan_long(&number, &max_length) == 0 && max_length > 0) {
+            field->max_length = (long)max_length;
+        } else if (strcmp(format, "date") == 0) {
+            field->max_length = 10;
+        } else if (strcmp(format, "date-time") == 0) {
+            field->max_length = 32;
+        } else {
+            field->max_length = GEN_DEFAULT_STRING_LENGTH;
+        }
+    }
+    schema->field_count++;
+    return 0;
+}
+
+static int parse_schema(Spec *spec, Schema *schema) {
+    JsonSlice properties, required, key, value;
+    JsonIterator iterator;
+    char type[32];
+    int rc;
+
+    if (find_string(&schema->body, "type", type, sizeof(type)) != 0 || strcmp(type, "object") != 0 ||
+        find(&schema->body, "properties", &properties) != 0 || json_scan_iter_init(&iterator, &properties) != 0) {
+        fprintf(stderr, "openapi_gen: schema %s must be an object with properties\n", schema->name);
+        return -1;
+    }
+    while ((rc = json_scan_iter_next(&iterator, &key, &value)) == JSON_SCAN_FOUND) {
+        if (parse_field(spec, schema, &key, &value) != 0) {
+            return -1;
+        }
+    }
+    if (rc != JSON_SCAN_NOT_FOUND) {
+        return -1;
+    }
+
+    if (find(&schema->body, "required", &required) == 0) {
+        if (json_scan_iter_init(&iterator, &required) != 0) {
+            return -1;
+        }
+        while ((rc = json_scan_iter_next(&iterator, NULL, &value)) == JSON_SCAN_FOUND) {
+            char name[GEN_NAME_SIZE];
+            int matched = 0;
+            if (slice_string(&value, name, sizeof(name)) != 0) {
+                return -1;
+            }
+            for (int i = 0; i < schema->field_count; i++) {
+                if (strcmp(schema->fields[i].json_name, name) == 0) {
+                    schema->fields[i].required = matched = 1;
+                }
+            }
+            if (!matched) {
+                fprintf(stderr, "openapi_gen: %s requires unknown property %s\n", schema->name, name);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Register the schema names of one document (properties are parsed once
+ * all documents are read)
+ * @param required Whether the document must define components.schemas
+ */
+static int collect_schemas(Spec *spec, const JsonSlice *root, int required) {
+    JsonSlice schemas, key, value;
+    JsonIterator iterator;
+    int rc;
+
+    if (find(root, "components.schemas", &schemas) != 0) {
+        if (!required) {
+            return 0;
+        }
+        fprintf(stderr, "openapi_gen: no components.schemas\n");
+        return -1;
+    }
+    if (json_scan_iter_init(&iterator, &schemas) != 0) {
+        fprintf(stderr, "openapi_gen: components.schemas is not an object\n");
+        return -1;
+    }
+    while ((rc = json_scan_iter_next(&iterator, &key, &value)) == JSON_SCAN_FOUND) {
+        char name[GEN_NAME_SIZE];
+        char snake[GEN_NAME_SIZE];
+        Schema *schema = &spec->schemas[spec->schema_count];
+        if (spec->schema_count == GEN_MAX_SCHEMAS || slice_string(&key, name, sizeof(name)) != 0) {
+            fprintf(stderr, "openapi_gen: too many schemas or bad schema name\n");
+            return -1;
+        }
+        if (schema_index(spec, name) >= 0) {
+            fprintf(stderr, "openapi_gen: schema %s is defined twice\n", name);
+            return -1;
+        }
+        snake_case(name, snake, sizeof(snake));
+        snprintf(schema->name, sizeof(schema->name), "%s", name);
+        snprintf(schema->c_type, sizeof(schema->c_type), "Ohrm%s", name);
+        snprintf(schema->prefix, sizeof(schema->prefix), "ohrm_%s", snake);
+        upper_case(schema->prefix, schema->macro, sizeof(schema->macro));
+        schema->body = value;
+        spec->schema_count++;
+    }
+    return rc == JSON_SCAN_NOT_FOUND ? 0 : -1;
+}
+
+static int parse_schemas(Spec *spec) {
+    /* Properties after all names are known, so $refs resolve in any order */
+    for (int i = 0; i < spec->schema_count; i++) {
+        if (parse_schema(spec, &spec->schemas[i]) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int parse_params(Operation *operation, const JsonSlice *list) {
+    JsonIterator iterator;
+    JsonSlice value;
+    char where[16];
+    char type[32];
+    int rc;
+
+    if (json_scan_iter_init(&iterator, list) != 0) {
+        return -1;
+    }
+    while ((rc = json_scan_iter_next(&iterator, NULL, &value)) == JSON_SCAN_FOUND) {
+        Param *param = &operation->params[operation->param_count];
+        if (operation->param_count == GEN_MAX_PARAMS) {
+            fprintf(stderr, "openapi_gen: %s has too many parameters\n", operation->id);
+            return -1;
+        }
+        memset(param, 0, sizeof(Param));
+        if (find_string(&value, "name", param->json_name, sizeof(param->json_name)) != 0 ||
+            find_string(&value, "in", where, sizeof(where)) != 0 ||
+            find_string(&value, "schema.type", type, sizeof(type)) != 0) {
+            fprintf(stderr, "openapi_gen: %s has a parameter without name, in or schema.type\n", operation->id);
+            return -1;
+        }
+        if (strcmp(where, "query") != 0 || field_kind(type, &param->kind) != 0 ||
+            (param->kind != FIELD_STRING && param->kind != FIELD_INTEGER && param->kind != FIELD_BOOLEAN)) {
+            fprintf(stderr, "openapi_gen: %s.%s: only string, integer and boolean query parameters are supported\n",
+                    operation->id, param->json_name);
+            return -1;
+        }
+        param->required = find_flag(&value, "required");
+        snake_case(param->json_name, param->c_name, sizeof(param->c_name));
+        presence_macro(operation->macro, param->c_name, param->macro, sizeof(param->macro));
+        operation->param_count++;
+    }
+    return rc == JSON_SCAN_NOT_FOUND ? 0 : -1;
+}
+
+static int parse_operation(Spec *spec, const char *path, const char *method, const JsonSlice *body) {
+    Operation *operation = &spec->operations[spec->operation_count];
+    JsonSlice value;
+    char snake[GEN_NAME_SIZE];
+
+    if (spec->operation_count == GEN_MAX_OPERATIONS) {
+        fprintf(stderr, "openapi_gen: too many operations\n");
+        return -1;
+    }
+    memset(operation, 0, sizeof(Operation));
+    if (find_string(body, "operationId", operation->id, sizeof(operation->id)) != 0) {
+        fprintf(stderr, "openapi_gen: %s %s has no operationId\n", method, path);
+        return -1;
+    }
+    find_string(body, "summary", operation->summary, sizeof(operation->summary));
+    snprintf(operation->path, sizeof(operation->path), "%s", path);
+    upper_case(method, operation->method, sizeof(operation->method));
+    for (int i = 0; i < spec->operation_count; i++) {
+        if (strcmp(spec->operations[i].id, operation->id) == 0 ||
+            (strcmp(spec->operations[i].path, path) == 0 && strcmp(spec->operations[i].method, operation->method) == 0)) {
+            fprintf(stderr, "openapi_gen: %s %s (%s) is defined twice\n", method, path, operation->id);
+            return -1;
+        }
+    }
+    snake_case(operation->id, snake, sizeof(snake));
+    snprintf(operation->prefix, sizeof(operation->prefix), "ohrm_%s", snake);
+    upper_case(operation->prefix, operation->macro, sizeof(operation->macro));
+    if (strchr(path, '{') != NULL) {
+        fprintf(stderr, "openapi_gen: %s: path parameters are not supported\n", operation->id);
+        return -1;
+    }
+
+    if (find(body, "parameters", &value) == 0 && parse_params(operation, &value) != 0) {
+        return -1;
+    }
+
+    operation->body_schema = -1;
+    operation->body_items = -1;
+    operation->has_body = find(body, "requestBody", &value) == 0;
+    if (operation->has_body && find(&value, "content.application/json.schema", &value) == 0) {
+        JsonSlice items;
+        if (find(&value, "items", &items) == 0) {
+            /* Array bodies get no typed call, callers join items serialized with the item's _to_json */
+            if ((operation->body_items = resolve_ref(spec, &items)) < 0) {
+                fprintf(stderr, "openapi_gen: %s: JSON array body items must be a $ref\n", operation->id);
+                return -1;
+            }
+        } else if ((operation->body_schema = resolve_ref(spec, &value)) < 0) {
+            fprintf(stderr, "openapi_gen: %s: JSON request bodies must be a $ref\n", operation->id);
+            return -1;
+        }
+    }
+
+    operation->result_schema = -1;
+    if ((find(body, "responses.200.content.application/json.schema", &value) == 0 ||
+         find(body, "responses.201.content.application/json.schema", &value) == 0) &&
+        (operation->result_schema = resolve_ref(spec, &value)) < 0) {
+        fprintf(stderr, "openapi_gen: %s: JSON responses must be a $ref\n", operation->id);
+        return -1;
+    }
+
+    spec->operation_count++;
+    return 0;
+}
+
+static int parse_operations(Spec *spec, const JsonSlice *root) {
+    JsonSlice paths, key, value;
+    JsonIterator iterator;
+    int rc;
+
+    if (find(root, "paths", &paths) != 0 || json_scan_iter_init(&iterator, &paths) != 0) {
+        fprintf(stderr, "openapi_gen: no paths\n");
+        return -1;
+    }
+    while ((rc = json_scan_iter_next(&iterator, &key, &value)) == JSON_SCAN_FOUND) {
+        char path[256];
+        if (slice_string(&key, path, sizeof(path)) != 0) {
+            return -1;
+        }
+        for (size_t m = 0; m < sizeof(METHODS) / sizeof(METHODS[0]); m++) {
+            JsonSlice body;
+            if (find(&value, METHODS[m], &body) == 0 && parse_operation(spec, path, METHODS[m], &body) != 0) {
+                return -1;
+            }
+        }
+    }
+    return rc == JSON_SCAN_NOT_FOUND ? 0 : -1;
+}
+
+/**
+ * Mark a schema and everything it references as serialized or decoded
+ */
+static int mark_role(Spec *spec, int index, int role) {
+    Schema *schema = &spec->schemas[index];
+    if ((schema->role & role) != 0) {
+        return 0;
+    }
+    schema->role |= role;
+    if (schema->role == (ROLE_REQUEST | ROLE_RESPONSE)) {
+        fprintf(stderr, "openapi_gen: %s is used both as a request body and a response\n", schema->name);
+        return -1;
+    }
+    for (int i = 0; i < schema->field_count; i++) {
+        Field *field = &schema->fields[i];
+        if (role == ROLE_REQUEST && (field->kind == FIELD_ARRAY || field->kind == FIELD_RAW)) {
+            fprintf(stderr, "openapi_gen: %s.%s: arrays and untyped values cannot be sent\n", schema->name,
+                    field->json_name);
+            return -1;
+        }
+        if (field->ref >= 0 && mark_role(spec, field->ref, role) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ---- Emission ---- */
+
+static const char *GENERATED_NOTICE = "/* Generated by tools/openapi_gen.c from %s. Do not edit. */\n\n";
+
+/**
+ * Whether a request field or parameter needs a presence bit (optional
+ * strings are omitted with NULL, required values are always sent)
+ */
+static int needs_presence_bit(FieldKind kind, int required) {
+    return !required && kind != FIELD_STRING;
+}
+
+static void emit_schema_type(FILE *out, Spec *spec, int index) {
+    Schema *schema = &spec->schemas[index];
+    int request = schema->role == ROLE_REQUEST;
+    int presence_bits = 0;
+
+    if (schema->emitted || schema->role == 0) {
+        return;
+    }
+    schema->emitted = 1;
+    for (int i = 0; i < schema->field_count; i++) {
+        if (schema->fields[i].kind == FIELD_OBJECT) {
+            emit_schema_type(out, spec, schema->fields[i].ref);
+        }
+    }
+
+    fprintf(out, "/**\n * %s (%s)\n */\n", schema->name, request ? "request body" : "response");
+    for (int i = 0; i < schema->field_count; i++) {
+        const Field *field = &schema->fields[i];
+        if (!request || needs_presence_bit(field->kind, field->required)) {
+            fprintf(out, "#define %s (UINT64_C(1) << %d)\n", field->macro, i);
+            presence_bits++;
+        }
+    }
+    fprintf(out, "%stypedef struct {\n", presence_bits > 0 ? "\n" : "");
+    if (request) {
+        if (presence_bits > 0) {
+            fprintf(out, "    uint64_t present;   /* %s_HAS_* bits of the optional fields to send */\n",
+                    schema->macro);
+        }
+    } else {
+        fprintf(out, "    uint64_t present;   /* %s_HAS_* bits of the fields received and not null */\n",
+                schema->macro);
+    }
+    for (int i = 0; i < schema->field_count; i++) {
+        const Field *field = &schema->fields[i];
+        char declaration[GEN_NAME_SIZE * 2];
+        const char *note = "";
+
+        switch (field->kind) {
+        case FIELD_STRING:
+            if (request) {
+                snprintf(declaration, sizeof(declaration), "const char *%s;", field->c_name);
+                note = field->required ? "" : ", NULL to omit";
+            } else {
+                /* maxLength counts characters: room for four UTF-8 bytes each */
+                snprintf(declaration, sizeof(declaration), "char %s[%ld];", field->c_name,
+                         field->max_length * 4 + 1);
+            }
+            break;
+        case FIELD_INTEGER:
+            snprintf(declaration, sizeof(declaration), "int64_t %s;", field->c_name);
+            break;
+        case FIELD_NUMBER:
+            snprintf(declaration, sizeof(declaration), "double %s;", field->c_name);
+            break;
+        case FIELD_BOOLEAN:
+            snprintf(declaration, sizeof(declaration), "int %s;", field->c_name);
+            break;
+        case FIELD_OBJECT:
+            snprintf(declaration, sizeof(declaration), "%s %s;", spec->schemas[field->ref].c_type, field->c_name);
+            break;
+        case FIELD_ARRAY:
+            snprintf(declaration, sizeof(declaration), "JsonSlice %s;", field->c_name);
+            note = field->ref >= 0 ? ", items: " : ", array";
+            break;
+        case FIELD_RAW:
+        default:
+            snprintf(declaration, sizeof(declaration), "JsonSlice %s;", field->c_name);
+            note = ", raw value";
+            break;
+        }
+        fprintf(out, "    %-40s /* \"%s\"%s%s%s%s */\n", declaration, field->json_name,
+                field->required ? ", required" : "", note,
+                field->kind == FIELD_ARRAY && field->ref >= 0 ? spec->schemas[field->ref].c_type : "",
+                field->nullable ? ", nullable" : "");
+    }
+    fprintf(out, "} %s;\n\n", schema->c_type);
+
+    if (request) {
+        fprintf(out, "/**\n * Serialize %s to JSON (required strings must not be NULL)\n"
+                     " * @return Length of the JSON text, -1 if a required field is NULL or it does not fit\n */\n"
+                     "int %s_to_json(const %s *in, char *buffer, size_t size);\n\n",
+                schema->name, schema->prefix, schema->c_type);
+    } else {
+        fprintf(out, "/**\n * Decode %s from a value (null counts as absent; array and raw fields point into it)\n"
+                     " * @return 0 on success, -1 if the value is malformed, a field has the wrong type or does\n"
+                     " *         not fit, or a required field is missing\n */\n"
+                     "int %s_decode(const JsonSlice *value, %s *out);\n\n",
+                schema->name, schema->prefix, schema->c_type);
+        fprintf(out, "/**\n * Decode %s from a whole document\n */\n"
+                     "int %s_parse(const char *json, size_t length, %s *out);\n\n",
+                schema->name, schema->prefix, schema->c_type);
+    }
+}
+
+static void emit_params_type(FILE *out, const Operation *operation) {
+    int presence_bits = 0;
+
+    fprintf(out, "/**\n * Query parameters of %s\n */\n", operation->id);
+    for (int i = 0; i < operation->param_count; i++) {
+        const Param *param = &operation->params[i];
+        if (needs_presence_bit(param->kind, param->required)) {
+            fprintf(out, "#define %s (UINT64_C(1) << %d)\n", param->macro, i);
+            presence_bits++;
+        }
+    }
+    fprintf(out, "%stypedef struct {\n", presence_bits > 0 ? "\n" : "");
+    if (presence_bits > 0) {
+        fprintf(out, "    uint64_t present;   /* %s_HAS_* bits of the optional parameters to send */\n",
+                operation->macro);
+    }
+    for (int i = 0; i < operation->param_count; i++) {
+        const Param *param = &operation->params[i];
+        char declaration[GEN_NAME_SIZE * 2];
+        snprintf(declaration, sizeof(declaration), "%s%s;",
+                 param->kind == FIELD_STRING ? "const char *" : param->kind == FIELD_INTEGER ? "int64_t " : "int ",
+                 param->c_name);
+        fprintf(out, "    %-40s /* %s%s */\n", declaration, param->json_name,
+                param->required ? ", required" : param->kind == FIELD_STRING ? ", NULL to omit" : "");
+    }
+    fprintf(out, "} Ohrm%c%sParams;\n\n", toupper((unsigned char)operation->id[0]), operation->id + 1);
+    fprintf(out, "/**\n * Build the URL path and query of %s\n"
+                 " * @return Length written, -1 if a required parameter is missing or it does not fit\n */\n"
+                 "int %s_url(const Ohrm%c%sParams *params, char *url, size_t size);\n\n",
+            operation->id, operation->prefix, toupper((unsigned char)operation->id[0]), operation->id + 1);
+}
+
+static int emit_types_header(FILE *out, Spec *spec, const char *spec_name) {
+    fprintf(out, GENERATED_NOTICE, spec_name);
+    fprintf(out, "#ifndef ORANGEHRM_API_TYPES_H\n#define ORANGEHRM_API_TYPES_H\n\n");
+    fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n#include \"json_scan.h\"\n\n");
+
+    fprintf(out, "/* Endpoints */\n");
+    for (int i = 0; i < spec->operation_count; i++) {
+        const Operation *operation = &spec->operations[i];
+        fprintf(out, "#define %s_PATH \"%s\"\n#define %s_METHOD \"%s\"\n", operation->macro, operation->path,
+                operation->macro, operation->method);
+    }
+    fprintf(out, "\n");
+
+    for (int i = 0; i < spec->schema_count; i++) {
+        emit_schema_type(out, spec, i);
+    }
+    for (int i = 0; i < spec->operation_count; i++) {
+        if (spec->operations[i].param_count > 0) {
+            emit_params_type(out, &spec->operations[i]);
+        }
+    }
+    fprintf(out, "#endif /* ORANGEHRM_API_TYPES_H */\n");
+    return ferror(out) ? -1 : 0;
+}
+
+/**
+ * Whether an operation gets a typed call (JSON object or no request body)
+ */
+static int has_call(const Operation *operation) {
+    return !operation->has_body || operation->body_schema >= 0;
+}
+
+/**
+ * Print "int name(arg, arg, ...)", wrapping arguments at 110 columns
+ */
+static void emit_call_signature(FILE *out, const Spec *spec, const Operation *operation) {
+    char arguments[4][GEN_NAME_SIZE * 2];
+    int count = 0;
+    int column;
+
+    snprintf(arguments[count++], sizeof(arguments[0]), "Config *config");
+    if (operation->param_count > 0) {
+        snprintf(arguments[count++], sizeof(arguments[0]), "const Ohrm%c%sParams *params",
+                 toupper((unsigned char)operation->id[0]), operation->id + 1);
+    }
+    if (operation->body_schema >= 0) {
+        snprintf(arguments[count++], sizeof(arguments[0]), "const %s *body",
+                 spec->schemas[operation->body_schema].c_type);
+    }
+    snprintf(arguments[count++], sizeof(arguments[0]), "ResponseBuffer *resp");
+    if (operation->result_schema >= 0) {
+        snprintf(arguments[count++], sizeof(arguments[0]), "%s *result",
+                 spec->schemas[operation->result_schema].c_type);
+    }
+
+    int indent = fprintf(out, "int %s(", operation->prefix);
+    column = indent;
+    for (int i = 0; i < count; i++) {
+        int length = (int)strlen(arguments[i]) + 2;
+        if (i > 0 && column + 1 + length > 110) {
+            fprintf(out, "\n%*s", indent, "");
+            column = indent;
+        } else if (i > 0) {
+            column += fprintf(out, " ");
+        }
+        column += fprintf(out, "%s%s", arguments[i], i + 1 < count ? "," : ")");
+    }
+}
+
+static int emit_api_header(FILE *out, Spec *spec, const char *spec_name) {
+    fprintf(out, GENERATED_NOTICE, spec_name);
+    fprintf(out, "#ifndef ORANGEHRM_API_H\n#define ORANGEHRM_API_H\n\n");
+    fprintf(out, "#include \"orangehrm_client.h\"\n#include \"orangehrm_api_types.h\"\n\n");
+    fprintf(out, "#define OHRM_BODY_SIZE 4096   /* request bodies are serialized on the stack */\n\n");
+
+    for (int i = 0; i < spec->operation_count; i++) {
+        const Operation *operation = &spec->operations[i];
+        if (!has_call(operation)) {
+            continue;
+        }
+        fprintf(out, "/**\n * %s %s%s%s\n", operation->method, operation->path, operation->summary[0] ? ": " : "",
+                operation->summary);
+        if (operation->param_count > 0) {
+            fprintf(out, " * @param params Query parameters\n");
+        }
+        if (operation->body_schema >= 0) {
+            fprintf(out, " * @param body Request body\n");
+        }
+        fprintf(out, " * @param resp Receives the response body\n");
+        if (operation->result_schema >= 0) {
+            fprintf(out, " * @param result Receives the decoded response (may be NULL; slices point into resp)\n");
+        }
+        fprintf(out, " * @return 0 on success, -1 on failure or an unexpected response\n */\n");
+        emit_call_signature(out, spec, operation);
+        fprintf(out, ";\n\n");
+    }
+    fprintf(out, "#endif /* ORANGEHRM_API_H */\n");
+    return ferror(out) ? -1 : 0;
+}
+
+/* Helpers copied into the generated source (inline, so unused ones do not warn) */
+static const char *RUNTIME =
+    "/* Append length bytes; positions past size mark an overflow */\n"
+    "static inline size_t ohrm_put_raw(char *buffer, size_t pos, size_t size, const char *text, size_t length) {\n"
+    "    if (pos + length <= size) {\n"
+    "        memcpy(buffer + pos, text, length);\n"
+    "    }\n"
+    "    return pos + length;\n"
+    "}\n\n"
+    "/* Append a separator (then switch it to next) and a key */\n"
+    "static inline size_t ohrm_put_key(char *buffer, size_t pos, size_t size, char *separator, char next, const char *key,\n"
+    "                                  size_t length) {\n"
+    "    pos = ohrm_put_raw(buffer, pos, size, separator, 1);\n"
+    "    *separator = next;\n"
+    "    return ohrm_put_raw(buffer, pos, size, key, length);\n"
+    "}\n\n"
+    "static inline size_t ohrm_put_long(char *buffer, size_t pos, size_t size, int64_t value) {\n"
+    "    char digits[24];\n"
+    "    size_t n = sizeof(digits);\n"
+    "    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;\n"
+    "    do {\n"
+    "        digits[--n] = (char)('0' + magnitude % 10);\n"
+    "        magnitude /= 10;\n"
+    "    } while (magnitude > 0);\n"
+    "    if (value < 0) {\n"
+    "        digits[--n] = '-';\n"
+    "    }\n"
+    "    return ohrm_put_raw(buffer, pos, size, digits + n, sizeof(digits) - n);\n"
+    "}\n\n"
+    "static inline size_t ohrm_put_bool(char *buffer, size_t pos, size_t size, int value) {\n"
+    "    return value ? ohrm_put_raw(buffer, pos, size, \"true\", 4) : ohrm_put_raw(buffer, pos, size, \"false\", 5);\n"
+    "}\n\n"
+    "/* Append a quoted, escaped JSON string */\n"
+    "static inline size_t ohrm_put_string(char *buffer, size_t pos, size_t size, const char *value) {\n"
+    "    static const char hex[] = \"0123456789abcdef\";\n"
+    "    const unsigned char *run = (const unsigned char *)value;\n"
+    "    const unsigned char *p = run;\n"
+    "\n"
+    "    pos = ohrm_put_raw(buffer, pos, size, \"\\\"\", 1);\n"
+    "    for (; *p != '\\0'; p++) {\n"
+    "        if (*p >= 0x20 && *p != '\"' && *p != '\\\\') {\n"
+    "            continue;\n"
+    "        }\n"
+    "        pos = ohrm_put_raw(buffer, pos, size, (const char *)run, (size_t)(p - run));\n"
+    "        if (*p == '\"' || *p == '\\\\') {\n"
+    "            char escape[2] = { '\\\\', (char)*p };\n"
+    "            pos = ohrm_put_raw(buffer, pos, size, escape, 2);\n"
+    "        } else {\n"
+    "            char escape[6] = { '\\\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 0x0f] };\n"
+    "            pos = ohrm_put_raw(buffer, pos, size, escape, 6);\n"
+    "        }\n"
+    "        run = p + 1;\n"
+    "    }\n"
+    "    pos = ohrm_put_raw(buffer, pos, size, (const char *)run, (size_t)(p - run));\n"
+    "    return ohrm_put_raw(buffer, pos, size, \"\\\"\", 1);\n"
+    "}\n\n"
+    "/* Append a percent-encoded query value */\n"
+    "static inline size_t ohrm_put_query(char *buffer, size_t pos, size_t size, const char *value) {\n"
+    "    static const char hex[] = \"0123456789ABCDEF\";\n"
+    "    for (const unsigned char *p = (const unsigned char *)value; *p != '\\0'; p++) {\n"
+    "        if (isalnum(*p) || *p == '-' || *p == '.' || *p == '_' || *p == '~') {\n"
+    "            pos = ohrm_put_raw(buffer, pos, size, (const char *)p, 1);\n"
+    "        } else {\n"
+    "            char escape[3] = { '%', hex[*p >> 4], hex[*p & 0x0f] };\n"
+    "            pos = ohrm_put_raw(buffer, pos, size, escape, 3);\n"
+    "        }\n"
+    "    }\n"
+    "    return pos;\n"
+    "}\n\n"
+    "static inline size_t ohrm_put_double(char *buffer, size_t pos, size_t size, double value) {\n"
+    "    char text[32];\n"
+    "    if (!isfinite(value)) {\n"
+    "        return ohrm_put_raw(buffer, pos, size, \"null\", 4);\n"
+    "    }\n"
+    "    return ohrm_put_raw(buffer, pos, size, text, (size_t)snprintf(text, sizeof(text), \"%.17g\", value));\n"
+    "}\n\n"
+    "/* Terminate a serialized text */\n"
+    "static inline int ohrm_finish(char *buffer, size_t pos, size_t size) {\n"
+    "    if (pos >= size) {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    buffer[pos] = '\\0';\n"
+    "    return (int)pos;\n"
+    "}\n\n"
+    "static inline int ohrm_get_long(const JsonSlice *value, int64_t *out) {\n"
+    "    long long number;\n"
+    "    if (json_scan_long(value, &number) != 0) {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    *out = (int64_t)number;\n"
+    "    return 0;\n"
+    "}\n\n"
+    "static inline int ohrm_get_double(const JsonSlice *value, double *out) {\n"
+    "    char text[64];\n"
+    "    char *end;\n"
+    "    if (value->type != JSON_SCAN_NUMBER || value->length >= sizeof(text)) {\n"
+    "        return -1;\n"
+    "    }\n"
+    "    memcpy(text, value->ptr, value->length);\n"
+    "    text[value->length] = '\\0';\n"
+    "    *out = strtod(text, &end);\n"
+    "    return *end == '\\0' ? 0 : -1;\n"
+    "}\n\n"
+    "static inline int ohrm_get_string(const JsonSlice *value, char *buffer, size_t size) {\n"
+    "    return json_scan_string(value, buffer, size) < 0 ? -1 : 0;\n"
+    "}\n\n";
+
+/**
+ * Statements decoding the current member (in "field") into out->name
+ */
+static void emit_decode_statement(FILE *out, const Spec *spec, const Field *field, const char *indent) {
+    switch (field->kind) {
+    case FIELD_STRING:
+        fprintf(out, "%sif (ohrm_get_string(&field, out->%s, sizeof(out->%s)) != 0) {\n", indent, field->c_name,
+                field->c_name);
+        break;
+    case FIELD_INTEGER:
+        fprintf(out, "%sif (ohrm_get_long(&field, &out->%s) != 0) {\n", indent, field->c_name);
+        break;
+    case FIELD_NUMBER:
+        fprintf(out, "%sif (ohrm_get_double(&field, &out->%s) != 0) {\n", indent, field->c_name);
+        break;
+    case FIELD_BOOLEAN:
+        fprintf(out, "%sif (json_scan_bool(&field, &out->%s) != 0) {\n", indent, field->c_name);
+        break;
+    case FIELD_OBJECT:
+        fprintf(out, "%sif (%s_decode(&field, &out->%s) != 0) {\n", indent, spec->schemas[field->ref].prefix,
+                field->c_name);
+        break;
+    case FIELD_ARRAY:
+        fprintf(out, "%sif (field.type != JSON_SCAN_ARRAY) {\n", indent);
+        break;
+    case FIELD_RAW:
+    default:
+        break;  /* Any value is accepted */
+    }
+    if (field->kind != FIELD_RAW) {
+        fprintf(out, "%s    return -1;\n%s}\n", indent, indent);
+    }
+    if (field->kind == FIELD_ARRAY || field->kind == FIELD_RAW) {
+        fprintf(out, "%sout->%s = field;\n", indent, field->c_name);
+    }
+    fprintf(out, "%sout->present |= %s;\n", indent, field->macro);
+}
+
+static void emit_decoder(FILE *out, const Spec *spec, const Schema *schema) {
+    unsigned long long required = 0;
+
+    fprintf(out, "int %s_decode(const JsonSlice *value, %s *out) {\n", schema->prefix, schema->c_type);
+    fprintf(out, "    JsonIterator iterator;\n    JsonSlice key, field;\n    int rc;\n\n");
+    fprintf(out, "    memset(out, 0, sizeof(*out));\n");
+    fprintf(out, "    if (value->type != JSON_SCAN_OBJECT || json_scan_iter_init(&iterator, value) != 0) {\n"
+                 "        return -1;\n    }\n");
+    fprintf(out, "    while ((rc = json_scan_iter_next(&iterator, &key, &field)) == JSON_SCAN_FOUND) {\n");
+    fprintf(out, "        if (field.type == JSON_SCAN_NULL) {\n            continue;\n        }\n");
+    fprintf(out, "        switch (key.length) {\n");
+
+    /* One case per key length, then compare the few keys of that length */
+    for (int i = 0; i < schema->field_count; i++) {
+        size_t length = strlen(schema->fields[i].json_name);
+        int first_of_length = 1;
+        for (int j = 0; j < i; j++) {
+            if (strlen(schema->fields[j].json_name) == length) {
+                first_of_length = 0;
+            }
+        }
+        if (!first_of_length) {
+            continue;
+        }
+
+        fprintf(out, "        case %zu:\n", length);
+        int branch = 0;
+        for (int j = i; j < schema->field_count; j++) {
+            const Field *field = &schema->fields[j];
+            if (strlen(field->json_name) != length) {
+                continue;
+            }
+            fprintf(out, "            %sif (memcmp(key.ptr, \"%s\", %zu) == 0) {\n", branch++ ? "} else " : "",
+                    field->json_name, length);
+            emit_decode_statement(out, spec, field, "                ");
+        }
+        fprintf(out, "            }\n            break;\n");
+    }
+    fprintf(out, "        default:\n            break;\n        }\n    }\n");
+
+    for (int i = 0; i < schema->field_count; i++) {
+        if (schema->fields[i].required) {
+            required |= 1ULL << i;
+        }
+    }
+    fprintf(out, "    if (rc != JSON_SCAN_NOT_FOUND) {\n        return -1;\n    }\n");
+    if (required != 0) {
+        fprintf(out, "    if ((out->present & UINT64_C(0x%llx)) != UINT64_C(0x%llx)) {\n"
+                     "        return -1;  /* Required field missing */\n    }\n", required, required);
+    }
+    fprintf(out, "    return 0;\n}\n\n");
+
+    fprintf(out, "int %s_parse(const char *json, size_t length, %s *out) {\n", schema->prefix, schema->c_type);
+    fprintf(out, "    JsonSlice value;\n\n");
+    fprintf(out, "    if (json == NULL || json_scan_find(json, length, \"\", &value) != JSON_SCAN_FOUND) {\n");
+    fprintf(out, "        memset(out, 0, sizeof(*out));\n        return -1;\n    }\n");
+    fprintf(out, "    return %s_decode(&value, out);\n}\n\n", schema->prefix);
+}
+
+/**
+ * Append one value (fields of a request struct, or parameters)
+ */
+static void emit_put_value(FILE *out, FieldKind kind, const char *expression, int query, const char *ref_prefix) {
+    switch (kind) {
+    case FIELD_STRING:
+        fprintf(out, "pos = %s(buffer, pos, size, %s);\n", query ? "ohrm_put_query" : "ohrm_put_string", expression);
+        break;
+    case FIELD_INTEGER:
+        fprintf(out, "pos = ohrm_put_long(buffer, pos, size, %s);\n", expression);
+        break;
+    case FIELD_NUMBER:
+        fprintf(out, "pos = ohrm_put_double(buffer, pos, size, %s);\n", expression);
+        break;
+    case FIELD_BOOLEAN:
+        fprintf(out, "pos = ohrm_put_bool(buffer, pos, size, %s);\n", expression);
+        break;
+    case FIELD_OBJECT:
+    default:
+        fprintf(out, "pos = %s_put(&%s, buffer, pos, size);\n", ref_prefix, expression);
+        break;
+    }
+}
+
+static void emit_serializer(FILE *out, const Spec *spec, const Schema *schema) {
+    fprintf(out, "static size_t %s_put(const %s *in, char *buffer, size_t pos, size_t size) {\n", schema->prefix,
+            schema->c_type);
+    fprintf(out, "    char separator = '{';\n\n");
+    for (int i = 0; i < schema->field_count; i++) {
+        const Field *field = &schema->fields[i];
+        char expression[GEN_NAME_SIZE + 8];
+        const char *indent = "    ";
+        size_t key_length = strlen(field->json_name) + 3;
+
+        snprintf(expression, sizeof(expression), "in->%s", field->c_name);
+        if (field->kind == FIELD_STRING && field->required) {
+            fprintf(out, "    if (in->%s == NULL) {\n        return size + 1;\n    }\n", field->c_name);
+        } else if (field->kind == FIELD_STRING) {
+            fprintf(out, "    if (in->%s != NULL) {\n", field->c_name);
+            indent = "        ";
+        } else if (!field->required) {
+            fprintf(out, "    if (in->present & %s) {\n", field->macro);
+            indent = "        ";
+        }
+        fprintf(out, "%spos = ohrm_put_key(buffer, pos, size, &separator, ',', \"\\\"%s\\\":\", %zu);\n", indent,
+                field->json_name, key_length);
+        fprintf(out, "%s", indent);
+        emit_put_value(out, field->kind, expression, 0,
+                       field->kind == FIELD_OBJECT ? spec->schemas[field->ref].prefix : NULL);
+        if (indent[4] == ' ') {
+            fprintf(out, "    }\n");
+        }
+    }
+    fprintf(out, "    if (separator == '{') {\n        pos = ohrm_put_raw(buffer, pos, size, \"{\", 1);\n    }\n");
+    fprintf(out, "    return ohrm_put_raw(buffer, pos, size, \"}\", 1);\n}\n\n");
+
+    fprintf(out, "int %s_to_json(const %s *in, char *buffer, size_t size) {\n", schema->prefix, schema->c_type);
+    fprintf(out, "    return ohrm_finish(buffer, %s_put(in, buffer, 0, size), size);\n}\n\n", schema->prefix);
+}
+
+static void emit_url_builder(FILE *out, const Operation *operation) {
+    int any_required = 0;
+
+    fprintf(out, "int %s_url(const Ohrm%c%sParams *params, char *buffer, size_t size) {\n", operation->prefix,
+            toupper((unsigned char)operation->id[0]), operation->id + 1);
+    fprintf(out, "    size_t pos = ohrm_put_raw(buffer, 0, size, %s_PATH, sizeof(%s_PATH) - 1);\n",
+            operation->macro, operation->macro);
+    fprintf(out, "    char separator = '?';\n\n");
+    for (int i = 0; i < operation->param_count; i++) {
+        any_required |= operation->params[i].required;
+    }
+    fprintf(out, "    if (params == NULL) {\n        return %s;\n    }\n",
+            any_required ? "-1" : "ohrm_finish(buffer, pos, size)");
+
+    for (int i = 0; i < operation->param_count; i++) {
+        const Param *param = &operation->params[i];
+        char expression[GEN_NAME_SIZE + 16];
+        const char *indent = "    ";
+        size_t key_length = strlen(param->json_name) + 1;
+
+        snprintf(expression, sizeof(expression), "params->%s", param->c_name);
+        if (param->kind == FIELD_STRING && param->required) {
+            fprintf(out, "    if (params->%s == NULL) {\n        return -1;\n    }\n", param->c_name);
+        } else if (param->kind == FIELD_STRING) {
+            fprintf(out, "    if (params->%s != NULL) {\n", param->c_name);
+            indent = "        ";
+        } else if (!param->required) {
+            fprintf(out, "    if (params->present & %s) {\n", param->macro);
+            indent = "        ";
+        }
+        fprintf(out, "%spos = ohrm_put_key(buffer, pos, size, &separator, '&', \"%s=\", %zu);\n", indent,
+                param->json_name, key_length);
+        fprintf(out, "%s", indent);
+        if (param->kind == FIELD_BOOLEAN) {
+            fprintf(out, "pos = ohrm_put_bool(buffer, pos, size, %s);\n", expression);
+        } else {
+            emit_put_value(out, param->kind, expression, 1, NULL);
+        }
+        if (indent[4] == ' ') {
+            fprintf(out, "    }\n");
+        }
+    }
+    fprintf(out, "    return ohrm_finish(buffer, pos, size);\n}\n\n");
+}
+
+static void emit_call(FILE *out, const Spec *spec, const Operation *operation) {
+    emit_call_signature(out, spec, operation);
+    fprintf(out, " {\n");
+    if (operation->param_count > 0) {
+        fprintf(out, "    char url[MAX_URL_SIZE];\n");
+    }
+    if (operation->body_schema >= 0) {
+        fprintf(out, "    char json[OHRM_BODY_SIZE];\n");
+    }
+    fprintf(out, "\n");
+    if (operation->param_count > 0) {
+        fprintf(out, "    if (%s_url(params, url, sizeof(url)) < 0) {\n"
+                     "        fprintf(stderr, \"Invalid or too long %s parameters\\n\");\n"
+                     "        return -1;\n    }\n", operation->prefix, operation->id);
+    }
+    if (operation->body_schema >= 0) {
+        fprintf(out, "    if (%s_to_json(body, json, sizeof(json)) < 0) {\n"
+                     "        fprintf(stderr, \"Invalid or too large %s body\\n\");\n"
+                     "        return -1;\n    }\n", spec->schemas[operation->body_schema].prefix, operation->id);
+    }
+    if (operation->param_count > 0) {
+        fprintf(out, "    if (api_request(url, %s_METHOD, %s, config, resp) != 0) {\n", operation->macro,
+                operation->body_schema >= 0 ? "json" : "NULL");
+    } else {
+        fprintf(out, "    if (api_request(%s_PATH, %s_METHOD, %s, config, resp) != 0) {\n", operation->macro,
+                operation->macro, operation->body_schema >= 0 ? "json" : "NULL");
+    }
+    fprintf(out, "        return -1;\n    }\n");
+    if (operation->result_schema >= 0) {
+        fprintf(out, "    if (result != NULL && %s_parse(resp->buffer, resp->size, result) != 0) {\n"
+                     "        fprintf(stderr, \"Unexpected %s response\\n\");\n"
+                     "        return -1;\n    }\n", spec->schemas[operation->result_schema].prefix, operation->id);
+    }
+    fprintf(out, "    return 0;\n}\n\n");
+}
+
+static int emit_source(FILE *out, Spec *spec, const char *spec_name) {
+    fprintf(out, GENERATED_NOTICE, spec_name);
+    fprintf(out, "#include \"orangehrm_api.h\"\n#include <ctype.h>\n#include <math.h>\n\n");
+    fprintf(out, "%s", RUNTIME);
+
+    /* Nested serializers call each other, so declare them all first */
+    for (int i = 0; i < spec->schema_count; i++) {
+        const Schema *schema = &spec->schemas[i];
+        if (schema->role == ROLE_REQUEST) {
+            fprintf(out, "static size_t %s_put(const %s *in, char *buffer, size_t pos, size_t size);\n",
+                    schema->prefix, schema->c_type);
+        }
+    }
+    fprintf(out, "\n");
+
+    for (int i = 0; i < spec->schema_count; i++) {
+        const Schema *schema = &spec->schemas[i];
+        if (schema->role == ROLE_REQUEST) {
+            emit_serializer(out, spec, schema);
+        } else if (schema->role == ROLE_RESPONSE) {
+            emit_decoder(out, spec, schema);
+        }
+    }
+    for (int i = 0; i < spec->operation_count; i++) {
+        const Operation *operation = &spec->operations[i];
+        if (operation->param_count > 0) {
+            emit_url_builder(out, operation);
+        }
+        if (has_call(operation)) {
+            emit_call(out, spec, operation);
+        }
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+/* ---- Driver ---- */
+
+static char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    char *text = NULL;
+    long size;
+
+    if (file == NULL) {
+        perror("openapi_gen: failed to open spec");
+        return NULL;
+    }
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0 &&
+        (text = (char *)malloc((size_t)size + 1)) != NULL) {
+        *length = fread(text, 1, (size_t)size, file);
+        text[*length] = '\0';
+    }
+    fclose(file);
+    return text;
+}
+
+typedef int (*EmitFn)(FILE *out, Spec *spec, const char *spec_name);
+
+/**
+ * Write one output through a temporary file, so an interrupted build never
+ * leaves a truncated file that looks up to date
+ */
+static int write_output(const char *directory, const char *name, EmitFn emit, Spec *spec, const char *spec_name) {
+    char path[1024];
+    char tmp_path[1100];
+
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        perror("openapi_gen: failed to create output");
+        return -1;
+    }
+    int result = emit(out, spec, spec_name);
+    if (fclose(out) != 0 || result != 0 || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "openapi_gen: failed to write %s\n", path);
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static Spec spec;
+    char *texts[GEN_MAX_DOCUMENTS];
+    JsonSlice roots[GEN_MAX_DOCUMENTS];
+    char spec_name[512];
+    int count = argc - 2;
+    int ok = 1;
+
+    if (argc < 3 || count > GEN_MAX_DOCUMENTS) {
+        fprintf(stderr, "Usage: %s SPEC [OVERLAY...] OUTDIR\n", argv[0]);
+        return 1;
+    }
+
+    /* Slices point into the texts, so all documents stay loaded until the end */
+    spec_name[0] = '\0';
+    for (int d = 0; d < count; d++) {
+        const char *path = argv[1 + d];
+        size_t length = 0;
+        const char *base = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+
+        texts[d] = ok ? read_file(path, &length) : NULL;
+        if (texts[d] == NULL) {
+            ok = 0;
+            continue;
+        }
+        if (json_scan_find(texts[d], length, "", &roots[d]) != JSON_SCAN_FOUND || roots[d].type != JSON_SCAN_OBJECT) {
+            fprintf(stderr, "openapi_gen: %s is not a JSON object\n", path);
+            ok = 0;
+            continue;
+        }
+        size_t used = strlen(spec_name);
+        snprintf(spec_name + used, sizeof(spec_name) - used, "%s%s", d == 0 ? "" : " + ", base);
+    }
+
+    for (int d = 0; ok && d < count; d++) {
+        ok = collect_schemas(&spec, &roots[d], d == 0) == 0;
+    }
+    ok = ok && parse_schemas(&spec) == 0;
+    for (int d = 0; ok && d < count; d++) {
+        ok = parse_operations(&spec, &roots[d]) == 0;
+    }
+    for (int i = 0; ok && i < spec.operation_count; i++) {
+        const Operation *operation = &spec.operations[i];
+        ok = (operation->body_schema < 0 || mark_role(&spec, operation->body_schema, ROLE_REQUEST) == 0) &&
+             (operation->body_items < 0 || mark_role(&spec, operation->body_items, ROLE_REQUEST) == 0) &&
+             (operation->result_schema < 0 || mark_role(&spec, operation->result_schema, ROLE_RESPONSE) == 0);
+    }
+
+    const char *outdir = argv[argc - 1];
+    ok = ok && write_output(outdir, "orangehrm_api_types.h", emit_types_header, &spec, spec_name) == 0 &&
+         write_output(outdir, "orangehrm_api.h", emit_api_header, &spec, spec_name) == 0 &&
+         write_output(outdir, "orangehrm_api.c", emit_source, &spec, spec_name) == 0;
+
+    for (int d = 0; d < count; d++) {
+        free(texts[d]);
+    }
+    return ok ? 0 : 1;
+}
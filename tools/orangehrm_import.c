@@ -0,0 +1,105 @@
+#include "orangehrm_client.h"
+#include "attendance_import.h"
+#include "token_holder.h"
+#include "token_cache.h"
+
+/**
+ * Bulk attendance import:
+ * orangehrm_import <file.csv|-> [--workers N] [--queue N] [--dry-run] [--store DIR]
+ *                  [--batch N] [--batch-delay-ms N] [--batch-connections N] [--bulk]
+ */
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s <file.csv|-> [--workers N] [--queue N] [--dry-run] [--store DIR]\n"
+                    "       [--batch N] [--batch-delay-ms N] [--batch-connections N] [--bulk]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    ImportOptions options;
+    ImportReport report;
+    Config config;
+    TokenHolder holder;
+    AttendanceStore store;
+    const char *store_dir = NULL;
+
+    memset(&options, 0, sizeof(options));
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.submit_workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+            options.queue_capacity = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            options.dry_run = 1;
+        } else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            store_dir = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options.batch_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-delay-ms") == 0 && i + 1 < argc) {
+            options.batch_delay_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-connections") == 0 && i + 1 < argc) {
+            options.batch_connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bulk") == 0) {
+            options.batch_bulk = 1;
+        } else if (options.csv_path == NULL) {
+            options.csv_path = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (options.csv_path == NULL) {
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (orangehrm_client_init() != 0) {
+        fprintf(stderr, "Failed to initialize OrangeHRM client\n");
+        return -1;
+    }
+
+    if (load_config(&config) != 0) {
+        fprintf(stderr, "Failed to load configuration. Please check config.json\n");
+        orangehrm_client_cleanup();
+        return -1;
+    }
+    if (orangehrm_set_default_transport_options(&config.transport_options) != 0) {
+        fprintf(stderr, "Keeping the default transport options\n");
+    }
+    if (config.memory_budget_kb > 0) {
+        mem_budget_set((size_t)config.memory_budget_kb * 1024, MEM_DEFAULT_BUDGET_WAIT_MS);
+    }
+    request_lanes_configure(&config.lanes);
+    token_cache_open(&config);
+
+    /* All submit workers share one token instead of fetching one each */
+    memset(&holder, 0, sizeof(holder));
+    if (!options.dry_run && token_holder_start(&holder, &config) == 0) {
+        config.token_holder = &holder;
+    }
+
+    /* Accepted records are also kept in the local attendance store */
+    if (store_dir != NULL) {
+        if (attendance_store_open(&store, store_dir) != 0) {
+            token_holder_stop(&holder);
+            token_cache_close();
+            config_free(&config);
+            orangehrm_client_cleanup();
+            return -1;
+        }
+        options.store = &store;
+    }
+
+    int result = attendance_import_run(&options, &config, &report);
+    attendance_import_print_report(&report, stdout);
+
+    if (options.store != NULL) {
+        attendance_store_sync(&store);
+        attendance_store_close(&store);
+    }
+
+    token_holder_stop(&holder);
+    token_cache_close();
+    config_free(&config);
+    orangehrm_client_cleanup();
+    return result;
+}
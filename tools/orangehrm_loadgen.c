@@ -0,0 +1,591 @@
+#include "orangehrm_client.h"
+#include "orangehrm_api.h"
+#include "attendance_record.h"
+#include "attendance_batch.h"
+#include "bounded_queue.h"
+#include "token_holder.h"
+#include "standin_server.h"
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+ * Shift-change load generator:
+ * orangehrm_loadgen [--employees N] [--window S] [--curve uniform|ramp|burst] [--workers N]
+ *                   [--interval S] [--latency-ms N] [--error-rate P] [--config FILE] [--seed N]
+ *                   [--timeout-ms N] [--max-host-connections N] [--connection-pool-size N]
+ *                   [--memory-budget-kb N]
+ *                   [--batch N] [--batch-delay-ms N] [--batch-connections N] [--bulk]
+ *                   [--background N] [--max-in-flight N] [--interactive-reserved N]
+ *
+ * Simulates N virtual employees punching out over a window of S seconds,
+ * each running the client's submit flow (shared token, record formatting,
+ * attendance POST, response check) on a pool of worker threads. Punch-outs
+ * arrive by the chosen curve:
+ *   uniform  evenly spread over the window
+ *   ramp     rising linearly towards the end of the window
+ *   burst    concentrated around the middle (the whole shift leaving at once)
+ *
+ * Requests go to an in-process stand-in server with the given service time
+ * and error rate, or to the server of --config. Latency is measured from the
+ * scheduled punch-out, so it includes time spent waiting for a free worker.
+ * --seed fixes the arrival times and the stand-in server's error draws.
+ * Throughput, errors and latency percentiles are reported per interval and
+ * for the whole run. --timeout-ms, --max-host-connections and
+ * --connection-pool-size override the request deadline, per-host connection
+ * limit and connection pool size of the transport, and the stand-in server
+ * reports how many connections the requests needed;
+ * --memory-budget-kb caps tracked client memory, and the peak per subsystem
+ * is reported at the end. --batch routes submissions through an attendance
+ * batcher of that batch size (see attendance_batch.h), with --bulk
+ * sending each batch as one request to the bulk endpoint extension (the
+ * stand-in server implements it) instead of one request per record.
+ * --background runs that many threads of back-to-back bulk-lane employee
+ * list requests (a nightly sync) during the run, and --max-in-flight and
+ * --interactive-reserved set the request lanes (see request_lanes.h); the
+ * punches are interactive, so their latency shows whether the lanes hold.
+ */
+
+#define LOADGEN_DEFAULT_EMPLOYEES 2000
+#define LOADGEN_DEFAULT_WINDOW_S 60.0
+#define LOADGEN_DEFAULT_WORKERS 16
+#define LOADGEN_DEFAULT_LATENCY_MS 20
+#define LOADGEN_FIRST_EMP_NUMBER 1000
+#define LOADGEN_SHIFT_S (8 * 3600)
+#define LOADGEN_TOKEN_WAIT_MS 10000
+
+typedef enum {
+    CURVE_UNIFORM = 0,
+    CURVE_RAMP,
+    CURVE_BURST
+} ArrivalCurve;
+
+static const char *CURVE_NAMES[] = { "uniform", "ramp", "burst" };
+
+/**
+ * One virtual employee's punch out
+ */
+typedef struct {
+    unsigned long long arrival_ns;  /* scheduled punch out, from the start of the run */
+    unsigned long long done_ns;     /* submission finished, from the start of the run */
+    unsigned int service_us;        /* time spent in the submit flow itself */
+    int emp_number;
+    int ok;
+} VirtualPunch;
+
+typedef struct {
+    Config *config;
+    AttendanceBatcher *batcher;     /* NULL posts each record itself */
+    BoundedQueue *queue;
+    unsigned long long start_ns;
+} LoadWorker;
+
+/**
+ * Bulk-lane load running beside the punches
+ */
+typedef struct {
+    Config *config;
+    atomic_int stop;
+    atomic_ullong requests;
+} BackgroundLoad;
+
+typedef struct {
+    unsigned long long bucket;
+    unsigned int latency_us;
+    int ok;
+} LatencySample;
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void sleep_until_ns(unsigned long long when) {
+    struct timespec deadline;
+    deadline.tv_sec = (time_t)(when / 1000000000ULL);
+    deadline.tv_nsec = (long)(when % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--employees N] [--window S] [--curve uniform|ramp|burst] [--workers N]\n"
+                    "       [--interval S] [--latency-ms N] [--error-rate P] [--config FILE] [--seed N]\n"
+                    "       [--timeout-ms N] [--max-host-connections N] [--connection-pool-size N]\n"
+                    "       [--memory-budget-kb N]\n"
+                    "       [--batch N] [--batch-delay-ms N] [--batch-connections N] [--bulk]\n"
+                    "       [--background N] [--max-in-flight N] [--interactive-reserved N]\n",
+            program);
+}
+
+static double uniform01(unsigned int *seed) {
+    return ((double)rand_r(seed) + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+/**
+ * Offset of one arrival in the window (0..1) for the curve
+ */
+static double arrival_fraction(ArrivalCurve curve, unsigned int *seed) {
+    switch (curve) {
+    case CURVE_RAMP:
+        return sqrt(uniform01(seed));  /* density grows linearly */
+    case CURVE_BURST: {
+        /* Normal around the middle (sd 1/8 of the window), clamped to it */
+        double normal = sqrt(-2.0 * log(uniform01(seed))) * cos(2.0 * M_PI * uniform01(seed));
+        double fraction = 0.5 + normal / 8.0;
+        return fraction < 0.0 ? 0.0 : fraction > 1.0 ? 1.0 : fraction;
+    }
+    case CURVE_UNIFORM:
+    default:
+        return uniform01(seed);
+    }
+}
+
+static int compare_arrival(const void *a, const void *b) {
+    const VirtualPunch *x = (const VirtualPunch *)a;
+    const VirtualPunch *y = (const VirtualPunch *)b;
+    return (x->arrival_ns > y->arrival_ns) - (x->arrival_ns < y->arrival_ns);
+}
+
+static int compare_sample(const void *a, const void *b) {
+    const LatencySample *x = (const LatencySample *)a;
+    const LatencySample *y = (const LatencySample *)b;
+    if (x->bucket != y->bucket) {
+        return (x->bucket > y->bucket) - (x->bucket < y->bucket);
+    }
+    return (x->latency_us > y->latency_us) - (x->latency_us < y->latency_us);
+}
+
+/**
+ * Wait for a record queued on the batcher
+ */
+static int submit_batched(AttendanceBatcher *batcher, const char *json) {
+    Future *future = attendance_batcher_submit(batcher, json);
+    if (future == NULL) {
+        return -1;
+    }
+    future_wait_for(future, -1);
+    int result = future_result(future);
+    future_release(future);
+    return result;
+}
+
+/**
+ * Run the submit flow of main.c for one virtual employee
+ */
+static int submit_punch(Config *config, AttendanceBatcher *batcher, TimeFormatCache *cache, ResponseBuffer *resp,
+                        const VirtualPunch *punch) {
+    AttendanceRecord record;
+    FormattedPunch in, out;
+    char json[ATTENDANCE_JSON_SIZE];
+
+    memset(&record, 0, sizeof(record));
+    snprintf(record.emp_number, sizeof(record.emp_number), "%d", punch->emp_number);
+    record.punch_out = time(NULL);
+    record.punch_in = record.punch_out - LOADGEN_SHIFT_S;
+    snprintf(record.punch_in_note, sizeof(record.punch_in_note), "%s", "App In");
+    snprintf(record.punch_out_note, sizeof(record.punch_out_note), "%s", "App out");
+
+    format_punch_time(cache, record.punch_in, &in);
+    format_punch_time(cache, record.punch_out, &out);
+    if (attendance_record_to_json(&record, &in, &out, json, sizeof(json)) < 0) {
+        return -1;
+    }
+    if (batcher != NULL) {
+        return submit_batched(batcher, json);
+    }
+    if (token_holder_wait(config->token_holder, LOADGEN_TOKEN_WAIT_MS) != 0 ||
+        post_request(ATTENDANCE_RECORDS_URL, json, config, resp) != 0) {
+        return -1;
+    }
+    return attendance_response_status(resp->buffer, resp->size) == ATTENDANCE_ACCEPTED ? 0 : -1;
+}
+
+static void *load_worker(void *data) {
+    LoadWorker *worker = (LoadWorker *)data;
+    Config config = *worker->config;
+    TimeFormatCache cache;
+    ResponseBuffer resp;
+    VirtualPunch *punch;
+
+    time_format_cache_init(&cache);
+    int ready = response_buffer_init(&resp, MAX_RESPONSE_SIZE) == 0;
+
+    /* A worker without a buffer still drains its share as failures */
+    while ((punch = (VirtualPunch *)bounded_queue_pop(worker->queue, NULL)) != NULL) {
+        unsigned long long started = monotonic_ns();
+        punch->ok = ready && submit_punch(&config, worker->batcher, &cache, &resp, punch) == 0;
+        unsigned long long finished = monotonic_ns();
+        punch->service_us = (unsigned int)((finished - started) / 1000ULL);
+        punch->done_ns = finished - worker->start_ns;
+    }
+
+    if (ready) {
+        response_buffer_free(&resp);
+    }
+    return NULL;
+}
+
+/**
+ * Page through the employee list on the bulk lane until the run ends
+ */
+static void *background_worker(void *data) {
+    BackgroundLoad *load = (BackgroundLoad *)data;
+    Config config = *load->config;
+    OhrmListEmployeesParams params;
+    ResponseBuffer resp;
+
+    config.priority = REQUEST_PRIORITY_BULK;
+    memset(&params, 0, sizeof(params));
+    params.limit = 100;
+    if (response_buffer_init(&resp, MAX_RESPONSE_SIZE) != 0) {
+        return NULL;
+    }
+    while (!atomic_load(&load->stop)) {
+        ohrm_list_employees(&config, &params, &resp, NULL);
+        atomic_fetch_add(&load->requests, 1);
+    }
+    response_buffer_free(&resp);
+    return NULL;
+}
+
+static unsigned int percentile(const LatencySample *sorted, size_t count, double p) {
+    size_t rank = (size_t)ceil(p * (double)count);
+    return sorted[rank > 0 ? rank - 1 : 0].latency_us;
+}
+
+/**
+ * Print throughput, errors and latency percentiles per interval of completion
+ * time, then for the whole run
+ */
+static void report(const VirtualPunch *punches, size_t count, double interval_s, double elapsed_s,
+                   unsigned long long service_us_total) {
+    unsigned long long interval_ns = (unsigned long long)(interval_s * 1e9);
+    LatencySample *samples = (LatencySample *)malloc(count * sizeof(LatencySample));
+    size_t errors = 0;
+
+    if (samples == NULL) {
+        fprintf(stderr, "Failed to allocate latency samples\n");
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        samples[i].bucket = punches[i].done_ns / interval_ns;
+        samples[i].latency_us = (unsigned int)((punches[i].done_ns - punches[i].arrival_ns) / 1000ULL);
+        samples[i].ok = punches[i].ok;
+        errors += !punches[i].ok;
+    }
+    qsort(samples, count, sizeof(LatencySample), compare_sample);
+
+    printf("%8s %8s %10s %8s %10s %10s %10s %10s\n", "t_s", "done", "per_s", "errors", "p50_ms", "p95_ms",
+           "p99_ms", "max_ms");
+    for (size_t start = 0; start < count;) {
+        size_t end = start;
+        size_t bucket_errors = 0;
+        while (end < count && samples[end].bucket == samples[start].bucket) {
+            bucket_errors += !samples[end].ok;
+            end++;
+        }
+        size_t n = end - start;
+        printf("%8.1f %8zu %10.1f %8zu %10.1f %10.1f %10.1f %10.1f\n",
+               (double)samples[start].bucket * interval_s, n, (double)n / interval_s, bucket_errors,
+               percentile(samples + start, n, 0.50) / 1000.0, percentile(samples + start, n, 0.95) / 1000.0,
+               percentile(samples + start, n, 0.99) / 1000.0, samples[end - 1].latency_us / 1000.0);
+        start = end;
+    }
+
+    /* Whole run */
+    for (size_t i = 0; i < count; i++) {
+        samples[i].bucket = 0;
+    }
+    qsort(samples, count, sizeof(LatencySample), compare_sample);
+    printf("\n%zu punches in %.2f s: %.1f per s, %zu errors (%.2f%%)\n", count, elapsed_s,
+           (double)count / elapsed_s, errors, 100.0 * (double)errors / (double)count);
+    printf("latency ms: p50 %.1f  p95 %.1f  p99 %.1f  max %.1f  (mean service %.1f)\n",
+           percentile(samples, count, 0.50) / 1000.0, percentile(samples, count, 0.95) / 1000.0,
+           percentile(samples, count, 0.99) / 1000.0, samples[count - 1].latency_us / 1000.0,
+           (double)service_us_total / (double)count / 1000.0);
+    free(samples);
+}
+
+int main(int argc, char *argv[]) {
+    long employees = LOADGEN_DEFAULT_EMPLOYEES;
+    double window_s = LOADGEN_DEFAULT_WINDOW_S;
+    double interval_s = 1.0;
+    double error_rate = 0.0;
+    int workers = LOADGEN_DEFAULT_WORKERS;
+    int latency_ms = LOADGEN_DEFAULT_LATENCY_MS;
+    long timeout_ms = 0;
+    int max_host_connections = 0;
+    int connection_pool_size = 0;
+    long memory_budget_kb = 0;
+    int lanes_max_in_flight = 0;
+    int lanes_reserved = 0;
+    BatchOptions batch_options;
+    AttendanceBatcher *batcher = NULL;
+    int background = 0;
+    pthread_t *background_threads = NULL;
+    int background_started = 0;
+    BackgroundLoad background_load;
+    unsigned int seed = 1;
+    ArrivalCurve curve = CURVE_UNIFORM;
+    const char *config_path = NULL;
+    StandinServer *server = NULL;
+    VirtualPunch *punches = NULL;
+    pthread_t *threads = NULL;
+    LoadWorker worker;
+    BoundedQueue queue;
+    TokenHolder holder;
+    Config config;
+    char base_url[64];
+    int started = 0;
+    int result = -1;
+
+    memset(&batch_options, 0, sizeof(batch_options));
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--employees") == 0 && i + 1 < argc) {
+            employees = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--curve") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            curve = (ArrivalCurve)-1;
+            for (int c = 0; c < (int)(sizeof(CURVE_NAMES) / sizeof(CURVE_NAMES[0])); c++) {
+                if (strcmp(name, CURVE_NAMES[c]) == 0) {
+                    curve = (ArrivalCurve)c;
+                }
+            }
+            if ((int)curve < 0) {
+                print_usage(argv[0]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--latency-ms") == 0 && i + 1 < argc) {
+            latency_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--error-rate") == 0 && i + 1 < argc) {
+            error_rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--timeout-ms") == 0 && i + 1 < argc) {
+            timeout_ms = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--max-host-connections") == 0 && i + 1 < argc) {
+            max_host_connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--connection-pool-size") == 0 && i + 1 < argc) {
+            connection_pool_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--memory-budget-kb") == 0 && i + 1 < argc) {
+            memory_budget_kb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_options.max_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-delay-ms") == 0 && i + 1 < argc) {
+            batch_options.max_delay_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch-connections") == 0 && i + 1 < argc) {
+            batch_options.connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bulk") == 0) {
+            batch_options.bulk = 1;
+        } else if (strcmp(argv[i], "--background") == 0 && i + 1 < argc) {
+            background = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-in-flight") == 0 && i + 1 < argc) {
+            lanes_max_in_flight = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interactive-reserved") == 0 && i + 1 < argc) {
+            lanes_reserved = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    if (employees <= 0 || window_s < 0.0 || interval_s <= 0.0 || workers <= 0 || latency_ms < 0 ||
+        error_rate < 0.0 || error_rate > 1.0) {
+        fprintf(stderr, "Employees, workers and interval must be positive, error rate within 0..1\n");
+        return -1;
+    }
+
+    memset(&config, 0, sizeof(config));
+    memset(&holder, 0, sizeof(holder));
+    if (orangehrm_client_init() != 0) {
+        return -1;
+    }
+    if (config_path != NULL) {
+        if (load_config_file(&config, config_path) != 0) {
+            goto cleanup;
+        }
+    } else {
+        server = standin_server_start(0, latency_ms, error_rate, seed);
+        if (server == NULL) {
+            goto cleanup;
+        }
+        snprintf(base_url, sizeof(base_url), "http://127.0.0.1:%d", standin_server_port(server));
+        config.base_url = mem_strdup(MEM_CONFIG, base_url);
+        config.client_id = mem_strdup(MEM_CONFIG, "loadgen");
+        config.client_secret = mem_strdup(MEM_CONFIG, "loadgen");
+        config.type = mem_strdup(MEM_CONFIG, "client_credentials");
+        if (config.base_url == NULL || config.client_id == NULL || config.client_secret == NULL ||
+            config.type == NULL) {
+            fprintf(stderr, "Memory allocation failed for load generator config\n");
+            goto cleanup;
+        }
+    }
+
+    if (timeout_ms != 0) {
+        config.transport_options.request_timeout_ms = timeout_ms;
+    }
+    if (max_host_connections != 0) {
+        config.transport_options.max_host_connections = max_host_connections;
+    }
+    if (connection_pool_size != 0) {
+        config.transport_options.connection_pool_size = connection_pool_size;
+    }
+    if (orangehrm_set_default_transport_options(&config.transport_options) != 0) {
+        goto cleanup;
+    }
+    if (memory_budget_kb != 0) {
+        config.memory_budget_kb = memory_budget_kb;
+    }
+    if (config.memory_budget_kb > 0) {
+        mem_budget_set((size_t)config.memory_budget_kb * 1024, MEM_DEFAULT_BUDGET_WAIT_MS);
+    }
+    if (lanes_max_in_flight != 0) {
+        config.lanes.max_in_flight = lanes_max_in_flight;
+    } else if (max_host_connections != 0) {
+        config.lanes.max_in_flight = max_host_connections;  /* As load_config derives it */
+    }
+    if (lanes_reserved != 0) {
+        config.lanes.interactive_reserved = lanes_reserved;
+    }
+    request_lanes_configure(&config.lanes);
+
+    /* Schedule every virtual employee's punch out */
+    punches = (VirtualPunch *)calloc((size_t)employees, sizeof(VirtualPunch));
+    if (punches == NULL || bounded_queue_init(&queue, (size_t)employees) != 0) {
+        fprintf(stderr, "Failed to allocate %ld virtual employees\n", employees);
+        free(punches);
+        punches = NULL;
+        goto cleanup;
+    }
+    for (long i = 0; i < employees; i++) {
+        punches[i].emp_number = LOADGEN_FIRST_EMP_NUMBER + (int)i;
+        punches[i].arrival_ns = (unsigned long long)(arrival_fraction(curve, &seed) * window_s * 1e9);
+    }
+    qsort(punches, (size_t)employees, sizeof(VirtualPunch), compare_arrival);
+
+    if (token_holder_start(&holder, &config) != 0) {
+        goto free_queue;
+    }
+    config.token_holder = &holder;
+    if (token_holder_wait(&holder, LOADGEN_TOKEN_WAIT_MS) != 0) {
+        fprintf(stderr, "No access token from %s\n", config.base_url);
+        goto stop_holder;
+    }
+
+    if (batch_options.max_size > 0) {
+        batcher = attendance_batcher_create(&config, &batch_options);
+        if (batcher == NULL) {
+            goto stop_holder;
+        }
+    }
+
+    threads = (pthread_t *)calloc((size_t)workers, sizeof(pthread_t));
+    if (threads == NULL) {
+        fprintf(stderr, "Failed to allocate worker threads\n");
+        goto stop_holder;
+    }
+    fprintf(stderr, "%ld employees, %s curve over %.1f s, %d workers, target %s\n", employees,
+            CURVE_NAMES[curve], window_s, workers, config.base_url);
+
+    worker.config = &config;
+    worker.batcher = batcher;
+    worker.queue = &queue;
+    worker.start_ns = monotonic_ns();
+    for (int t = 0; t < workers; t++) {
+        if (pthread_create(&threads[t], NULL, load_worker, &worker) != 0) {
+            fprintf(stderr, "Error creating load worker\n");
+            break;
+        }
+        started++;
+    }
+
+    atomic_init(&background_load.stop, 0);
+    atomic_init(&background_load.requests, 0);
+    background_load.config = &config;
+    if (background > 0) {
+        background_threads = (pthread_t *)calloc((size_t)background, sizeof(pthread_t));
+    }
+    for (int t = 0; background_threads != NULL && t < background; t++) {
+        if (pthread_create(&background_threads[t], NULL, background_worker, &background_load) != 0) {
+            fprintf(stderr, "Error creating background worker\n");
+            break;
+        }
+        background_started++;
+    }
+
+    /* Release each punch out at its scheduled time */
+    for (long i = 0; i < employees && started > 0; i++) {
+        sleep_until_ns(worker.start_ns + punches[i].arrival_ns);
+        bounded_queue_push(&queue, &punches[i], NULL);
+    }
+    bounded_queue_close(&queue);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    double elapsed_s = (double)(monotonic_ns() - worker.start_ns) / 1e9;
+    free(threads);
+    atomic_store(&background_load.stop, 1);
+    for (int t = 0; t < background_started; t++) {
+        pthread_join(background_threads[t], NULL);
+    }
+    free(background_threads);
+
+    if (started > 0) {
+        unsigned long long service_us_total = 0;
+        for (long i = 0; i < employees; i++) {
+            service_us_total += punches[i].service_us;
+        }
+        report(punches, (size_t)employees, interval_s, elapsed_s, service_us_total);
+        if (batcher != NULL) {
+            BatchStats stats;
+            attendance_batcher_stats(batcher, &stats);
+            printf("batches: %llu (%llu full, mean %.1f records), %llu bulk requests, %llu single requests\n",
+                   stats.batches, stats.full_flushes,
+                   stats.batches > 0 ? (double)stats.records / (double)stats.batches : 0.0,
+                   stats.bulk_requests, stats.single_requests);
+        }
+        if (background_started > 0) {
+            printf("background: %llu bulk-lane requests (%.1f per s)\n", atomic_load(&background_load.requests),
+                   (double)atomic_load(&background_load.requests) / elapsed_s);
+        }
+        for (int lane = 0; lane < REQUEST_PRIORITY_COUNT; lane++) {
+            LaneStats stats;
+            request_lanes_stats((RequestPriority)lane, &stats);
+            printf("lane %-11s %10llu admitted, wait ms: mean %.2f  max %.2f\n",
+                   request_priority_name((RequestPriority)lane), stats.admitted,
+                   stats.admitted > 0 ? (double)stats.wait_ns / (double)stats.admitted / 1e6 : 0.0,
+                   (double)stats.max_wait_ns / 1e6);
+        }
+        printf("\n");
+        mem_report(stdout);
+        result = 0;
+    }
+    if (server != NULL) {
+        fprintf(stderr, "Stand-in server answered %llu requests over %llu connections\n",
+                standin_server_request_count(server), standin_server_connection_count(server));
+    }
+
+stop_holder:
+    attendance_batcher_destroy(batcher);
+    token_holder_stop(&holder);
+    config.token_holder = NULL;
+free_queue:
+    bounded_queue_free(&queue);
+cleanup:
+    free(punches);
+    config_free(&config);
+    orangehrm_client_cleanup();
+    standin_server_stop(server);
+    return result;
+}
@@ -0,0 +1,197 @@
+#include "attendance_store.h"
+#include "attendance_aggregate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PUNCH_TEXT_SIZE 64  /* "YYYY-MM-DD HH:MM+HH:MM" with room for any int a struct tm field holds */
+
+/**
+ * Local attendance store queries:
+ * orangehrm_store [--dir DIR] [--emp N] [--from YYYY-MM-DD] [--to YYYY-MM-DD] [--hours]
+ *                 [--add-json FILE]
+ *
+ * Prints matching records as CSV (or per-day worked hours with --hours).
+ * --from and --to are local dates; --to is exclusive. --add-json appends the
+ * records of a saved attendance list response to the store first.
+ */
+
+static const char *SOURCE_NAMES[] = { "unknown", "submitted", "imported", "fetched" };
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--dir DIR] [--emp N] [--from YYYY-MM-DD] [--to YYYY-MM-DD] [--hours] "
+                    "[--add-json FILE]\n", program);
+}
+
+/**
+ * Parse a local YYYY-MM-DD date to the epoch second of its midnight
+ */
+static int parse_date(const char *text, int64_t *out) {
+    struct tm tm;
+    int year, month, day;
+
+    if (sscanf(text, "%4d-%2d-%2d", &year, &month, &day) != 3) {
+        return -1;
+    }
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_isdst = -1;
+    time_t midnight = mktime(&tm);
+    if (midnight == (time_t)-1) {
+        return -1;
+    }
+    *out = (int64_t)midnight;
+    return 0;
+}
+
+/**
+ * Format a punch in its own UTC offset as "YYYY-MM-DD HH:MM+HH:MM"
+ */
+static void format_punch(int64_t when, int16_t offset, char *buffer, size_t size) {
+    struct tm tm;
+    time_t local = (time_t)(when + (int64_t)offset * 60);
+    int minutes = offset < 0 ? -offset : offset;
+
+    if (when == 0 || gmtime_r(&local, &tm) == NULL) {
+        snprintf(buffer, size, "%s", "");
+        return;
+    }
+    snprintf(buffer, size, "%04d-%02d-%02d %02d:%02d%c%02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+             tm.tm_mday, tm.tm_hour, tm.tm_min, offset < 0 ? '-' : '+', minutes / 60, minutes % 60);
+}
+
+static int print_record(const StoredAttendance *record, void *data) {
+    char punch_in[PUNCH_TEXT_SIZE], punch_out[PUNCH_TEXT_SIZE];
+    (void)data;
+
+    format_punch(record->punch_in, record->punch_in_offset, punch_in, sizeof(punch_in));
+    format_punch(record->punch_out, record->punch_out_offset, punch_out, sizeof(punch_out));
+    printf("%d,%s,%s,%s\n", (int)record->emp_number, punch_in, punch_out,
+           SOURCE_NAMES[record->source < 4 ? record->source : 0]);
+    return 0;
+}
+
+static int add_json(AttendanceStore *store, const char *path) {
+    AttendanceColumns columns;
+    FILE *file = fopen(path, "rb");
+    char *body = NULL;
+    long length;
+    int result = -1;
+
+    if (file == NULL) {
+        perror("Failed to open attendance list");
+        return -1;
+    }
+    attendance_columns_init(&columns);
+    if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0 ||
+        (body = (char *)malloc((size_t)length + 1)) == NULL ||
+        fread(body, 1, (size_t)length, file) != (size_t)length) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        goto cleanup;
+    }
+
+    int decoded = attendance_columns_decode(&columns, body, (size_t)length);
+    if (decoded < 0 || attendance_store_append_columns(store, &columns, STORE_SOURCE_FETCHED) != 0 ||
+        attendance_store_sync(store) != 0) {
+        fprintf(stderr, "Failed to add %s to the store\n", path);
+        goto cleanup;
+    }
+    fprintf(stderr, "Added %d records (%zu rejected)\n", decoded, columns.rejected);
+    result = 0;
+
+cleanup:
+    attendance_columns_free(&columns);
+    free(body);
+    fclose(file);
+    return result;
+}
+
+static int print_hours(AttendanceStore *store, int32_t emp_number, int64_t from, int64_t to) {
+    unsigned long long start = monotonic_ns();
+    AttendanceColumns columns;
+    WorkedHours hours;
+
+    attendance_columns_init(&columns);
+    if (attendance_store_query_columns(store, emp_number, from, to, &columns) < 0 ||
+        attendance_aggregate_hours(&columns, AGGREGATE_DEFAULT_DAILY_HOURS_S, 0, &hours) != 0) {
+        attendance_columns_free(&columns);
+        return -1;
+    }
+
+    printf("empNumber,day,records,workedHours,overtimeHours,overlaps,openRecords\n");
+    for (size_t i = 0; i < hours.count; i++) {
+        const WorkedDay *day = &hours.days[i];
+        time_t midnight = (time_t)day->day * 86400;
+        struct tm tm;
+        gmtime_r(&midnight, &tm);
+        printf("%d,%04d-%02d-%02d,%u,%.2f,%.2f,%u,%u\n", (int)day->emp_number, tm.tm_year + 1900,
+               tm.tm_mon + 1, tm.tm_mday, day->records, (double)day->worked_s / 3600.0,
+               (double)day->overtime_s / 3600.0, day->overlaps, day->open_records);
+    }
+
+    fprintf(stderr, "%zu records, %zu employee days in %.2f ms\n", columns.count, hours.count,
+            (double)(monotonic_ns() - start) / 1e6);
+    worked_hours_free(&hours);
+    attendance_columns_free(&columns);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    AttendanceStore store;
+    const char *directory = NULL;
+    const char *json_path = NULL;
+    int32_t emp_number = STORE_ANY_EMPLOYEE;
+    int64_t from = INT64_MIN;
+    int64_t to = INT64_MAX;
+    int hours = 0;
+    int result = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (strcmp(argv[i], "--emp") == 0 && i + 1 < argc) {
+            emp_number = (int32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc && parse_date(argv[i + 1], &from) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc && parse_date(argv[i + 1], &to) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--hours") == 0) {
+            hours = 1;
+        } else if (strcmp(argv[i], "--add-json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (attendance_store_open(&store, directory) != 0) {
+        return -1;
+    }
+    if (json_path != NULL && add_json(&store, json_path) != 0) {
+        attendance_store_close(&store);
+        return -1;
+    }
+
+    if (hours) {
+        result = print_hours(&store, emp_number, from, to);
+    } else {
+        unsigned long long start = monotonic_ns();
+        long matched = attendance_store_query(&store, emp_number, from, to, print_record, NULL);
+        result = matched < 0 ? -1 : 0;
+        fprintf(stderr, "%ld of %zu records matched in %.2f ms\n", matched, attendance_store_count(&store),
+                (double)(monotonic_ns() - start) / 1e6);
+    }
+
+    attendance_store_close(&store);
+    return result;
+}
@@ -0,0 +1,421 @@
+#include "standin_server.h"
+#include "orangehrm_client.h"
+#include "attendance_record.h"
+#include "json_scan.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define STANDIN_BACKLOG 1024
+#define STANDIN_REQUEST_MAX (1024 * 128)
+#define STANDIN_RESPONSE_MAX (1024 * 16)
+#define STANDIN_POLL_MS 100
+
+static const char TOKEN_RESPONSE[] =
+    "{\"access_token\":\"standin0123456789abcdef0123456789abcdef\","
+    "\"token_type\":\"Bearer\",\"expires_in\":3600,\"scope\":null}";
+
+static const char ATTENDANCE_RESPONSE[] =
+    "{\"success\":true,\"data\":{\"id\":1,\"state\":\"PUNCHED OUT\"}}";
+
+static const char ATTENDANCE_ERROR_RESPONSE[] =
+    "{\"success\":false,\"error\":{\"message\":\"Stand-in server error\"}}";
+
+static const char EMPLOYEE_RESPONSE[] = "{\"data\":[],\"meta\":{\"total\":0}}";
+
+static const char NOT_FOUND_RESPONSE[] = "{\"error\":{\"status\":\"404\",\"message\":\"Not Found\"}}";
+
+typedef struct StandinConnection {
+    struct StandinConnection *next;
+    int fd;
+    StandinServer *server;
+} StandinConnection;
+
+struct StandinServer {
+    int listen_fd;
+    int port;
+    int latency_ms;
+    unsigned int error_threshold;   /* error_rate scaled to the rand_r range */
+    unsigned int rng_state;         /* one sequence for all connections, so the rate holds as they churn */
+    pthread_mutex_t rng_mutex;
+    atomic_ullong requests;
+    atomic_ullong accepted;         /* connections accepted so far */
+    pthread_t acceptor;
+    int stopping;
+    int connection_count;
+    StandinConnection *connections;
+    pthread_mutex_t mutex;          /* connection list and stopping */
+    pthread_cond_t cond;            /* a connection closed */
+};
+
+static void sleep_ms(int ms) {
+    struct timespec delay;
+    delay.tv_sec = ms / 1000;
+    delay.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+static int write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return -1;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static int send_response(int fd, int status, const char *body) {
+    char head[256];
+    size_t length = strlen(body);
+    int head_length = snprintf(head, sizeof(head),
+                               "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+                               status, status == 200 ? "OK" : status == 404 ? "Not Found" : "Internal Server Error",
+                               length);
+    if (write_all(fd, head, (size_t)head_length) != 0) {
+        return -1;
+    }
+    return write_all(fd, body, length);
+}
+
+/**
+ * Decide whether to fail one attendance submission
+ */
+static int inject_error(StandinServer *server) {
+    if (server->error_threshold == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&server->rng_mutex);
+    unsigned int draw = (unsigned int)rand_r(&server->rng_state);
+    pthread_mutex_unlock(&server->rng_mutex);
+    return draw < server->error_threshold;
+}
+
+/**
+ * Content-Length of a request head (0 if absent)
+ */
+static long content_length(const char *head, const char *head_end) {
+    static const char NAME[] = "\r\nContent-Length:";
+    for (const char *p = head; p + sizeof(NAME) - 1 < head_end; p++) {
+        if (strncasecmp(p, NAME, sizeof(NAME) - 1) == 0) {
+            return strtol(p + sizeof(NAME) - 1, NULL, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Answer a bulk submission with one result per record of the request array
+ */
+static int bulk_response(StandinServer *server, const char *request, size_t request_length,
+                         char *out, size_t size) {
+    JsonSlice records;
+    JsonSlice record;
+    JsonIterator iterator;
+    size_t pos = 0;
+    int first = 1;
+    int rc;
+
+    if (json_scan_find(request, request_length, "", &records) != JSON_SCAN_FOUND ||
+        records.type != JSON_SCAN_ARRAY || json_scan_iter_init(&iterator, &records) != 0) {
+        return -1;
+    }
+    pos += (size_t)snprintf(out, size, "{\"data\":[");
+    while ((rc = json_scan_iter_next(&iterator, NULL, &record)) == JSON_SCAN_FOUND) {
+        int failed = inject_error(server);
+        pos += (size_t)snprintf(out + pos, size - pos, "%s%s", first ? "" : ",",
+                                failed ? ATTENDANCE_ERROR_RESPONSE : ATTENDANCE_RESPONSE);
+        first = 0;
+        if (pos >= size) {
+            return -1;  /* Too many records for one answer */
+        }
+    }
+    pos += (size_t)snprintf(out + pos, size - pos, "]}");
+    return rc == JSON_SCAN_NOT_FOUND && pos < size ? 0 : -1;
+}
+
+/**
+ * Pick the canned response for one request (bulk answers are built in scratch)
+ */
+static int route(StandinServer *server, const char *method, const char *path, const char *request,
+                 size_t request_length, char *scratch, const char **body) {
+    size_t path_length = strcspn(path, "?");
+
+    if (strcmp(method, "POST") == 0 && strncmp(path, TOKEN_URL, path_length) == 0 &&
+        path_length == strlen(TOKEN_URL)) {
+        *body = TOKEN_RESPONSE;
+        return 200;
+    }
+    if (strcmp(method, "POST") == 0 && strncmp(path, ATTENDANCE_RECORDS_URL, path_length) == 0 &&
+        path_length == strlen(ATTENDANCE_RECORDS_URL)) {
+        if (inject_error(server)) {
+            *body = ATTENDANCE_ERROR_RESPONSE;
+            return 500;
+        }
+        *body = ATTENDANCE_RESPONSE;
+        return 200;
+    }
+    if (strcmp(method, "POST") == 0 && strncmp(path, OHRM_CREATE_ATTENDANCE_RECORDS_PATH, path_length) == 0 &&
+        path_length == strlen(OHRM_CREATE_ATTENDANCE_RECORDS_PATH)) {
+        if (bulk_response(server, request, request_length, scratch, STANDIN_RESPONSE_MAX) != 0) {
+            *body = ATTENDANCE_ERROR_RESPONSE;
+            return 500;
+        }
+        *body = scratch;
+        return 200;
+    }
+    if (strcmp(method, "GET") == 0 && strncmp(path, OHRM_LIST_EMPLOYEES_PATH, path_length) == 0 &&
+        path_length == strlen(OHRM_LIST_EMPLOYEES_PATH)) {
+        *body = EMPLOYEE_RESPONSE;
+        return 200;
+    }
+    *body = NOT_FOUND_RESPONSE;
+    return 404;
+}
+
+/**
+ * Serve requests on one keep-alive connection until the peer closes it
+ */
+static void *connection_thread(void *data) {
+    StandinConnection *connection = (StandinConnection *)data;
+    StandinServer *server = connection->server;
+    char *buffer = (char *)malloc(STANDIN_REQUEST_MAX + 1);
+    char *scratch = (char *)malloc(STANDIN_RESPONSE_MAX);
+    size_t filled = 0;
+
+    while (buffer != NULL && scratch != NULL) {
+        buffer[filled] = '\0';
+        char *head_end = strstr(buffer, "\r\n\r\n");
+        if (head_end == NULL) {
+            if (filled == STANDIN_REQUEST_MAX) {
+                break;  /* Request head too large */
+            }
+            ssize_t received = recv(connection->fd, buffer + filled, STANDIN_REQUEST_MAX - filled, 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                break;
+            }
+            filled += (size_t)received;
+            continue;
+        }
+
+        long body_length = content_length(buffer, head_end);
+        size_t request_length = (size_t)(head_end + 4 - buffer) + (size_t)(body_length > 0 ? body_length : 0);
+        if (body_length < 0 || request_length > STANDIN_REQUEST_MAX) {
+            break;
+        }
+        while (filled < request_length) {
+            ssize_t received = recv(connection->fd, buffer + filled, request_length - filled, 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                goto done;
+            }
+            filled += (size_t)received;
+        }
+
+        char method[8];
+        char path[MAX_URL_SIZE];
+        const char *body;
+        if (sscanf(buffer, "%7s %511s", method, path) != 2) {
+            break;
+        }
+        const char *request = head_end + 4;
+        int status = route(server, method, path, request, (size_t)(buffer + request_length - request),
+                           scratch, &body);
+        if (server->latency_ms > 0) {
+            sleep_ms(server->latency_ms);
+        }
+        if (send_response(connection->fd, status, body) != 0) {
+            break;
+        }
+        atomic_fetch_add(&server->requests, 1);
+
+        /* Keep pipelined bytes of the next request */
+        memmove(buffer, buffer + request_length, filled - request_length);
+        filled -= request_length;
+    }
+
+done:
+    free(buffer);
+    free(scratch);
+    pthread_mutex_lock(&server->mutex);
+    for (StandinConnection **link = &server->connections; *link != NULL; link = &(*link)->next) {
+        if (*link == connection) {
+            *link = connection->next;
+            break;
+        }
+    }
+    close(connection->fd);
+    free(connection);
+    server->connection_count--;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->mutex);
+    return NULL;
+}
+
+static void *acceptor_thread(void *data) {
+    StandinServer *server = (StandinServer *)data;
+    struct pollfd pfd;
+
+    pfd.fd = server->listen_fd;
+    pfd.events = POLLIN;
+    for (;;) {
+        pthread_mutex_lock(&server->mutex);
+        int stopping = server->stopping;
+        pthread_mutex_unlock(&server->mutex);
+        if (stopping) {
+            break;
+        }
+        if (poll(&pfd, 1, STANDIN_POLL_MS) <= 0) {
+            continue;
+        }
+
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        atomic_fetch_add(&server->accepted, 1);
+
+        StandinConnection *connection = (StandinConnection *)calloc(1, sizeof(StandinConnection));
+        if (connection == NULL) {
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->server = server;
+
+        pthread_mutex_lock(&server->mutex);
+        connection->next = server->connections;
+        server->connections = connection;
+        server->connection_count++;
+        pthread_mutex_unlock(&server->mutex);
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread, connection) != 0) {
+            fprintf(stderr, "Error creating stand-in connection thread\n");
+            pthread_mutex_lock(&server->mutex);
+            server->connections = connection->next;  /* Still at the head: only the acceptor adds */
+            server->connection_count--;
+            pthread_mutex_unlock(&server->mutex);
+            close(fd);
+            free(connection);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+StandinServer *standin_server_start(int port, int latency_ms, double error_rate, unsigned int seed) {
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+    int one = 1;
+
+    StandinServer *server = (StandinServer *)calloc(1, sizeof(StandinServer));
+    if (server == NULL) {
+        fprintf(stderr, "Failed to allocate stand-in server\n");
+        return NULL;
+    }
+    server->latency_ms = latency_ms > 0 ? latency_ms : 0;
+    server->error_threshold = error_rate > 0.0 ? (unsigned int)((error_rate < 1.0 ? error_rate : 1.0) *
+                                                                ((double)RAND_MAX + 1.0)) : 0;
+    server->rng_state = seed;
+    atomic_init(&server->requests, 0);
+    atomic_init(&server->accepted, 0);
+    pthread_mutex_init(&server->rng_mutex, NULL);
+    pthread_mutex_init(&server->mutex, NULL);
+    pthread_cond_init(&server->cond, NULL);
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        perror("Failed to create stand-in socket");
+        goto fail;
+    }
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+    if (bind(server->listen_fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server->listen_fd, STANDIN_BACKLOG) != 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&address, &address_length) != 0) {
+        perror("Failed to listen for the stand-in server");
+        goto fail;
+    }
+    server->port = ntohs(address.sin_port);
+
+    if (pthread_create(&server->acceptor, NULL, acceptor_thread, server) != 0) {
+        fprintf(stderr, "Error creating stand-in acceptor thread\n");
+        goto fail;
+    }
+    return server;
+
+fail:
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+    }
+    pthread_mutex_destroy(&server->rng_mutex);
+    pthread_mutex_destroy(&server->mutex);
+    pthread_cond_destroy(&server->cond);
+    free(server);
+    return NULL;
+}
+
+int standin_server_port(const StandinServer *server) {
+    return server->port;
+}
+
+unsigned long long standin_server_request_count(StandinServer *server) {
+    return atomic_load(&server->requests);
+}
+
+unsigned long long standin_server_connection_count(StandinServer *server) {
+    return atomic_load(&server->accepted);
+}
+
+void standin_server_stop(StandinServer *server) {
+    if (server == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&server->mutex);
+    server->stopping = 1;
+    pthread_mutex_unlock(&server->mutex);
+    pthread_join(server->acceptor, NULL);
+    close(server->listen_fd);
+
+    /* Wake connection threads blocked in recv and wait for them to exit */
+    pthread_mutex_lock(&server->mutex);
+    for (StandinConnection *connection = server->connections; connection != NULL; connection = connection->next) {
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    while (server->connection_count > 0) {
+        pthread_cond_wait(&server->cond, &server->mutex);
+    }
+    pthread_mutex_unlock(&server->mutex);
+
+    pthread_mutex_destroy(&server->rng_mutex);
+    pthread_mutex_destroy(&server->mutex);
+    pthread_cond_destroy(&server->cond);
+    free(server);
+}
@@ -0,0 +1,45 @@
+#ifndef STANDIN_SERVER_H
+#define STANDIN_SERVER_H
+
+/**
+ * Minimal local stand-in for the OrangeHRM API, for load tests.
+ *
+ * Serves HTTP/1.1 with keep-alive on 127.0.0.1, one thread per connection.
+ * Answers the token endpoint, attendance submissions (single and bulk) and
+ * employee lists with canned JSON after a fixed service time; a share of
+ * attendance submissions can be failed with 500 (records of a bulk request
+ * fail one by one) to exercise error handling and the circuit breaker.
+ */
+typedef struct StandinServer StandinServer;
+
+/**
+ * Start listening and serving in the background
+ * @param port TCP port on 127.0.0.1, 0 to pick a free one
+ * @param latency_ms Service time added to every response
+ * @param error_rate Share of attendance submissions failed (0..1)
+ * @param seed Seed of the error draws, shared by all connections
+ * @return Server, NULL on failure
+ */
+StandinServer *standin_server_start(int port, int latency_ms, double error_rate, unsigned int seed);
+
+/**
+ * Port the server listens on
+ */
+int standin_server_port(const StandinServer *server);
+
+/**
+ * Number of requests answered so far
+ */
+unsigned long long standin_server_request_count(StandinServer *server);
+
+/**
+ * Number of connections accepted so far (requests / connections is the reuse ratio)
+ */
+unsigned long long standin_server_connection_count(StandinServer *server);
+
+/**
+ * Close the listener and all connections, then free the server
+ */
+void standin_server_stop(StandinServer *server);
+
+#endif /* STANDIN_SERVER_H */
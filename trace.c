@@ -0,0 +1,319 @@
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    const char *name;
+    unsigned long long ts_ns;
+    char phase;
+} TraceEvent;
+
+/**
+ * Events of one thread. Only the owning thread appends; the dump reads up
+ * to the published count. Buffers are never freed and at most
+ * TRACE_MAX_BUFFERS exist: a buffer whose thread exited is handed to the
+ * next new thread, after moving its events to the spill area.
+ */
+typedef struct TraceBuffer {
+    struct TraceBuffer *next;
+    long tid;
+    const char *thread_name;
+    int retired;                /* owning thread exited */
+    atomic_size_t count;
+    size_t dropped;
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+/* An event moved out of a retired buffer, with the thread it came from */
+typedef struct {
+    TraceEvent event;
+    long tid;
+    const char *thread_name;
+} SpillEvent;
+
+atomic_int g_trace_enabled = 0;
+
+static pthread_mutex_t g_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer *g_buffers = NULL;
+static int g_buffer_count = 0;
+static SpillEvent *g_spill = NULL;
+static size_t g_spill_count = 0;
+static size_t g_spill_dropped = 0;
+static atomic_size_t g_unbuffered_dropped = 0;  /* events of threads that got no buffer */
+static atomic_uint g_trace_session = 0;
+static char *g_trace_path = NULL;
+static unsigned long long g_trace_origin_ns = 0;
+static pthread_key_t g_trace_key;
+static pthread_once_t g_trace_once = PTHREAD_ONCE_INIT;
+static _Thread_local TraceBuffer *tls_buffer = NULL;
+static _Thread_local unsigned int tls_denied_session = 0;  /* session in which no buffer was free */
+
+static unsigned long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static void retire_buffer(void *value) {
+    pthread_mutex_lock(&g_trace_mutex);
+    ((TraceBuffer *)value)->retired = 1;
+    pthread_mutex_unlock(&g_trace_mutex);
+}
+
+static void make_trace_key(void) {
+    pthread_key_create(&g_trace_key, retire_buffer);
+}
+
+/**
+ * Move the events of a retired buffer to the spill area, dropping what
+ * does not fit (caller holds g_trace_mutex)
+ */
+static void spill_buffer(TraceBuffer *buffer) {
+    size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+
+    if (count > 0 && g_spill == NULL) {
+        g_spill = (SpillEvent *)malloc(TRACE_SPILL_EVENTS * sizeof(SpillEvent));
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (g_spill == NULL || g_spill_count == TRACE_SPILL_EVENTS) {
+            g_spill_dropped += count - i;
+            break;
+        }
+        SpillEvent *spilled = &g_spill[g_spill_count++];
+        spilled->event = buffer->events[i];
+        spilled->tid = buffer->tid;
+        spilled->thread_name = buffer->thread_name;
+    }
+    g_spill_dropped += buffer->dropped;
+    atomic_store(&buffer->count, 0);
+    buffer->dropped = 0;
+}
+
+/**
+ * Find or create the calling thread's buffer (once per thread)
+ * @return NULL if all TRACE_MAX_BUFFERS buffers belong to live threads
+ */
+static TraceBuffer *thread_buffer(void) {
+    TraceBuffer *buffer;
+    unsigned int session;
+
+    if (tls_buffer != NULL) {
+        return tls_buffer;
+    }
+    /* Do not take the lock on every event once the buffers ran out */
+    session = atomic_load_explicit(&g_trace_session, memory_order_relaxed);
+    if (tls_denied_session == session) {
+        return NULL;
+    }
+
+    pthread_once(&g_trace_once, make_trace_key);
+    pthread_mutex_lock(&g_trace_mutex);
+    TraceBuffer *retired = NULL;
+    for (buffer = g_buffers; buffer != NULL; buffer = buffer->next) {
+        if (buffer->retired) {
+            if (atomic_load(&buffer->count) == 0) {
+                break;
+            }
+            if (retired == NULL) {
+                retired = buffer;
+            }
+        }
+    }
+    if (buffer == NULL && g_buffer_count < TRACE_MAX_BUFFERS) {
+        buffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+        if (buffer != NULL) {
+            buffer->next = g_buffers;
+            g_buffers = buffer;
+            g_buffer_count++;
+        }
+    }
+    if (buffer == NULL && retired != NULL) {
+        spill_buffer(retired);
+        buffer = retired;
+    }
+    if (buffer != NULL) {
+        buffer->tid = (long)syscall(SYS_gettid);
+        buffer->thread_name = NULL;
+        buffer->retired = 0;
+        buffer->dropped = 0;
+        atomic_init(&buffer->count, 0);
+    }
+    pthread_mutex_unlock(&g_trace_mutex);
+
+    if (buffer != NULL) {
+        tls_buffer = buffer;
+        pthread_setspecific(g_trace_key, buffer);
+    } else {
+        tls_denied_session = session;
+    }
+    return buffer;
+}
+
+void trace_event(const char *name, char phase) {
+    TraceBuffer *buffer = thread_buffer();
+    if (buffer == NULL) {
+        atomic_fetch_add_explicit(&g_unbuffered_dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    size_t index = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+    if (index == TRACE_BUFFER_EVENTS) {
+        buffer->dropped++;
+        return;
+    }
+
+    TraceEvent *event = &buffer->events[index];
+    event->name = name;
+    event->phase = phase;
+    event->ts_ns = monotonic_ns();
+    atomic_store_explicit(&buffer->count, index + 1, memory_order_release);
+}
+
+void trace_set_thread_name(const char *name) {
+    if (!atomic_load_explicit(&g_trace_enabled, memory_order_relaxed)) {
+        return;
+    }
+    TraceBuffer *buffer = thread_buffer();
+    if (buffer != NULL) {
+        buffer->thread_name = name;
+    }
+}
+
+int trace_start(const char *path) {
+    if (path == NULL || *path == '\0') {
+        fprintf(stderr, "Invalid trace output path\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_trace_mutex);
+    if (g_trace_path != NULL) {
+        pthread_mutex_unlock(&g_trace_mutex);
+        fprintf(stderr, "Tracing already started\n");
+        return -1;
+    }
+    g_trace_path = strdup(path);
+    if (g_trace_path == NULL) {
+        pthread_mutex_unlock(&g_trace_mutex);
+        fprintf(stderr, "Memory allocation failed for trace path\n");
+        return -1;
+    }
+    g_trace_origin_ns = monotonic_ns();
+    /* Session numbers start at 1 so threads retry once buffers may be free again */
+    atomic_fetch_add(&g_trace_session, 1);
+    pthread_mutex_unlock(&g_trace_mutex);
+
+    atomic_store(&g_trace_enabled, 1);
+    return 0;
+}
+
+int trace_start_from_env(void) {
+    const char *path = getenv(TRACE_ENV);
+    if (path == NULL || *path == '\0') {
+        return 0;
+    }
+    return trace_start(path);
+}
+
+/**
+ * Write a JSON string literal (names are identifiers, but stay safe)
+ */
+static void write_json_string(FILE *file, const char *value) {
+    fputc('"', file);
+    for (const char *p = value; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', file);
+        }
+        if ((unsigned char)*p >= 0x20) {
+            fputc(*p, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void write_thread_name(FILE *file, int *first, long pid, long tid, const char *name) {
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":",
+            *first ? "" : ",\n", pid, tid);
+    write_json_string(file, name);
+    fputs("}}", file);
+    *first = 0;
+}
+
+static void write_event(FILE *file, int *first, long pid, long tid, const TraceEvent *event) {
+    /* Events from before trace_start (earlier session) are skipped */
+    if (event->ts_ns < g_trace_origin_ns) {
+        return;
+    }
+    fprintf(file, "%s{\"name\":", *first ? "" : ",\n");
+    write_json_string(file, event->name);
+    fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+            event->phase, (double)(event->ts_ns - g_trace_origin_ns) / 1000.0, pid, tid);
+    *first = 0;
+}
+
+int trace_stop(void) {
+    FILE *file;
+    int result = 0;
+    int first = 1;
+    size_t dropped;
+    long pid = (long)getpid();
+
+    if (!atomic_exchange(&g_trace_enabled, 0)) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_trace_mutex);
+    dropped = g_spill_dropped + atomic_exchange(&g_unbuffered_dropped, 0);
+
+    file = fopen(g_trace_path, "w");
+    if (file == NULL) {
+        perror("Failed to open trace file");
+        result = -1;
+    } else {
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+        /* Spilled events are grouped by the buffer they came from */
+        for (size_t i = 0; i < g_spill_count; i++) {
+            const SpillEvent *spilled = &g_spill[i];
+            if (spilled->thread_name != NULL && (i == 0 || g_spill[i - 1].tid != spilled->tid)) {
+                write_thread_name(file, &first, pid, spilled->tid, spilled->thread_name);
+            }
+            write_event(file, &first, pid, spilled->tid, &spilled->event);
+        }
+        for (TraceBuffer *buffer = g_buffers; buffer != NULL; buffer = buffer->next) {
+            size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+
+            /* A retired buffer with no events is a thread from an earlier session */
+            if (buffer->thread_name != NULL && !(buffer->retired && count == 0)) {
+                write_thread_name(file, &first, pid, buffer->tid, buffer->thread_name);
+            }
+            for (size_t i = 0; i < count; i++) {
+                write_event(file, &first, pid, buffer->tid, &buffer->events[i]);
+            }
+            dropped += buffer->dropped;
+
+            /* Empty the buffer for the next session */
+            atomic_store(&buffer->count, 0);
+            buffer->dropped = 0;
+        }
+        fputs("\n]}\n", file);
+
+        if (fclose(file) != 0) {
+            perror("Failed to write trace file");
+            result = -1;
+        }
+        if (dropped > 0) {
+            fprintf(stderr, "Trace buffers full, %zu events dropped\n", dropped);
+        }
+    }
+
+    g_spill_count = 0;
+    g_spill_dropped = 0;
+    free(g_trace_path);
+    g_trace_path = NULL;
+    pthread_mutex_unlock(&g_trace_mutex);
+    return result;
+}
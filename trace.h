@@ -0,0 +1,55 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+
+#define TRACE_ENV "ORANGEHRM_TRACE"     /* set to an output path to record a trace */
+#define TRACE_BUFFER_EVENTS 65536       /* events kept per thread, later ones are dropped */
+#define TRACE_MAX_BUFFERS 32            /* thread buffers alive at once, threads past it record nothing */
+#define TRACE_SPILL_EVENTS (4 * TRACE_BUFFER_EVENTS) /* events of exited threads kept until the dump */
+
+/* Fast check used by the macros so disabled tracing costs one relaxed load */
+extern atomic_int g_trace_enabled;
+
+/**
+ * Record the start / end of a span on the calling thread.
+ * name must be a string literal (only the pointer is stored).
+ * Begin and end must be paired on the same thread.
+ */
+#define TRACE_BEGIN(name) \
+    do { if (atomic_load_explicit(&g_trace_enabled, memory_order_relaxed)) trace_event((name), 'B'); } while (0)
+#define TRACE_END(name) \
+    do { if (atomic_load_explicit(&g_trace_enabled, memory_order_relaxed)) trace_event((name), 'E'); } while (0)
+
+/**
+ * Start recording; trace_stop() writes the trace to path
+ * @param path Output file for the Chrome trace-event JSON
+ * @return 0 on success, -1 on failure
+ */
+int trace_start(const char *path);
+
+/**
+ * Start recording if ORANGEHRM_TRACE names an output file
+ * @return 0 if tracing started or is not requested, -1 on failure
+ */
+int trace_start_from_env(void);
+
+/**
+ * Stop recording and write all thread buffers as Chrome trace-event JSON
+ * (open in Perfetto or chrome://tracing), then free them.
+ * Threads still running may lose events recorded during the dump.
+ * @return 0 on success or if tracing was not started, -1 on write failure
+ */
+int trace_stop(void);
+
+/**
+ * Name the calling thread in the trace (string literal)
+ */
+void trace_set_thread_name(const char *name);
+
+/**
+ * Append one event to the calling thread's buffer (use the macros)
+ */
+void trace_event(const char *name, char phase);
+
+#endif /* TRACE_H */
@@ -0,0 +1,169 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+
+/**
+ * Body sink, same contract as a CURL write callback
+ * (return the number of bytes consumed, anything else aborts)
+ */
+typedef size_t (*TransportWriteFn)(void *ptr, size_t size, size_t nmemb, void *userdata);
+
+/**
+ * Called once the response status and headers are known, before any body byte
+ * @param status HTTP status code
+ * @param content_length Body length, -1 if unknown
+ * @return 0 to continue, -1 to abort the transfer
+ */
+typedef int (*TransportHeadersFn)(void *userdata, long status, long long content_length);
+
+/**
+ * One HTTP exchange as seen by a transport
+ */
+typedef struct {
+    const char *method;             /* GET, POST, PUT, PATCH or DELETE */
+    const char *url;                /* full URL including base_url */
+    const char *path;               /* endpoint path relative to base_url */
+    const char *const *headers;     /* "Name: value" lines */
+    size_t header_count;
+    const char *body;               /* request body, NULL for none */
+    TransportWriteFn write_fn;      /* receives the response body */
+    void *write_data;
+    TransportHeadersFn headers_fn;  /* optional, called with status before the body */
+    void *headers_data;
+    long timeout_ms;                /* overrides the transport's request deadline, 0 keeps it, -1 for none */
+} TransportRequest;
+
+/**
+ * Outcome of an exchange
+ */
+typedef struct {
+    long status;                    /* HTTP status, 0 if no response arrived */
+} TransportResponse;
+
+#define TRANSPORT_DEFAULT_CONNECT_TIMEOUT_MS 10000
+#define TRANSPORT_DEFAULT_REQUEST_TIMEOUT_MS 30000
+#define TRANSPORT_DEFAULT_LOW_SPEED_LIMIT 64        /* bytes per second */
+#define TRANSPORT_DEFAULT_LOW_SPEED_TIME_S 15
+#define TRANSPORT_DEFAULT_KEEPALIVE_IDLE_S 60
+#define TRANSPORT_DEFAULT_KEEPALIVE_INTERVAL_S 15
+#define TRANSPORT_DEFAULT_HAPPY_EYEBALLS_MS 200
+#define TRANSPORT_DEFAULT_CONNECTION_POOL_SIZE 32
+
+/**
+ * Connection and deadline tuning applied to every request of a transport.
+ * Zero selects the TRANSPORT_DEFAULT_* value and a negative value switches
+ * the option off, so a zeroed struct gives bounded deadlines.
+ */
+typedef struct {
+    long connect_timeout_ms;        /* DNS, TCP and TLS setup */
+    long request_timeout_ms;        /* whole exchange, connect included */
+    long low_speed_limit;           /* abort a transfer slower than this many bytes/s ... */
+    long low_speed_time_s;          /* ... for this many seconds */
+    long keepalive_idle_s;          /* idle time before TCP keepalive probes (off disables keepalive) */
+    long keepalive_interval_s;      /* time between keepalive probes */
+    long happy_eyeballs_timeout_ms; /* head start of IPv6 before IPv4 is tried too */
+    int tcp_nodelay;                /* off lets Nagle's algorithm coalesce small writes */
+    int max_host_connections;       /* concurrent requests per host, 0 or negative for no limit */
+    int connection_pool_size;       /* open connections kept for reuse over all hosts (at least
+                                       max_host_connections; negative leaves libcurl's default of 5) */
+} TransportOptions;
+
+typedef struct Transport Transport;
+
+/**
+ * Transport vtable: every client request goes through perform()
+ */
+struct Transport {
+    const char *name;
+
+    /**
+     * Execute one request
+     * @return 0 if a response was received (any status), -1 on transport failure
+     */
+    int (*perform)(Transport *transport, const TransportRequest *request, TransportResponse *response);
+
+    /**
+     * Optional: resolve the host and open a connection to url ahead of the
+     * first request (NULL when the transport has nothing to warm up)
+     * @return 0 on success, -1 on failure
+     */
+    int (*warmup)(Transport *transport, const char *url);
+
+    /**
+     * Release the transport
+     */
+    void (*destroy)(Transport *transport);
+};
+
+/**
+ * Create a libcurl transport (the default). Requests share one connection
+ * pool, DNS cache and TLS session cache, so a warmed up or previously used
+ * connection is reused by the next request to the same host.
+ * @return New transport, NULL on failure
+ */
+Transport *curl_transport_create(void);
+
+/**
+ * Create a libcurl transport with explicit connection and deadline tuning
+ * @param options Options (copied), NULL for the defaults
+ * @return New transport, NULL on failure
+ */
+Transport *curl_transport_create_with_options(const TransportOptions *options);
+
+/**
+ * Copy the TLS sessions a curl transport holds for resumption, e.g. to
+ * persist them across process starts. Empty when libcurl is older than
+ * 8.12 or was built without session export.
+ * @param data Receives the serialized sessions (release with free()), NULL if none
+ * @param length Receives the size of data
+ * @return 0 on success, -1 on failure
+ */
+int curl_transport_export_tls_sessions(Transport *transport, unsigned char **data, size_t *length);
+
+/**
+ * Seed a curl transport's TLS session cache from curl_transport_export_tls_sessions()
+ * output, so the first connection to a known host resumes instead of doing
+ * a full handshake (expired sessions are skipped; no-op before libcurl 8.12)
+ * @return Number of sessions imported, -1 on failure
+ */
+int curl_transport_import_tls_sessions(Transport *transport, const unsigned char *data, size_t length);
+
+/**
+ * Create an in-process transport answering from a table of canned responses.
+ * Requests never leave the process and perform() makes no system calls, so
+ * it isolates the client's own CPU costs for benchmarks and profiling.
+ * @return New transport, NULL on failure
+ */
+Transport *loopback_transport_create(void);
+
+/**
+ * Register a canned response on a loopback transport (not thread safe,
+ * call before the transport is used)
+ * @param transport Transport created by loopback_transport_create()
+ * @param method HTTP method, NULL matches any
+ * @param path Endpoint path, matched without its query string
+ * @param status HTTP status to return
+ * @param body Response body (copied)
+ * @return 0 on success, -1 on failure
+ */
+int loopback_transport_add_route(Transport *transport, const char *method, const char *path,
+                                 long status, const char *body);
+
+/**
+ * Number of requests a loopback transport has answered
+ */
+unsigned long long loopback_transport_request_count(Transport *transport);
+
+/**
+ * Warm up a transport's connection to url (no-op if it has no warmup)
+ * @return 0 on success, -1 on failure
+ */
+int transport_warmup(Transport *transport, const char *url);
+
+/**
+ * Free a transport (NULL is ignored)
+ */
+void transport_destroy(Transport *transport);
+
+#endif /* TRANSPORT_H */
@@ -0,0 +1,607 @@
+#include "transport.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <curl/curl.h>
+
+#define CURL_DNS_CACHE_TIMEOUT_S 600
+#define CURL_HOST_SLOTS 32
+#define CURL_HOST_SIZE 256
+
+/**
+ * Requests in flight to one host (for max_host_connections)
+ */
+typedef struct {
+    char host[CURL_HOST_SIZE];  /* "host[:port]" as written in the URL */
+    int active;
+} HostSlot;
+
+/**
+ * libcurl transport (one easy handle per request, connections shared)
+ */
+typedef struct {
+    Transport base;
+    CURLSH *share;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+    TransportOptions options;   /* defaults resolved, negative means off */
+    HostSlot hosts[CURL_HOST_SLOTS];
+    pthread_mutex_t host_mutex;
+    pthread_cond_t host_released;
+} CurlTransport;
+
+/**
+ * Per-request state for the header callback
+ */
+typedef struct {
+    CURL *curl;
+    const TransportRequest *request;
+    int headers_done;
+} CurlExchange;
+
+/**
+ * CURL header callback: report status and length once the final header block ends
+ */
+static size_t header_callback(char *buffer, size_t size, size_t nitems, void *userdata) {
+    size_t length = size * nitems;
+    CurlExchange *exchange = (CurlExchange *)userdata;
+
+    if (exchange->headers_done || length > 2 || (buffer[0] != '\r' && buffer[0] != '\n')) {
+        return length;
+    }
+
+    long status = 0;
+    curl_easy_getinfo(exchange->curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status >= 100 && status < 200) {
+        return length;  /* Interim response, real headers follow */
+    }
+
+    curl_off_t content_length = -1;
+    curl_easy_getinfo(exchange->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length);
+    exchange->headers_done = 1;
+
+    if (exchange->request->headers_fn(exchange->request->headers_data, status, (long long)content_length) != 0) {
+        return 0;  /* Abort transfer */
+    }
+    return length;
+}
+
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    (void)handle;
+    (void)access;
+    pthread_mutex_lock(&((CurlTransport *)userptr)->locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    (void)handle;
+    pthread_mutex_unlock(&((CurlTransport *)userptr)->locks[data]);
+}
+
+static long option_or_default(long value, long fallback) {
+    return value != 0 ? value : fallback;
+}
+
+/**
+ * Copy the "host[:port]" part of url
+ */
+static void url_host(const char *url, char *host, size_t size) {
+    const char *start = strstr(url, "://");
+    start = start != NULL ? start + 3 : url;
+    size_t length = strcspn(start, "/?#");
+    if (length >= size) {
+        length = size - 1;
+    }
+    memcpy(host, start, length);
+    host[length] = '\0';
+}
+
+/**
+ * Wait until fewer than max_host_connections requests to url's host are in
+ * flight and count this one
+ * @param slot Receives the slot to release, NULL when no limit applies
+ * @return 0 on success, -1 if the deadline passed while waiting
+ */
+static int acquire_host(CurlTransport *transport, const char *url, long timeout_ms, HostSlot **slot) {
+    char host[CURL_HOST_SIZE];
+    HostSlot *found = NULL;
+    struct timespec deadline;
+    int result = 0;
+
+    *slot = NULL;
+    if (transport->options.max_host_connections <= 0) {
+        return 0;
+    }
+    url_host(url, host, sizeof(host));
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&transport->host_mutex);
+    for (;;) {
+        HostSlot *idle = NULL;
+        found = NULL;
+        for (int i = 0; i < CURL_HOST_SLOTS && found == NULL; i++) {
+            if (strcmp(transport->hosts[i].host, host) == 0) {
+                found = &transport->hosts[i];
+            } else if (idle == NULL && transport->hosts[i].active == 0) {
+                idle = &transport->hosts[i];
+            }
+        }
+        if (found == NULL && idle != NULL) {
+            found = idle;
+            snprintf(found->host, sizeof(found->host), "%s", host);
+        }
+        if (found == NULL || found->active < transport->options.max_host_connections) {
+            break;  /* Table full of busy hosts: do not limit rather than stall */
+        }
+        int rc = timeout_ms > 0
+               ? pthread_cond_timedwait(&transport->host_released, &transport->host_mutex, &deadline)
+               : pthread_cond_wait(&transport->host_released, &transport->host_mutex);
+        if (rc == ETIMEDOUT) {
+            found = NULL;
+            result = -1;
+            break;
+        }
+    }
+    if (found != NULL) {
+        found->active++;
+    }
+    pthread_mutex_unlock(&transport->host_mutex);
+
+    if (result != 0) {
+        fprintf(stderr, "Timed out waiting for a connection to %s\n", host);
+    }
+    *slot = found;
+    return result;
+}
+
+static void release_host(CurlTransport *transport, HostSlot *slot) {
+    if (slot == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&transport->host_mutex);
+    slot->active--;
+    pthread_cond_broadcast(&transport->host_released);  /* Waiters may want different hosts */
+    pthread_mutex_unlock(&transport->host_mutex);
+}
+
+/**
+ * Create an easy handle attached to the transport's shared caches, with the
+ * transport's connection tuning applied
+ */
+static CURL *new_handle(CurlTransport *transport) {
+    const TransportOptions *options = &transport->options;
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        fprintf(stderr, "Failed to initialize CURL\n");
+        return NULL;
+    }
+
+    if (transport->share != NULL) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, transport->share);
+    }
+    curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, (long)CURL_DNS_CACHE_TIMEOUT_S);
+
+    /* The pool limit applies as each handle hands its connection back; below the
+       number of concurrent requests it closes connections instead of keeping them */
+    if (options->connection_pool_size > 0) {
+        curl_easy_setopt(curl, CURLOPT_MAXCONNECTS, (long)options->connection_pool_size);
+    }
+
+    /* Timeouts must not use signals in a multithreaded client */
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (options->connect_timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, options->connect_timeout_ms);
+    }
+    if (options->request_timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, options->request_timeout_ms);
+    }
+    if (options->low_speed_limit > 0 && options->low_speed_time_s > 0) {
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, options->low_speed_limit);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, options->low_speed_time_s);
+    }
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, options->tcp_nodelay > 0 ? 1L : 0L);
+    if (options->keepalive_idle_s > 0) {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, options->keepalive_idle_s);
+        if (options->keepalive_interval_s > 0) {
+            curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, options->keepalive_interval_s);
+        }
+    } else {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 0L);
+    }
+#if LIBCURL_VERSION_NUM >= 0x073b00  /* 7.59.0 */
+    if (options->happy_eyeballs_timeout_ms > 0) {
+        curl_easy_setopt(curl, CURLOPT_HAPPY_EYEBALLS_TIMEOUT_MS, options->happy_eyeballs_timeout_ms);
+    }
+#endif
+    return curl;
+}
+
+static int set_method(CURL *curl, const char *method, int has_body) {
+    if (strcmp(method, "GET") == 0) {
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    } else if (strcmp(method, "POST") == 0) {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        if (!has_body) {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+        }
+    } else if (strcmp(method, "PUT") == 0) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    } else if (strcmp(method, "PATCH") == 0) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
+    } else if (strcmp(method, "DELETE") == 0) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    } else {
+        fprintf(stderr, "Unknown HTTP method: %s\n", method);
+        return -1;
+    }
+    return 0;
+}
+
+static int curl_perform(Transport *transport, const TransportRequest *request, TransportResponse *response) {
+    CurlTransport *curl_transport = (CurlTransport *)transport;
+    CURL *curl = NULL;
+    struct curl_slist *headers = NULL;
+    CurlExchange exchange;
+    HostSlot *slot = NULL;
+    int result = -1;
+    long timeout_ms = request->timeout_ms != 0 ? request->timeout_ms : curl_transport->options.request_timeout_ms;
+
+    response->status = 0;
+
+    if (acquire_host(curl_transport, request->url, timeout_ms, &slot) != 0) {
+        return -1;
+    }
+    curl = new_handle(curl_transport);
+    if (!curl) {
+        release_host(curl_transport, slot);
+        return -1;
+    }
+    if (request->timeout_ms != 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms > 0 ? timeout_ms : 0L);
+    }
+
+    for (size_t i = 0; i < request->header_count; i++) {
+        struct curl_slist *appended = curl_slist_append(headers, request->headers[i]);
+        if (appended == NULL) {
+            fprintf(stderr, "Failed to create headers\n");
+            goto cleanup;
+        }
+        headers = appended;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, request->url);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, request->write_fn);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, request->write_data);
+
+    if (request->headers_fn != NULL) {
+        memset(&exchange, 0, sizeof(exchange));
+        exchange.curl = curl;
+        exchange.request = request;
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &exchange);
+    }
+
+    if (request->body != NULL) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->body);
+    }
+    if (set_method(curl, request->method, request->body != NULL) != 0) {
+        goto cleanup;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    /* Perform the request */
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response->status);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "%s request failed: %s\n", request->method, curl_easy_strerror(res));
+        goto cleanup;
+    }
+
+    result = 0;  /* Success */
+
+cleanup:
+    curl_easy_cleanup(curl);
+    release_host(curl_transport, slot);
+    if (headers) {
+        curl_slist_free_all(headers);
+    }
+    return result;
+}
+
+/**
+ * Open a connection into the shared pool with a HEAD request (any status will do)
+ */
+static int curl_warmup(Transport *transport, const char *url) {
+    CurlTransport *curl_transport = (CurlTransport *)transport;
+    HostSlot *slot;
+
+    if (acquire_host(curl_transport, url, curl_transport->options.request_timeout_ms, &slot) != 0) {
+        return -1;
+    }
+    CURL *curl = new_handle(curl_transport);
+    if (!curl) {
+        release_host(curl_transport, slot);
+        return -1;
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "Connection warm-up failed: %s\n", curl_easy_strerror(res));
+    }
+
+    curl_easy_cleanup(curl);
+    release_host(curl_transport, slot);
+    return res == CURLE_OK ? 0 : -1;
+}
+
+static void curl_destroy(Transport *transport) {
+    CurlTransport *curl_transport = (CurlTransport *)transport;
+
+    if (curl_transport->share != NULL) {
+        curl_share_cleanup(curl_transport->share);
+    }
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&curl_transport->locks[i]);
+    }
+    pthread_mutex_destroy(&curl_transport->host_mutex);
+    pthread_cond_destroy(&curl_transport->host_released);
+    free(curl_transport);
+}
+
+#if LIBCURL_VERSION_NUM >= 0x080c00  /* 8.12.0: curl_easy_ssls_export/import */
+/**
+ * Growing buffer of exported session records
+ */
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} SessionBlob;
+
+static int blob_append(SessionBlob *blob, const void *data, size_t length) {
+    if (blob->length + length > blob->capacity) {
+        size_t capacity = blob->capacity != 0 ? blob->capacity : 1024;
+        while (blob->length + length > capacity) {
+            capacity *= 2;
+        }
+        unsigned char *grown = (unsigned char *)realloc(blob->data, capacity);
+        if (grown == NULL) {
+            return -1;
+        }
+        blob->data = grown;
+        blob->capacity = capacity;
+    }
+    if (length > 0) {
+        memcpy(blob->data + blob->length, data, length);
+        blob->length += length;
+    }
+    return 0;
+}
+
+static int blob_append_u64(SessionBlob *blob, unsigned long long value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    return blob_append(blob, bytes, sizeof(bytes));
+}
+
+static int blob_append_field(SessionBlob *blob, const void *data, size_t length) {
+    return blob_append_u64(blob, length) != 0 || blob_append(blob, data, length) != 0 ? -1 : 0;
+}
+
+static CURLcode export_session(CURL *handle, void *userptr, const char *session_key,
+                               const unsigned char *shmac, size_t shmac_len,
+                               const unsigned char *sdata, size_t sdata_len,
+                               curl_off_t valid_until, int ietf_tls_id, const char *alpn,
+                               size_t earlydata_max) {
+    SessionBlob *blob = (SessionBlob *)userptr;
+    (void)handle;
+    (void)ietf_tls_id;  /* Part of sdata */
+    (void)alpn;
+    (void)earlydata_max;
+
+    if (blob_append_field(blob, session_key, session_key != NULL ? strlen(session_key) : 0) != 0 ||
+        blob_append_field(blob, shmac, shmac_len) != 0 ||
+        blob_append_field(blob, sdata, sdata_len) != 0 ||
+        blob_append_u64(blob, (unsigned long long)valid_until) != 0) {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    return CURLE_OK;
+}
+
+/**
+ * Read one length-prefixed field of a session record
+ * @return 0 on success, -1 if the record is truncated
+ */
+static int blob_read_field(const unsigned char *data, size_t length, size_t *pos,
+                           const unsigned char **field, size_t *field_length) {
+    unsigned long long value = 0;
+    if (length - *pos < 8) {
+        return -1;
+    }
+    for (int i = 0; i < 8; i++) {
+        value |= (unsigned long long)data[*pos + i] << (8 * i);
+    }
+    *pos += 8;
+    if (field == NULL) {
+        *field_length = (size_t)value;
+        return 0;
+    }
+    if (value > length - *pos) {
+        return -1;
+    }
+    *field = data + *pos;
+    *field_length = (size_t)value;
+    *pos += (size_t)value;
+    return 0;
+}
+#endif
+
+int curl_transport_export_tls_sessions(Transport *transport, unsigned char **data, size_t *length) {
+    if (data == NULL || length == NULL) {
+        return -1;
+    }
+    *data = NULL;
+    *length = 0;
+    if (transport == NULL || transport->perform != curl_perform) {
+        fprintf(stderr, "Invalid parameters for curl_transport_export_tls_sessions\n");
+        return -1;
+    }
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    CurlTransport *curl_transport = (CurlTransport *)transport;
+    SessionBlob blob = { NULL, 0, 0 };
+    if (curl_transport->share == NULL) {
+        return 0;  /* Sessions died with their handles */
+    }
+    CURL *curl = new_handle(curl_transport);
+    if (curl == NULL) {
+        return -1;
+    }
+    CURLcode res = curl_easy_ssls_export(curl, export_session, &blob);
+    curl_easy_cleanup(curl);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "TLS session export failed: %s\n", curl_easy_strerror(res));
+        free(blob.data);
+        return -1;
+    }
+    *data = blob.data;
+    *length = blob.length;
+#endif
+    return 0;
+}
+
+int curl_transport_import_tls_sessions(Transport *transport, const unsigned char *data, size_t length) {
+    if (transport == NULL || transport->perform != curl_perform || (data == NULL && length > 0)) {
+        fprintf(stderr, "Invalid parameters for curl_transport_import_tls_sessions\n");
+        return -1;
+    }
+#if LIBCURL_VERSION_NUM >= 0x080c00
+    CurlTransport *curl_transport = (CurlTransport *)transport;
+    char key[CURL_HOST_SIZE * 2];
+    size_t pos = 0;
+    int imported = 0;
+    if (curl_transport->share == NULL || length == 0) {
+        return 0;
+    }
+    CURL *curl = new_handle(curl_transport);
+    if (curl == NULL) {
+        return -1;
+    }
+    while (pos < length) {
+        const unsigned char *session_key, *shmac, *sdata;
+        size_t key_length, shmac_length, sdata_length, valid_until;
+        if (blob_read_field(data, length, &pos, &session_key, &key_length) != 0 ||
+            blob_read_field(data, length, &pos, &shmac, &shmac_length) != 0 ||
+            blob_read_field(data, length, &pos, &sdata, &sdata_length) != 0 ||
+            blob_read_field(data, length, &pos, NULL, &valid_until) != 0) {
+            fprintf(stderr, "Truncated TLS session record, ignoring the rest\n");
+            break;
+        }
+        if (key_length >= sizeof(key) || (time_t)valid_until <= time(NULL)) {
+            continue;  /* Expired: the server would refuse to resume it */
+        }
+        memcpy(key, session_key, key_length);
+        key[key_length] = '\0';
+        if (curl_easy_ssls_import(curl, key_length > 0 ? key : NULL, shmac, shmac_length,
+                                  sdata, sdata_length) == CURLE_OK) {
+            imported++;
+        }
+    }
+    curl_easy_cleanup(curl);
+    return imported;
+#else
+    (void)data;
+    (void)length;
+    return 0;
+#endif
+}
+
+Transport *curl_transport_create(void) {
+    return curl_transport_create_with_options(NULL);
+}
+
+Transport *curl_transport_create_with_options(const TransportOptions *options) {
+    CurlTransport *transport = (CurlTransport *)calloc(1, sizeof(CurlTransport));
+    if (transport == NULL) {
+        fprintf(stderr, "Failed to allocate curl transport\n");
+        return NULL;
+    }
+
+    transport->base.name = "curl";
+    transport->base.perform = curl_perform;
+    transport->base.warmup = curl_warmup;
+    transport->base.destroy = curl_destroy;
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&transport->locks[i], NULL);
+    }
+    pthread_mutex_init(&transport->host_mutex, NULL);
+    pthread_cond_init(&transport->host_released, NULL);
+
+    /* Resolve defaults once so every handle gets the same settings */
+    if (options != NULL) {
+        transport->options = *options;
+    }
+    TransportOptions *resolved = &transport->options;
+    resolved->connect_timeout_ms = option_or_default(resolved->connect_timeout_ms,
+                                                     TRANSPORT_DEFAULT_CONNECT_TIMEOUT_MS);
+    resolved->request_timeout_ms = option_or_default(resolved->request_timeout_ms,
+                                                     TRANSPORT_DEFAULT_REQUEST_TIMEOUT_MS);
+    resolved->low_speed_limit = option_or_default(resolved->low_speed_limit, TRANSPORT_DEFAULT_LOW_SPEED_LIMIT);
+    resolved->low_speed_time_s = option_or_default(resolved->low_speed_time_s, TRANSPORT_DEFAULT_LOW_SPEED_TIME_S);
+    resolved->keepalive_idle_s = option_or_default(resolved->keepalive_idle_s, TRANSPORT_DEFAULT_KEEPALIVE_IDLE_S);
+    resolved->keepalive_interval_s = option_or_default(resolved->keepalive_interval_s,
+                                                       TRANSPORT_DEFAULT_KEEPALIVE_INTERVAL_S);
+    resolved->happy_eyeballs_timeout_ms = option_or_default(resolved->happy_eyeballs_timeout_ms,
+                                                            TRANSPORT_DEFAULT_HAPPY_EYEBALLS_MS);
+    resolved->tcp_nodelay = (int)option_or_default(resolved->tcp_nodelay, 1);
+    resolved->connection_pool_size = (int)option_or_default(resolved->connection_pool_size,
+                                                            TRANSPORT_DEFAULT_CONNECTION_POOL_SIZE);
+    if (resolved->connection_pool_size > 0 && resolved->connection_pool_size < resolved->max_host_connections) {
+        resolved->connection_pool_size = resolved->max_host_connections;
+    }
+
+    /* Without a share every request would pay DNS, TCP and TLS again */
+    transport->share = curl_share_init();
+    if (transport->share == NULL ||
+        curl_share_setopt(transport->share, CURLSHOPT_LOCKFUNC, share_lock) != CURLSHE_OK ||
+        curl_share_setopt(transport->share, CURLSHOPT_UNLOCKFUNC, share_unlock) != CURLSHE_OK ||
+        curl_share_setopt(transport->share, CURLSHOPT_USERDATA, transport) != CURLSHE_OK ||
+        curl_share_setopt(transport->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) != CURLSHE_OK ||
+        curl_share_setopt(transport->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) != CURLSHE_OK ||
+        curl_share_setopt(transport->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != CURLSHE_OK) {
+        fprintf(stderr, "Failed to set up shared curl caches, connections will not be reused\n");
+        if (transport->share != NULL) {
+            curl_share_cleanup(transport->share);
+            transport->share = NULL;
+        }
+    }
+    return &transport->base;
+}
+
+int transport_warmup(Transport *transport, const char *url) {
+    if (transport == NULL || url == NULL) {
+        return -1;
+    }
+    return transport->warmup != NULL ? transport->warmup(transport, url) : 0;
+}
+
+void transport_destroy(Transport *transport) {
+    if (transport != NULL && transport->destroy != NULL) {
+        transport->destroy(transport);
+    }
+}
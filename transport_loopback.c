@@ -0,0 +1,141 @@
+#include "transport.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOOPBACK_MAX_ROUTES 32
+#define LOOPBACK_CHUNK_SIZE 16384   /* same as CURL_MAX_WRITE_SIZE */
+#define LOOPBACK_NOT_FOUND 404
+
+static const char LOOPBACK_NOT_FOUND_BODY[] = "{\"error\":\"no loopback route\"}";
+
+typedef struct {
+    char *method;
+    char *path;
+    long status;
+    char *body;
+    size_t body_length;
+} LoopbackRoute;
+
+/**
+ * In-process transport with a fixed table of canned responses
+ */
+typedef struct {
+    Transport base;
+    LoopbackRoute routes[LOOPBACK_MAX_ROUTES];
+    int route_count;
+    atomic_ullong requests;
+} LoopbackTransport;
+
+static const LoopbackRoute *find_route(const LoopbackTransport *loopback, const char *method, const char *path) {
+    size_t path_length = strcspn(path, "?");
+
+    for (int i = 0; i < loopback->route_count; i++) {
+        const LoopbackRoute *route = &loopback->routes[i];
+        if (route->method != NULL && strcmp(route->method, method) != 0) {
+            continue;
+        }
+        if (strlen(route->path) == path_length && strncmp(route->path, path, path_length) == 0) {
+            return route;
+        }
+    }
+    return NULL;
+}
+
+static int loopback_perform(Transport *transport, const TransportRequest *request, TransportResponse *response) {
+    LoopbackTransport *loopback = (LoopbackTransport *)transport;
+    const LoopbackRoute *route = find_route(loopback, request->method, request->path);
+    const char *body = LOOPBACK_NOT_FOUND_BODY;
+    size_t length = sizeof(LOOPBACK_NOT_FOUND_BODY) - 1;
+    long status = LOOPBACK_NOT_FOUND;
+
+    atomic_fetch_add_explicit(&loopback->requests, 1, memory_order_relaxed);
+
+    if (route != NULL) {
+        body = route->body;
+        length = route->body_length;
+        status = route->status;
+    }
+
+    response->status = status;
+
+    if (request->headers_fn != NULL &&
+        request->headers_fn(request->headers_data, status, (long long)length) != 0) {
+        return -1;
+    }
+
+    /* Deliver in curl-sized chunks so sinks see the same call pattern */
+    for (size_t offset = 0; offset < length; offset += LOOPBACK_CHUNK_SIZE) {
+        size_t chunk = length - offset < LOOPBACK_CHUNK_SIZE ? length - offset : LOOPBACK_CHUNK_SIZE;
+        if (request->write_fn((void *)(body + offset), 1, chunk, request->write_data) != chunk) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void loopback_destroy(Transport *transport) {
+    LoopbackTransport *loopback = (LoopbackTransport *)transport;
+
+    for (int i = 0; i < loopback->route_count; i++) {
+        free(loopback->routes[i].method);
+        free(loopback->routes[i].path);
+        free(loopback->routes[i].body);
+    }
+    free(loopback);
+}
+
+Transport *loopback_transport_create(void) {
+    LoopbackTransport *loopback = (LoopbackTransport *)calloc(1, sizeof(LoopbackTransport));
+    if (loopback == NULL) {
+        fprintf(stderr, "Failed to allocate loopback transport\n");
+        return NULL;
+    }
+
+    loopback->base.name = "loopback";
+    loopback->base.perform = loopback_perform;
+    loopback->base.destroy = loopback_destroy;
+    atomic_init(&loopback->requests, 0);
+    return &loopback->base;
+}
+
+int loopback_transport_add_route(Transport *transport, const char *method, const char *path,
+                                 long status, const char *body) {
+    LoopbackTransport *loopback = (LoopbackTransport *)transport;
+
+    if (transport == NULL || transport->perform != loopback_perform || path == NULL) {
+        fprintf(stderr, "Invalid parameters for loopback_transport_add_route\n");
+        return -1;
+    }
+    if (loopback->route_count == LOOPBACK_MAX_ROUTES) {
+        fprintf(stderr, "Loopback route table is full\n");
+        return -1;
+    }
+
+    LoopbackRoute *route = &loopback->routes[loopback->route_count];
+    route->method = method != NULL ? strdup(method) : NULL;
+    route->path = strdup(path);
+    route->body = strdup(body != NULL ? body : "");
+    route->status = status;
+
+    if ((method != NULL && route->method == NULL) || route->path == NULL || route->body == NULL) {
+        fprintf(stderr, "Memory allocation failed for loopback route\n");
+        free(route->method);
+        free(route->path);
+        free(route->body);
+        memset(route, 0, sizeof(LoopbackRoute));
+        return -1;
+    }
+
+    route->body_length = strlen(route->body);
+    loopback->route_count++;
+    return 0;
+}
+
+unsigned long long loopback_transport_request_count(Transport *transport) {
+    if (transport == NULL || transport->perform != loopback_perform) {
+        return 0;
+    }
+    return atomic_load_explicit(&((LoopbackTransport *)transport)->requests, memory_order_relaxed);
+}